@@ -0,0 +1,526 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <Autolock.h>
+#include <Catalog.h>
+#include <algorithm>
+#include <cmath>
+#include "AlertEngine.h"
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "Alerts"
+
+/*
+ * Levels sorted by the value that fires them and by the value that re-arms
+ * them. The cursors count the levels at or below the last value, so a new
+ * value only visits the levels between the two.
+ */
+class AlertEngine::Crossings
+{
+public:
+	Crossings(int32 capacity)
+	: fUp(new Level[capacity]),
+	  fDown(new Level[capacity]),
+	  fCount(0),
+	  fUpIndex(0),
+	  fDownIndex(0)
+	{
+	}
+
+	~Crossings()
+	{
+		delete[] fUp;
+		delete[] fDown;
+	}
+
+	void MakeEmpty()
+	{
+		fCount = 0;
+		fUpIndex = fDownIndex = 0;
+	}
+
+	void Add(int32 rule, float trigger, float rearm)
+	{
+		fUp[fCount].value = trigger;
+		fUp[fCount].rule = rule;
+		fDown[fCount].value = rearm;
+		fDown[fCount].rule = rule;
+		fCount++;
+	}
+
+	// The next value is taken as rising from below every level
+	void Sort()
+	{
+		auto lower = [](const Level& a, const Level& b) { return a.value < b.value; };
+		std::sort(fUp, fUp + fCount, lower);
+		std::sort(fDown, fDown + fCount, lower);
+		fUpIndex = fDownIndex = 0;
+	}
+
+	// crossedUp() returns false to be called again for the same level
+	//	with the next value, if that is still above it.
+	template<typename Up, typename Down>
+	void Feed(float value, Up crossedUp, Down crossedDown)
+	{
+		while(fDownIndex > 0 && fDown[fDownIndex - 1].value > value)
+			crossedDown(fDown[--fDownIndex].rule);
+		while(fDownIndex < fCount && fDown[fDownIndex].value <= value)
+			fDownIndex++;
+
+		while(fUpIndex > 0 && fUp[fUpIndex - 1].value > value)
+			fUpIndex--;
+		while(fUpIndex < fCount && fUp[fUpIndex].value <= value) {
+			if(!crossedUp(fUp[fUpIndex].rule))
+				break;
+			fUpIndex++;
+		}
+	}
+private:
+	struct Level {
+		float	value;
+		int32	rule;
+	};
+
+	Level*	fUp;
+	Level*	fDown;
+	int32	fCount;
+	int32	fUpIndex;
+	int32	fDownIndex;
+};
+
+struct AlertEngine::DeviceState
+{
+	Crossings	temperature;	// threshold and sustained rules
+	Crossings	slope;
+	bool*		active;
+	bigtime_t*	lastFired;		// -1 before the first alert
+
+	// Pending sustained rules, a min-heap on deadline
+	int32*		heap;
+	int32*		heapIndex;		// position of each rule, -1 when absent
+	bigtime_t*	deadline;
+	int32		heapCount;
+
+	bigtime_t	slopeWhen[kAlertSlopeCapacity];
+	float		slopeValue[kAlertSlopeCapacity];
+	int32		slopeStart;
+	int32		slopeCount;
+
+	bool		resolved;
+	bool		reported[TEMPERATURE_COUNT];
+	float		references[TEMPERATURE_COUNT];
+
+	DeviceState(int32 rules)
+	: temperature(rules),
+	  slope(rules),
+	  active(new bool[rules]),
+	  lastFired(new bigtime_t[rules]),
+	  heap(new int32[rules]),
+	  heapIndex(new int32[rules]),
+	  deadline(new bigtime_t[rules]),
+	  heapCount(0),
+	  slopeStart(0),
+	  slopeCount(0),
+	  resolved(false)
+	{
+		for(int32 i = 0; i < rules; i++) {
+			active[i] = false;
+			lastFired[i] = -1;
+			heapIndex[i] = -1;
+		}
+		for(int32 i = 0; i < TEMPERATURE_COUNT; i++) {
+			reported[i] = false;
+			references[i] = 0;
+		}
+	}
+
+	~DeviceState()
+	{
+		delete[] active;
+		delete[] lastFired;
+		delete[] heap;
+		delete[] heapIndex;
+		delete[] deadline;
+	}
+
+	void PushDeadline(int32 rule, bigtime_t when)
+	{
+		deadline[rule] = when;
+		heap[heapCount] = rule;
+		heapIndex[rule] = heapCount;
+		SiftUp(heapCount++);
+	}
+
+	void RemoveDeadline(int32 rule)
+	{
+		int32 position = heapIndex[rule];
+		if(position < 0)
+			return;
+
+		heapIndex[rule] = -1;
+		if(position == --heapCount)
+			return;
+
+		int32 moved = heap[heapCount];
+		heap[position] = moved;
+		heapIndex[moved] = position;
+		SiftUp(position);
+		SiftDown(heapIndex[moved]);
+	}
+
+	void SiftUp(int32 position)
+	{
+		while(position > 0) {
+			int32 parent = (position - 1) / 2;
+			if(deadline[heap[parent]] <= deadline[heap[position]])
+				break;
+			Swap(parent, position);
+			position = parent;
+		}
+	}
+
+	void SiftDown(int32 position)
+	{
+		while(true) {
+			int32 smallest = position;
+			for(int32 child = position * 2 + 1; child <= position * 2 + 2; child++) {
+				if(child < heapCount && deadline[heap[child]] < deadline[heap[smallest]])
+					smallest = child;
+			}
+			if(smallest == position)
+				break;
+			Swap(smallest, position);
+			position = smallest;
+		}
+	}
+
+	void Swap(int32 a, int32 b)
+	{
+		std::swap(heap[a], heap[b]);
+		heapIndex[heap[a]] = a;
+		heapIndex[heap[b]] = b;
+	}
+};
+
+// #pragma mark - Public
+
+AlertEngine::AlertEngine()
+: fLock("Alert engine"),
+  fSlopeWindow(kDefaultAlertSlopeWindow)
+{
+}
+
+AlertEngine::~AlertEngine()
+{
+	for(auto& state : fStates)
+		delete state.second;
+}
+
+void
+AlertEngine::SetRules(const std::vector<AlertRule>& rules, bigtime_t slopeWindow)
+{
+	BAutolock lock(fLock);
+	fRules = rules;
+	fSlopeWindow = slopeWindow > 0 ? slopeWindow : kDefaultAlertSlopeWindow;
+
+	for(auto& state : fStates)
+		delete state.second;
+	fStates.clear();
+}
+
+int32
+AlertEngine::CountRules() const
+{
+	BAutolock lock(fLock);
+	return fRules.size();
+}
+
+bool
+AlertEngine::GetRule(int32 index, AlertRule* outRule) const
+{
+	BAutolock lock(fLock);
+	if(index < 0 || index >= (int32)fRules.size())
+		return false;
+
+	*outRule = fRules[index];
+	return true;
+}
+
+int32
+AlertEngine::Evaluate(int32 device, const ThermalSnapshot& snapshot,
+	AlertEvent* outEvents, int32 maxEvents)
+{
+	if(!snapshot.IsReported(TEMPERATURE_CURRENT))
+		return 0;
+
+	float value = snapshot.Temperature(TEMPERATURE_CURRENT);
+	bigtime_t when = snapshot.timestamp;
+	if(std::isnan(value))
+		return 0;
+
+	BAutolock lock(fLock);
+	if(fRules.empty())
+		return 0;
+
+	DeviceState* state = StateFor(device);
+	ResolveLevels(state, snapshot);
+
+	int32 count = 0;
+	float current = value;
+	auto crossedUp = [&](int32 rule) {
+		if(state->active[rule])
+			return true;
+
+		// Without room for the event the crossing is kept for the next
+		//	sample rather than lost; cooldowns still swallow it.
+		if(fRules[rule].kind == ALERT_SUSTAINED)
+			state->PushDeadline(rule, when + fRules[rule].duration);
+		else if(count == maxEvents)
+			return false;
+		else if(Fire(state, device, rule, current, when, &outEvents[count]))
+			count++;
+
+		state->active[rule] = true;
+		return true;
+	};
+	auto crossedDown = [&](int32 rule) {
+		state->active[rule] = false;
+		state->RemoveDeadline(rule);
+	};
+
+	state->temperature.Feed(value, crossedUp, crossedDown);
+
+	float slope = Slope(state, when, value);
+	if(!std::isnan(slope)) {
+		current = slope;
+		state->slope.Feed(slope, crossedUp, crossedDown);
+	}
+
+	// Sustained rules that stayed above their level long enough; those
+	//	without room stay due until the next sample.
+	while(count < maxEvents && state->heapCount > 0
+		&& state->deadline[state->heap[0]] <= when) {
+		int32 rule = state->heap[0];
+		state->RemoveDeadline(rule);
+		if(Fire(state, device, rule, value, when, &outEvents[count]))
+			count++;
+	}
+
+	return count;
+}
+
+void
+AlertEngine::RemoveDevice(int32 device)
+{
+	BAutolock lock(fLock);
+	auto found = fStates.find(device);
+	if(found == fStates.end())
+		return;
+
+	delete found->second;
+	fStates.erase(found);
+}
+
+/* static */
+status_t
+AlertEngine::RulesFromMessage(const BMessage* from, std::vector<AlertRule>* outRules,
+	bigtime_t* outSlopeWindow)
+{
+	if(!from || !outRules)
+		return B_BAD_VALUE;
+
+	outRules->clear();
+	BMessage archive;
+	for(int32 i = 0; from->FindMessage("rule", i, &archive) == B_OK; i++) {
+		AlertRule rule;
+		rule.name = archive.GetString("name", "");
+		rule.kind = static_cast<AlertKind>(archive.GetInt32("kind", ALERT_THRESHOLD));
+		rule.reference = static_cast<AlertReference>(archive.GetInt32("reference",
+			ALERT_ABSOLUTE));
+		rule.level = archive.GetFloat("level", 0.0f);
+		rule.hysteresis = std::max(archive.GetFloat("hysteresis", 0.0f), 0.0f);
+		rule.duration = std::max(archive.GetInt64("duration", 0), (int64)0);
+		rule.cooldown = std::max(archive.GetInt64("cooldown", 0), (int64)0);
+		if(rule.kind < 0 || rule.kind >= ALERT_KIND_COUNT
+			|| rule.reference < 0 || rule.reference >= ALERT_REFERENCE_COUNT)
+			continue;
+
+		outRules->push_back(rule);
+	}
+
+	if(outSlopeWindow)
+		*outSlopeWindow = from->GetInt64("slope window", kDefaultAlertSlopeWindow);
+
+	return B_OK;
+}
+
+/* static */
+status_t
+AlertEngine::RulesToMessage(const std::vector<AlertRule>& rules, bigtime_t slopeWindow,
+	BMessage* into)
+{
+	if(!into)
+		return B_BAD_VALUE;
+
+	into->MakeEmpty();
+	status_t status = into->AddInt64("slope window", slopeWindow);
+	for(size_t i = 0; i < rules.size() && status == B_OK; i++) {
+		const AlertRule& rule = rules[i];
+		BMessage archive;
+		archive.AddString("name", rule.name);
+		archive.AddInt32("kind", rule.kind);
+		archive.AddInt32("reference", rule.reference);
+		archive.AddFloat("level", rule.level);
+		archive.AddFloat("hysteresis", rule.hysteresis);
+		archive.AddInt64("duration", rule.duration);
+		archive.AddInt64("cooldown", rule.cooldown);
+		status = into->AddMessage("rule", &archive);
+	}
+
+	return status;
+}
+
+/* static */
+void
+AlertEngine::DefaultRules(BMessage* into)
+{
+	std::vector<AlertRule> rules;
+
+	AlertRule rule;
+	rule.name = B_TRANSLATE("Close to the critical temperature");
+	rule.kind = ALERT_THRESHOLD;
+	rule.reference = ALERT_CRITICAL;
+	rule.level = -5.0f;
+	rule.hysteresis = 3.0f;
+	rule.duration = 0;
+	rule.cooldown = 60000000;
+	rules.push_back(rule);
+
+	rule.name = B_TRANSLATE("Hot for a while");
+	rule.kind = ALERT_SUSTAINED;
+	rule.reference = ALERT_HOT;
+	rule.level = 0.0f;
+	rule.hysteresis = 2.0f;
+	rule.duration = 30000000;
+	rule.cooldown = 300000000;
+	rules.push_back(rule);
+
+	rule.name = B_TRANSLATE("Temperature rising quickly");
+	rule.kind = ALERT_SLOPE;
+	rule.reference = ALERT_ABSOLUTE;
+	rule.level = 1.0f;
+	rule.hysteresis = 0.5f;
+	rule.duration = 0;
+	rule.cooldown = 60000000;
+	rules.push_back(rule);
+
+	RulesToMessage(rules, kDefaultAlertSlopeWindow, into);
+}
+
+// #pragma mark - Private
+
+AlertEngine::DeviceState*
+AlertEngine::StateFor(int32 device)
+{
+	auto found = fStates.find(device);
+	if(found != fStates.end())
+		return found->second;
+
+	DeviceState* state = new DeviceState(fRules.size());
+	fStates[device] = state;
+	return state;
+}
+
+void
+AlertEngine::ResolveLevels(DeviceState* state, const ThermalSnapshot& snapshot)
+{
+	// Trip points hardly ever change, but when they do every level moves
+	const DeviceTemperature kReferences[] = { TEMPERATURE_HOT, TEMPERATURE_CRITICAL };
+	bool changed = !state->resolved;
+	for(DeviceTemperature which : kReferences) {
+		bool reported = snapshot.IsReported(which);
+		float value = reported ? snapshot.Temperature(which) : 0.0f;
+		if(reported != state->reported[which] || value != state->references[which]) {
+			state->reported[which] = reported;
+			state->references[which] = value;
+			changed = true;
+		}
+	}
+	if(!changed)
+		return;
+
+	state->resolved = true;
+	state->temperature.MakeEmpty();
+	state->slope.MakeEmpty();
+	for(size_t i = 0; i < fRules.size(); i++) {
+		const AlertRule& rule = fRules[i];
+		if(rule.kind == ALERT_SLOPE) {
+			state->slope.Add(i, rule.level, rule.level - rule.hysteresis);
+			continue;
+		}
+
+		DeviceTemperature which = rule.reference == ALERT_HOT ? TEMPERATURE_HOT
+			: rule.reference == ALERT_CRITICAL ? TEMPERATURE_CRITICAL : TEMPERATURE_INVALID;
+		if(which != TEMPERATURE_INVALID && !state->reported[which]) {
+			// Never fires, never re-arms
+			state->temperature.Add(i, HUGE_VALF, -HUGE_VALF);
+			continue;
+		}
+
+		float trigger = rule.level + (which != TEMPERATURE_INVALID ? state->references[which] : 0);
+		state->temperature.Add(i, trigger, trigger - rule.hysteresis);
+	}
+	state->temperature.Sort();
+	state->slope.Sort();
+
+	// The cursors start over, so does the state; cooldowns still apply
+	for(size_t i = 0; i < fRules.size(); i++) {
+		state->active[i] = false;
+		state->RemoveDeadline(i);
+	}
+}
+
+float
+AlertEngine::Slope(DeviceState* state, bigtime_t when, float value)
+{
+	int32 last = (state->slopeStart + state->slopeCount) % kAlertSlopeCapacity;
+	if(state->slopeCount == kAlertSlopeCapacity)
+		state->slopeStart = (state->slopeStart + 1) % kAlertSlopeCapacity;
+	else
+		state->slopeCount++;
+	state->slopeWhen[last] = when;
+	state->slopeValue[last] = value;
+
+	// Keep the oldest sample that still spans the window
+	while(state->slopeCount > 2) {
+		int32 next = (state->slopeStart + 1) % kAlertSlopeCapacity;
+		if(when - state->slopeWhen[next] < fSlopeWindow)
+			break;
+		state->slopeStart = next;
+		state->slopeCount--;
+	}
+
+	bigtime_t span = when - state->slopeWhen[state->slopeStart];
+	if(state->slopeCount < 2 || span < fSlopeWindow / 2)
+		return NAN;
+
+	return (value - state->slopeValue[state->slopeStart]) * 1000000.0f / span;
+}
+
+bool
+AlertEngine::Fire(DeviceState* state, int32 device, int32 rule, float value,
+	bigtime_t when, AlertEvent* outEvent)
+{
+	// Debounced per rule and device
+	bigtime_t last = state->lastFired[rule];
+	if(last >= 0 && when - last < fRules[rule].cooldown)
+		return false;
+
+	state->lastFired[rule] = when;
+	outEvent->device = device;
+	outEvent->rule = rule;
+	outEvent->value = value;
+	outEvent->when = when;
+	return true;
+}
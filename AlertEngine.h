@@ -0,0 +1,102 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef __ALERT_ENGINE__
+#define __ALERT_ENGINE__
+
+#include <Locker.h>
+#include <Message.h>
+#include <String.h>
+#include <SupportDefs.h>
+#include <map>
+#include <vector>
+#include "ThermalDevice.h"
+
+#define kDefaultAlertSlopeWindow	10000000	// ten seconds
+#define kAlertSlopeCapacity			256			// samples kept for the slope
+
+enum AlertKind {
+	ALERT_THRESHOLD = 0,	// at or above level
+	ALERT_SLOPE,			// rising at level degrees per second or faster
+	ALERT_SUSTAINED,		// at or above level for duration
+
+	ALERT_KIND_COUNT
+};
+
+enum AlertReference {
+	ALERT_ABSOLUTE = 0,		// level is in degrees Celsius
+	ALERT_HOT,				// level is added to the device's hot trip point
+	ALERT_CRITICAL,			// level is added to the device's critical trip point
+
+	ALERT_REFERENCE_COUNT
+};
+
+struct AlertRule
+{
+	BString			name;
+	AlertKind		kind;
+	AlertReference	reference;	// ignored by slope rules
+	float			level;
+	float			hysteresis;	// re-armed once below level - hysteresis
+	bigtime_t		duration;	// sustained rules only
+	bigtime_t		cooldown;	// least time between two alerts of the rule
+};
+
+struct AlertEvent
+{
+	int32			device;
+	int32			rule;		// index in the rule set
+	float			value;		// temperature, or slope for slope rules
+	bigtime_t		when;
+};
+
+/*
+ * Evaluates a set of alert rules against the samples of every device.
+ * The levels of each kind are kept sorted twice, by the value that fires
+ * them and by the value that re-arms them, with a cursor into each; a
+ * sample only walks the levels it crossed, so evaluation does not depend
+ * on how many rules there are. Sustained rules wait in a deadline heap.
+ * Per device state is allocated on its first sample; Evaluate() itself
+ * never allocates.
+ */
+class AlertEngine
+{
+public:
+						AlertEngine();
+						~AlertEngine();
+
+			// Forgets the state of every device
+			void		SetRules(const std::vector<AlertRule>& rules,
+							bigtime_t slopeWindow = kDefaultAlertSlopeWindow);
+			int32		CountRules() const;
+			bool		GetRule(int32 index, AlertRule* outRule) const;
+
+			// Writes at most maxEvents alerts and returns how many
+			int32		Evaluate(int32 device, const ThermalSnapshot& snapshot,
+							AlertEvent* outEvents, int32 maxEvents);
+			void		RemoveDevice(int32 device);
+
+	static	status_t	RulesFromMessage(const BMessage* from,
+							std::vector<AlertRule>* outRules,
+							bigtime_t* outSlopeWindow);
+	static	status_t	RulesToMessage(const std::vector<AlertRule>& rules,
+							bigtime_t slopeWindow, BMessage* into);
+	static	void		DefaultRules(BMessage* into);
+private:
+	class Crossings;
+	struct DeviceState;
+
+			DeviceState* StateFor(int32 device);
+			void		ResolveLevels(DeviceState* state, const ThermalSnapshot& snapshot);
+			float		Slope(DeviceState* state, bigtime_t when, float value);
+			bool		Fire(DeviceState* state, int32 device, int32 rule,
+							float value, bigtime_t when, AlertEvent* outEvent);
+private:
+	mutable BLocker		fLock;
+	std::vector<AlertRule> fRules;
+	bigtime_t			fSlopeWindow;
+	std::map<int32, DeviceState*> fStates;
+};
+
+#endif /* __ALERT_ENGINE__ */
@@ -1,4 +1,5 @@
 #include <Catalog.h>
+#include <Directory.h>
 #include <File.h>
 #include <FindDirectory.h>
 #include <Path.h>
@@ -6,8 +7,12 @@
 #include <Screen.h>
 #include <private/interface/AboutWindow.h>
 #include <cassert>
+#include <cmath>
+#include <vector>
 #include "App.h"
 #include "DataFactory.h"
+#include "DeviceRegistry.h"
+#include "Headless.h"
 #include "MainWindow.h"
 #include "TemperatureDefs.h"
 
@@ -39,9 +44,112 @@ static property_info kTemperatureProperties[] = {
 		.extra_data = 0,
 		.types      = { B_BOOL_TYPE }
 	},
+	{
+		.name       = "Statistics",
+		.commands   = { B_GET_PROPERTY, 0 },
+		.specifiers = { B_DIRECT_SPECIFIER, B_NAME_SPECIFIER, 0 },
+		.usage      = B_TRANSLATE("Rolling statistics of the current thermal device, "
+			"or of the one named by its path, in Celsius"),
+		.extra_data = 0,
+		.types      = { B_MESSAGE_TYPE }
+	},
+	{
+		.name       = "StatisticsWindow",
+		.commands   = { B_GET_PROPERTY, B_SET_PROPERTY, 0 },
+		.specifiers = { B_DIRECT_SPECIFIER, 0 },
+		.usage      = B_TRANSLATE("Length of the statistics window in seconds"),
+		.extra_data = 0,
+		.types      = { B_UINT32_TYPE }
+	},
+	{
+		.name       = "TimeToCritical",
+		.commands   = { B_GET_PROPERTY, 0 },
+		.specifiers = { B_DIRECT_SPECIFIER, 0 },
+		.usage      = B_TRANSLATE("Predicted seconds until the current thermal device "
+			"reaches its critical temperature, negative when it is not heading there"),
+		.extra_data = 0,
+		.types      = { B_MESSAGE_TYPE }
+	},
+	{
+		.name       = "RefreshInterval",
+		.commands   = { B_GET_PROPERTY, B_SET_PROPERTY, 0 },
+		.specifiers = { B_DIRECT_SPECIFIER, 0 },
+		.usage      = B_TRANSLATE("Sampling interval of the current thermal device "
+			"in microseconds, 100000 at least"),
+		.extra_data = 0,
+		.types      = { B_INT64_TYPE }
+	},
+	{
+		.name       = "SamplerMetrics",
+		.commands   = { B_GET_PROPERTY, 0 },
+		.specifiers = { B_DIRECT_SPECIFIER, 0 },
+		.usage      = B_TRANSLATE("Reads, missed deadlines and lateness of the current "
+			"thermal device's sampling"),
+		.extra_data = 0,
+		.types      = { B_MESSAGE_TYPE }
+	},
+	{
+		.name       = "History",
+		.commands   = { B_GET_PROPERTY, 0 },
+		.specifiers = { B_DIRECT_SPECIFIER, B_NAME_SPECIFIER, 0 },
+		.usage      = B_TRANSLATE("Recorded history of the current thermal device, or "
+			"of the one named by its path, as packed arrays. Optional int64 \"since\" "
+			"and \"until\" in system time, negative counting back from now, and "
+			"int32 \"resolution\": 0 raw, 1 minutes, 2 hours"),
+		.extra_data = 0,
+		.types      = { B_MESSAGE_TYPE }
+	},
+	{
+		.name       = "AllDevices",
+		.commands   = { B_GET_PROPERTY, 0 },
+		.specifiers = { B_DIRECT_SPECIFIER, 0 },
+		.usage      = B_TRANSLATE("Latest temperatures and statistics of every sampled "
+			"thermal device, as packed arrays"),
+		.extra_data = 0,
+		.types      = { B_MESSAGE_TYPE }
+	},
+	{
+		.name       = "Updates",
+		.commands   = { B_CREATE_PROPERTY, B_DELETE_PROPERTY, 0 },
+		.specifiers = { B_DIRECT_SPECIFIER, B_NAME_SPECIFIER, 0 },
+		.usage      = B_TRANSLATE("Subscribe to, or unsubscribe from, the temperatures "
+			"of the current thermal device or of the one named by its path. Optional "
+			"messenger \"target\", the sender by default, int64 \"interval\" in "
+			"microseconds and float \"delta\" in degrees: an update is sent once "
+			"interval has passed or the temperature moved by delta, every sample "
+			"with neither"),
+		.extra_data = 0,
+		.types      = { B_INT32_TYPE }
+	},
 	{ 0 }
 };
 
+#define kScriptingHistorySpan 60000000	// History without "since": the last minute
+
+// The whole array goes in a single item, so replies do not pay a field
+//	header per value; readers divide the item size by the value size.
+template<typename T>
+static void
+AddPacked(BMessage* into, const char* name, type_code type, const std::vector<T>& values)
+{
+	if(!values.empty())
+		into->AddData(name, type, values.data(), values.size() * sizeof(T));
+}
+
+static void
+AddSummary(BMessage* into, const RollingSummary& summary)
+{
+	into->AddUInt32("count", summary.count);
+	into->AddInt64("window", summary.window);
+	into->AddFloat("minimum", summary.minimum);
+	into->AddFloat("maximum", summary.maximum);
+	into->AddFloat("mean", summary.mean);
+	into->AddFloat("deviation", summary.deviation);
+	into->AddFloat("p50", summary.quantiles[QUANTILE_P50]);
+	into->AddFloat("p95", summary.quantiles[QUANTILE_P95]);
+	into->AddFloat("p99", summary.quantiles[QUANTILE_P99]);
+}
+
 App::App(void)
 	:	BApplication(kTemperatureMime),
 	dataRepository(NULL)
@@ -54,6 +162,8 @@ App::~App()
 {
 	if(dataRepository)
 		delete dataRepository;
+
+	DeviceRegistry::DeleteDefault();
 }
 
 void App::ReadyToRun()
@@ -87,6 +197,12 @@ void App::MessageReceived(BMessage* message)
 				break;
 			HandleScripting(message);
 			break;
+		case M_SAMPLES_SUBSCRIBE:
+		case M_SAMPLES_UNSUBSCRIBE:
+			// Replicants asking to share the samples of the sampler
+			if(mainwin)
+				mainwin->PostMessage(message);
+			break;
 		case B_ABOUT_REQUESTED:
 			AboutRequested();
 			break;
@@ -209,8 +325,22 @@ void App::HandleScripting(BMessage* message)
 						message->SendReply(&reply);
 						return;
 					}
-					ThermalDevice device(dataRepository->ActiveDevice());
-					reply.AddFloat("result", device.ReadTemperature());
+					// The sampler already read it, only ask the device when stopped
+					ThermalSnapshot snapshot;
+					status_t status = mainwin && mainwin->HasDevice()
+						? mainwin->GetLatestSnapshot(mainwin->DisplayedDevice(), &snapshot)
+						: B_NO_INIT;
+					if(status != B_OK) {
+						ThermalDevice device(dataRepository->ActiveDevice());
+						status = device.ReadSnapshot(&snapshot);
+					}
+					if(status != B_OK || !snapshot.IsReported(TEMPERATURE_CURRENT)) {
+						reply.what = B_MESSAGE_NOT_UNDERSTOOD;
+						reply.AddString("message", "Device did not report a temperature.\n");
+						message->SendReply(&reply);
+						return;
+					}
+					reply.AddFloat("result", snapshot.Temperature(TEMPERATURE_CURRENT));
 					message->SendReply(&reply);
 					return;
 				}
@@ -235,21 +365,304 @@ void App::HandleScripting(BMessage* message)
 				}
 				break;
 			}
+			case 3: // Statistics
+			{
+				if(message->what == B_GET_PROPERTY) {
+					RollingSummary summary;
+					int32 device = !mainwin ? -1 : what == B_NAME_SPECIFIER
+						? DeviceRegistry::Default()->FindDevice(specifier.GetString("name", ""))
+						: mainwin->DisplayedDevice();
+					if(device < 0 || mainwin->Statistics()->GetSummary(device, &summary) != B_OK) {
+						reply.what = B_MESSAGE_NOT_UNDERSTOOD;
+						reply.AddString("message", "No samples of the device yet.\n");
+						message->SendReply(&reply);
+						return;
+					}
+
+					BMessage result;
+					AddSummary(&result, summary);
+					reply.AddMessage("result", &result);
+					message->SendReply(&reply);
+					return;
+				}
+				break;
+			}
+			case 4: // StatisticsWindow
+			{
+				if(message->what == B_GET_PROPERTY) {
+					reply.AddUInt32("result", dataRepository->StatisticsWindow());
+					message->SendReply(&reply);
+					return;
+				}
+				else if(message->what == B_SET_PROPERTY) {
+					uint32 seconds = 0;
+					if(message->FindUInt32("data", &seconds) != B_OK || seconds == 0) {
+						reply.what = B_MESSAGE_NOT_UNDERSTOOD;
+						reply.AddString("message", "The window must be a positive number of seconds.\n");
+						message->SendReply(&reply);
+						return;
+					}
+					BMessage windowMessage(M_STATISTICS_WINDOW);
+					windowMessage.AddUInt32("seconds", seconds);
+					if(mainwin)
+						mainwin->PostMessage(&windowMessage);
+					else
+						dataRepository->SetStatisticsWindow(seconds);
+					return;
+				}
+				break;
+			}
+			case 5: // TimeToCritical
+			{
+				if(message->what == B_GET_PROPERTY) {
+					CriticalForecast forecast;
+					if(!mainwin || mainwin->GetForecast(&forecast) != B_OK) {
+						reply.what = B_MESSAGE_NOT_UNDERSTOOD;
+						reply.AddString("message", "Not enough samples of the current device yet.\n");
+						message->SendReply(&reply);
+						return;
+					}
+					if(std::isnan(forecast.critical)) {
+						reply.what = B_MESSAGE_NOT_UNDERSTOOD;
+						reply.AddString("message", "Device does not report a critical temperature.\n");
+						message->SendReply(&reply);
+						return;
+					}
+
+					BMessage result;
+					result.AddFloat("seconds", forecast.seconds);
+					result.AddFloat("slope", forecast.slope);
+					result.AddFloat("temperature", forecast.temperature);
+					result.AddFloat("critical", forecast.critical);
+					result.AddUInt32("count", forecast.count);
+					result.AddInt64("when", forecast.when);
+					reply.AddMessage("result", &result);
+					message->SendReply(&reply);
+					return;
+				}
+				break;
+			}
+			case 6: // RefreshInterval
+			{
+				if(message->what == B_GET_PROPERTY) {
+					reply.AddInt64("result",
+						dataRepository->DeviceRefreshInterval(dataRepository->ActiveDevice()));
+					message->SendReply(&reply);
+					return;
+				}
+				else if(message->what == B_SET_PROPERTY) {
+					bigtime_t interval = 0;
+					if(message->FindInt64("data", &interval) != B_OK
+						|| interval < kMinimumRefreshInterval) {
+						reply.what = B_MESSAGE_NOT_UNDERSTOOD;
+						reply.AddString("message", "The interval must be 100000 microseconds or more.\n");
+						message->SendReply(&reply);
+						return;
+					}
+					BMessage intervalMessage(M_REFRESH_RATE);
+					intervalMessage.AddInt64("interval", interval);
+					if(mainwin)
+						mainwin->PostMessage(&intervalMessage);
+					else
+						dataRepository->SetRefreshInterval(interval);
+					return;
+				}
+				break;
+			}
+			case 7: // SamplerMetrics
+			{
+				if(message->what == B_GET_PROPERTY) {
+					SamplerMetrics metrics;
+					if(!mainwin || mainwin->GetSamplerMetrics(&metrics) != B_OK) {
+						reply.what = B_MESSAGE_NOT_UNDERSTOOD;
+						reply.AddString("message", "Device not found or not initialized.\n");
+						message->SendReply(&reply);
+						return;
+					}
+
+					BMessage result;
+					result.AddUInt64("reads", metrics.reads);
+					result.AddUInt64("missed", metrics.missed);
+					result.AddInt64("interval", metrics.interval);
+					result.AddInt64("last lateness", metrics.lastLateness);
+					result.AddInt64("max lateness", metrics.maxLateness);
+					reply.AddMessage("result", &result);
+					message->SendReply(&reply);
+					return;
+				}
+				break;
+			}
+			case 8: // History
+			{
+				if(message->what == B_GET_PROPERTY) {
+					int32 device = !mainwin ? -1 : what == B_NAME_SPECIFIER
+						? DeviceRegistry::Default()->FindDevice(specifier.GetString("name", ""))
+						: mainwin->DisplayedDevice();
+					if(device < 0) {
+						reply.what = B_MESSAGE_NOT_UNDERSTOOD;
+						reply.AddString("message", "Device not found or not initialized.\n");
+						message->SendReply(&reply);
+						return;
+					}
+
+					bigtime_t now = system_time();
+					bigtime_t since = message->GetInt64("since", -kScriptingHistorySpan);
+					bigtime_t until = message->GetInt64("until", now);
+					if(since < 0)
+						since += now;
+					if(until < 0)
+						until += now;
+
+					HistoryStore* history = mainwin->History();
+					int32 resolution = message->GetInt32("resolution",
+						history->BestResolution(device, since));
+					if(resolution < 0 || resolution >= HISTORY_RESOLUTION_COUNT
+						|| until < since) {
+						reply.what = B_MESSAGE_NOT_UNDERSTOOD;
+						reply.AddString("message", "Invalid resolution or time range.\n");
+						message->SendReply(&reply);
+						return;
+					}
+
+					HistoryResolution tier = static_cast<HistoryResolution>(resolution);
+					std::vector<HistoryPoint> points;
+					size_t count = history->Query(device, tier, since, &points);
+
+					std::vector<bigtime_t> times;
+					std::vector<float> minimums, maximums, means;
+					std::vector<uint32> counts;
+					times.reserve(count);
+					minimums.reserve(count);
+					maximums.reserve(count);
+					means.reserve(count);
+					counts.reserve(count);
+					for(size_t i = 0; i < count && points[i].timestamp <= until; i++) {
+						times.push_back(points[i].timestamp);
+						minimums.push_back(points[i].minimum);
+						maximums.push_back(points[i].maximum);
+						means.push_back(points[i].mean);
+						counts.push_back(points[i].count);
+					}
+
+					BMessage result;
+					result.AddInt32("resolution", resolution);
+					result.AddInt64("bucket", HistoryStore::BucketLength(tier));
+					result.AddInt32("points", times.size());
+					AddPacked(&result, "when", B_INT64_TYPE, times);
+					AddPacked(&result, "minimum", B_FLOAT_TYPE, minimums);
+					AddPacked(&result, "maximum", B_FLOAT_TYPE, maximums);
+					AddPacked(&result, "mean", B_FLOAT_TYPE, means);
+					AddPacked(&result, "count", B_UINT32_TYPE, counts);
+					reply.AddMessage("result", &result);
+					message->SendReply(&reply);
+					return;
+				}
+				break;
+			}
+			case 9: // AllDevices
+			{
+				if(message->what == B_GET_PROPERTY) {
+					if(!mainwin) {
+						reply.what = B_MESSAGE_NOT_UNDERSTOOD;
+						reply.AddString("message", "The monitor is not running.\n");
+						message->SendReply(&reply);
+						return;
+					}
+
+					// Unreported values and devices without statistics get NAN
+					BStringList paths;
+					std::vector<int32> ids;
+					DeviceRegistry::Default()->GetDevices(&paths, &ids);
+
+					std::vector<ThermalSnapshot> snapshots;
+					mainwin->GetLatestSnapshots(ids, &snapshots);
+
+					std::vector<bigtime_t> times;
+					std::vector<float> currents, criticals, hots, minimums, maximums, means;
+					BMessage result;
+					for(size_t i = 0; i < ids.size(); i++) {
+						const ThermalSnapshot& snapshot = snapshots[i];
+						RollingSummary summary;
+						bool hasSummary
+							= mainwin->Statistics()->GetSummary(ids[i], &summary) == B_OK;
+
+						result.AddString("path", paths.StringAt(i));
+						times.push_back(snapshot.timestamp);
+						currents.push_back(snapshot.IsReported(TEMPERATURE_CURRENT)
+							? snapshot.Temperature(TEMPERATURE_CURRENT) : NAN);
+						criticals.push_back(snapshot.IsReported(TEMPERATURE_CRITICAL)
+							? snapshot.Temperature(TEMPERATURE_CRITICAL) : NAN);
+						hots.push_back(snapshot.IsReported(TEMPERATURE_HOT)
+							? snapshot.Temperature(TEMPERATURE_HOT) : NAN);
+						minimums.push_back(hasSummary ? summary.minimum : NAN);
+						maximums.push_back(hasSummary ? summary.maximum : NAN);
+						means.push_back(hasSummary ? summary.mean : NAN);
+					}
+					result.AddInt32("devices", ids.size());
+					AddPacked(&result, "device", B_INT32_TYPE, ids);
+					AddPacked(&result, "when", B_INT64_TYPE, times);
+					AddPacked(&result, "temperature", B_FLOAT_TYPE, currents);
+					AddPacked(&result, "critical", B_FLOAT_TYPE, criticals);
+					AddPacked(&result, "hot", B_FLOAT_TYPE, hots);
+					AddPacked(&result, "minimum", B_FLOAT_TYPE, minimums);
+					AddPacked(&result, "maximum", B_FLOAT_TYPE, maximums);
+					AddPacked(&result, "mean", B_FLOAT_TYPE, means);
+					reply.AddMessage("result", &result);
+					message->SendReply(&reply);
+					return;
+				}
+				break;
+			}
+			case 10: // Updates
+			{
+				int32 device = !mainwin ? -1 : what == B_NAME_SPECIFIER
+					? DeviceRegistry::Default()->FindDevice(specifier.GetString("name", ""))
+					: mainwin->DisplayedDevice();
+				BMessenger target;
+				if(message->FindMessenger("target", &target) != B_OK)
+					target = message->ReturnAddress();
+
+				status_t status = device < 0 ? B_NAME_NOT_FOUND : B_OK;
+				if(status == B_OK && message->what == B_CREATE_PROPERTY) {
+					status = mainwin->SubscribeUpdates(device, target,
+						message->GetInt64("interval", 0), message->GetFloat("delta", 0));
+				}
+				else if(status == B_OK)
+					mainwin->UnsubscribeUpdates(device, target);
+
+				if(status != B_OK) {
+					reply.what = B_MESSAGE_NOT_UNDERSTOOD;
+					reply.AddString("message", status == B_BAD_VALUE
+						? "The interval and delta may not be negative.\n"
+						: "Device not found or not initialized.\n");
+					message->SendReply(&reply);
+					return;
+				}
+				reply.AddInt32("result", device);
+				message->SendReply(&reply);
+				return;
+			}
 		}
 	}
 }
 
-void App::LoadSettings()
+/* static */
+void App::ReadSettings(BMessage* settings)
 {
 	BPath settingsPath;
 	find_directory(B_USER_SETTINGS_DIRECTORY, &settingsPath);
 	settingsPath.Append(kTemperatureConfigFile, true);
 
-	BMessage settings;
 	BFile settingsFile(settingsPath.Path(), B_READ_ONLY);
-	if(settingsFile.InitCheck() != B_OK || settings.Unflatten(&settingsFile) != B_OK) {
-		DataFactory::DefaultSettings(&settings);
+	if(settingsFile.InitCheck() != B_OK || settings->Unflatten(&settingsFile) != B_OK) {
+		DataFactory::DefaultSettings(settings);
 	}
+}
+
+void App::LoadSettings()
+{
+	BMessage settings;
+	ReadSettings(&settings);
 
 	dataRepository = DataFactory::Instantiate(&settings);
 	if(dataRepository == NULL) {
@@ -258,10 +671,11 @@ void App::LoadSettings()
 
 	// The data repository currently does not have any active device
 	//	so let's select the first one available for the user if...
+	BStringList devices(dataRepository->ThermalDevices());
 	if((!dataRepository->ActiveDevice() || // has no device path
 	!BEntry(dataRepository->ActiveDevice()).Exists()) && // or the device path is invalid...
-	dataRepository->ThermalDevices().CountStrings() > 0) // and has available devices
-		dataRepository->SetActiveDevice(dataRepository->ThermalDevices().StringAt(0));
+	devices.CountStrings() > 0) // and has available devices
+		dataRepository->SetActiveDevice(devices.StringAt(0));
 }
 
 void App::SaveSettings()
@@ -281,8 +695,38 @@ void App::SaveSettings()
 	}
 }
 
+/* static */
+int App::RunHeadless(HeadlessOptions options)
+{
+	// Whatever the command line leaves open comes from the settings
+	BMessage settings;
+	ReadSettings(&settings);
+	DataFactory dataRepository(&settings);
+
+	if(options.interval == 0)
+		options.interval = dataRepository.RefreshInterval();
+
+	BPath logPath;
+	if(options.logDirectory == NULL
+		&& find_directory(B_USER_DATA_DIRECTORY, &logPath) == B_OK
+		&& logPath.Append(kHistoryLogDirectory) == B_OK
+		&& create_directory(logPath.Path(), 0755) == B_OK)
+		options.logDirectory = logPath.Path();
+
+	return ::RunHeadless(options);
+}
+
 int main(int argc, char **argv)
 {
+	HeadlessOptions options;
+	if(ParseHeadlessOptions(argc, argv, &options) != B_OK
+		|| (options.mode == HEADLESS_NONE && argc > 1)) {
+		PrintHeadlessUsage(stderr, argv[0]);
+		return 1;
+	}
+	if(options.mode != HEADLESS_NONE)
+		return App::RunHeadless(options);
+
 	App *app = new App();
 	app->Run();
 	delete app;
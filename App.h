@@ -4,6 +4,7 @@
 #include <Application.h>
 #include "MainWindow.h"
 #include "DataFactory.h"
+#include "Headless.h"
 
 class App : public BApplication
 {
@@ -23,6 +24,9 @@ public:
 
 	void LoadSettings();
 	void SaveSettings();
+
+	static void ReadSettings(BMessage* settings);
+	static int RunHeadless(HeadlessOptions options);
 private:
 	DataFactory* dataRepository;
 	MainWindow *mainwin;
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef __COLUMN_DECIMATOR__
+#define __COLUMN_DECIMATOR__
+
+#include <cstddef>
+#include "SampleRing.h"
+
+/*
+ * Folds a series into fixed-size buckets, one per pixel column, keeping the
+ * first, last, lowest and highest value of each (M4). Drawing a bar from
+ * the lowest to the highest value and joining last to next first renders
+ * exactly the pixels the full series would, so a one-sample spike is never
+ * lost, while the work depends on the number of columns only. Buckets are
+ * completed as samples are pushed, so the result stays current in O(1).
+ */
+template<size_t N>
+class ColumnDecimator
+{
+public:
+	struct Column {
+		float	first;
+		float	last;
+		float	min;
+		float	max;
+	};
+
+	ColumnDecimator()
+	: fBucketSize(1),
+	  fFill(0)
+	{
+	}
+
+	size_t BucketSize() const { return fBucketSize; }
+
+	// Drops every column
+	void SetBucketSize(size_t samples)
+	{
+		fBucketSize = samples > 0 ? samples : 1;
+		MakeEmpty();
+	}
+
+	void MakeEmpty()
+	{
+		fColumns.MakeEmpty();
+		fFill = 0;
+	}
+
+	// Returns true when the value started a new column rather than
+	//	updating the newest one.
+	bool Push(float value)
+	{
+		Column point = { value, value, value, value };
+		return Push(point);
+	}
+
+	// Same for a point that is already a range, e.g. a history bucket
+	bool Push(const Column& point)
+	{
+		if(fFill == 0 || fFill == fBucketSize) {
+			fColumns.Push(point);
+			fFill = 1;
+			return true;
+		}
+
+		Column& column = fColumns.LastItem();
+		column.last = point.last;
+		if(point.min < column.min)
+			column.min = point.min;
+		if(point.max > column.max)
+			column.max = point.max;
+		fFill++;
+		return false;
+	}
+
+	size_t Count() const { return fColumns.Count(); }
+
+	// Index 0 is the oldest column
+	Column ColumnAt(size_t index) const { return fColumns.ItemAt(index); }
+
+	// Calls visitor(index, column) for the newest count columns, oldest first.
+	template<typename Visitor>
+	void ForEachLast(size_t count, Visitor&& visitor) const
+	{
+		fColumns.ForEachLast(count, visitor);
+	}
+private:
+	SampleRing<Column, N> fColumns;
+	size_t	fBucketSize;
+	size_t	fFill;			// samples in the newest column
+};
+
+#endif /* __COLUMN_DECIMATOR__ */
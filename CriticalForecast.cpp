@@ -0,0 +1,141 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <Autolock.h>
+#include <cmath>
+#include "CriticalForecast.h"
+
+// #pragma mark - TrendEstimator
+
+TrendEstimator::TrendEstimator(bigtime_t halfLife)
+: fDecay(M_LN2 / (halfLife > 0 ? halfLife / 1000000.0 : 1.0))
+{
+	MakeEmpty();
+}
+
+void
+TrendEstimator::MakeEmpty()
+{
+	fLast = 0;
+	fCount = 0;
+	fWeights = fTimes = fValues = fSquaredTimes = fProducts = 0;
+}
+
+void
+TrendEstimator::Add(bigtime_t when, float value)
+{
+	if(!std::isfinite(value))
+		return;
+
+	if(fCount > 0) {
+		if(when < fLast)
+			return;
+
+		// Age every sum and move the origin to the new sample: a sample
+		//	that was at t is now at t - dt.
+		double dt = (when - fLast) / 1000000.0;
+		double factor = exp(-fDecay * dt);
+		fSquaredTimes = factor * (fSquaredTimes - 2 * dt * fTimes + dt * dt * fWeights);
+		fProducts = factor * (fProducts - dt * fValues);
+		fTimes = factor * (fTimes - dt * fWeights);
+		fValues *= factor;
+		fWeights *= factor;
+	}
+
+	// At the origin, so it adds nothing to the time sums
+	fWeights += 1;
+	fValues += value;
+	fLast = when;
+	fCount++;
+}
+
+bool
+TrendEstimator::GetTrend(float* outValue, float* outSlope) const
+{
+	if(fCount < 3)
+		return false;
+
+	double determinant = fWeights * fSquaredTimes - fTimes * fTimes;
+	if(determinant <= 1e-9 * fWeights * fWeights)
+		return false;
+
+	double slope = (fWeights * fProducts - fTimes * fValues) / determinant;
+	if(outSlope)
+		*outSlope = slope;
+	if(outValue)
+		*outValue = (fValues - slope * fTimes) / fWeights;
+	return true;
+}
+
+float
+TrendEstimator::SecondsUntil(float level) const
+{
+	float value;
+	float slope;
+	if(!GetTrend(&value, &slope))
+		return -1;
+	if(value >= level)
+		return 0;
+	if(slope < kForecastMinimumSlope)
+		return -1;
+
+	return (level - value) / slope;
+}
+
+// #pragma mark - ForecastStore
+
+ForecastStore::ForecastStore(bigtime_t halfLife)
+: fLock("Forecast store"),
+  fHalfLife(halfLife)
+{
+}
+
+void
+ForecastStore::Add(int32 device, const ThermalSnapshot& snapshot)
+{
+	if(!snapshot.IsReported(TEMPERATURE_CURRENT))
+		return;
+
+	BAutolock lock(fLock);
+	auto found = fEntries.find(device);
+	if(found == fEntries.end()) {
+		Entry entry = { TrendEstimator(fHalfLife), NAN };
+		found = fEntries.insert(std::make_pair(device, entry)).first;
+	}
+
+	Entry& entry = found->second;
+	entry.trend.Add(snapshot.timestamp, snapshot.Temperature(TEMPERATURE_CURRENT));
+	entry.critical = snapshot.IsReported(TEMPERATURE_CRITICAL)
+		? snapshot.Temperature(TEMPERATURE_CRITICAL) : NAN;
+}
+
+void
+ForecastStore::RemoveDevice(int32 device)
+{
+	BAutolock lock(fLock);
+	fEntries.erase(device);
+}
+
+status_t
+ForecastStore::GetForecast(int32 device, CriticalForecast* outForecast) const
+{
+	if(!outForecast)
+		return B_BAD_VALUE;
+
+	BAutolock lock(fLock);
+	auto found = fEntries.find(device);
+	if(found == fEntries.end())
+		return B_NAME_NOT_FOUND;
+
+	const Entry& entry = found->second;
+	if(!entry.trend.GetTrend(&outForecast->temperature, &outForecast->slope))
+		return B_NO_INIT;
+
+	outForecast->count = entry.trend.Count();
+	outForecast->critical = entry.critical;
+	outForecast->seconds = std::isnan(entry.critical)
+		? -1 : entry.trend.SecondsUntil(entry.critical);
+	outForecast->when = entry.trend.LastTime();
+	return B_OK;
+}
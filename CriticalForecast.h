@@ -0,0 +1,86 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef __CRITICAL_FORECAST__
+#define __CRITICAL_FORECAST__
+
+#include <Locker.h>
+#include <SupportDefs.h>
+#include <map>
+#include "ThermalDevice.h"
+
+#define kDefaultForecastHalfLife	20000000	// twenty seconds
+#define kForecastMinimumSlope		0.001f		// degrees per second
+
+struct CriticalForecast
+{
+	uint32		count;			// samples seen
+	float		temperature;	// fitted temperature at the last sample
+	float		slope;			// degrees per second
+	float		critical;		// NAN when the device does not report one
+	float		seconds;		// until critical, negative when not heading there
+	bigtime_t	when;			// of the last sample
+};
+
+/*
+ * Linear regression of a series over time with exponentially decaying
+ * weights, so older samples fade out with the given half-life. The
+ * weighted sums are kept relative to the newest sample and shifted as
+ * samples arrive, which keeps every update O(1) and the sums well
+ * conditioned however long the series runs. Uneven sampling is fine, the
+ * weights depend on time rather than on the number of samples.
+ */
+class TrendEstimator
+{
+public:
+						TrendEstimator(bigtime_t halfLife = kDefaultForecastHalfLife);
+
+			void		Add(bigtime_t when, float value);
+			void		MakeEmpty();
+
+			uint32		Count() const { return fCount; }
+			bigtime_t	LastTime() const { return fLast; }
+
+			// Fitted value at the last sample and slope per second
+			bool		GetTrend(float* outValue, float* outSlope) const;
+
+			// Negative when the trend never reaches level
+			float		SecondsUntil(float level) const;
+private:
+			double		fDecay;			// per second
+			bigtime_t	fLast;
+			uint32		fCount;
+
+			// Weighted sums, times in seconds relative to fLast
+			double		fWeights;
+			double		fTimes;
+			double		fValues;
+			double		fSquaredTimes;
+			double		fProducts;
+};
+
+/*
+ * Thread safe collection of TrendEstimator keyed by device id, answering
+ * how long each device has until its critical temperature.
+ */
+class ForecastStore
+{
+public:
+						ForecastStore(bigtime_t halfLife = kDefaultForecastHalfLife);
+
+			void		Add(int32 device, const ThermalSnapshot& snapshot);
+			void		RemoveDevice(int32 device);
+			status_t	GetForecast(int32 device, CriticalForecast* outForecast) const;
+private:
+	struct Entry {
+		TrendEstimator	trend;
+		float			critical;
+	};
+
+	mutable BLocker		fLock;
+	bigtime_t			fHalfLife;
+	std::map<int32, Entry> fEntries;
+};
+
+#endif /* __CRITICAL_FORECAST__ */
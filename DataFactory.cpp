@@ -2,13 +2,13 @@
  * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
  * Distributed under the terms of the MIT License.
  */
-#include <Directory.h>
-#include <Entry.h>
 #include <InterfaceDefs.h>
-#include <Path.h>
 #include <StringList.h>
 #include <SupportDefs.h>
+#include <algorithm>
+#include <cmath>
 #include "DataFactory.h"
+#include "DeviceRegistry.h"
 #include "TemperatureDefs.h"
 #include "TemperatureUtils.h"
 
@@ -17,13 +17,25 @@ DataFactory::DataFactory()
   fStandaloneMode(false),
   fWindowRect(BRect(100,100,500,400)),
   fActiveDevice(""),
-  fSecondsToRefresh(1),
+  fRefreshInterval(kDefaultRefreshInterval),
   fGraphWatermarkShown(true),
   fGraphLineColor(ui_color(B_FAILURE_COLOR)),
+  fGraphResolution(HISTORY_RAW),
   fGraphRunningStatus(true),
-  fTemperatureScale(SCALE_CELSIUS)
+  fTemperatureScale(SCALE_CELSIUS),
+  fHistoryLogging(true),
+  fStatisticsWindow(kDefaultStatisticsWindow),
+  fAlertHook(""),
+  fAdaptiveSampling(false)
 {
-	DataFactory::FindThermalDevices(&fDevicesList);
+	fHistoryCapacities[HISTORY_RAW] = kDefaultHistoryRaw;
+	fHistoryCapacities[HISTORY_MINUTE] = kDefaultHistoryMinutes;
+	fHistoryCapacities[HISTORY_HOUR] = kDefaultHistoryHours;
+	AlertEngine::DefaultRules(&fAlertRules);
+	fSamplingPolicy.fastest = kDefaultAdaptiveFastest;
+	fSamplingPolicy.slowest = kDefaultAdaptiveSlowest;
+	fSamplingPolicy.slope = kDefaultAdaptiveSlope;
+	fSamplingPolicy.margin = kDefaultAdaptiveMargin;
 }
 
 DataFactory::DataFactory(BMessage* from)
@@ -32,9 +44,29 @@ DataFactory::DataFactory(BMessage* from)
 {
 	fWindowRect = from->GetRect(kConfigWndFrame, BRect(100,100,500,400));
 	fActiveDevice = from->GetString(kConfigDevicePath, "");
-	fSecondsToRefresh = from->GetUInt32(kConfigWndPulse, 1);
+	// Settings from before microsecond intervals only have whole seconds
+	if(from->HasInt64(kConfigWndInterval))
+		fRefreshInterval = from->GetInt64(kConfigWndInterval, kDefaultRefreshInterval);
+	else
+		fRefreshInterval = static_cast<bigtime_t>(from->GetUInt32(kConfigWndPulse, 1)) * 1000000;
+	fRefreshInterval = std::max(fRefreshInterval, (bigtime_t)kMinimumRefreshInterval);
+	if(from->FindMessage(kConfigDeviceIntervals, &fDeviceRefreshIntervals) != B_OK) {
+		fDeviceRefreshIntervals.MakeEmpty();
+		BMessage pulses;
+		if(from->FindMessage(kConfigDevicePulses, &pulses) == B_OK) {
+			char* devicePath = NULL;
+			type_code type;
+			for(int32 i = 0; pulses.GetInfo(B_UINT32_TYPE, i, &devicePath, &type) == B_OK; i++) {
+				SetDeviceRefreshInterval(devicePath,
+					static_cast<bigtime_t>(pulses.GetUInt32(devicePath, 1)) * 1000000);
+			}
+		}
+	}
 	fGraphWatermarkShown = from->GetBool(kConfigGraphWMark, true);
 	fGraphLineColor = from->GetColor(kConfigGraphLColor, ui_color(B_FAILURE_COLOR));
+	fGraphResolution = HISTORY_RAW;
+	SetGraphResolution(static_cast<HistoryResolution>(
+		from->GetInt32(kConfigGraphTier, HISTORY_RAW)));
 	fGraphRunningStatus = from->GetBool(kConfigGraphRun, true);
 	const void* ptr = NULL;
 	ssize_t length = 0;
@@ -47,21 +79,45 @@ DataFactory::DataFactory(BMessage* from)
 	}
 	else
 		fTemperatureScale = SCALE_CELSIUS;
-
-	DataFactory::FindThermalDevices(&fDevicesList);
+	fHistoryCapacities[HISTORY_RAW] = from->GetUInt32(kConfigHistoryRaw, kDefaultHistoryRaw);
+	fHistoryCapacities[HISTORY_MINUTE] = from->GetUInt32(kConfigHistoryMin, kDefaultHistoryMinutes);
+	fHistoryCapacities[HISTORY_HOUR] = from->GetUInt32(kConfigHistoryHour, kDefaultHistoryHours);
+	fHistoryLogging = from->GetBool(kConfigHistoryLog, true);
+	fStatisticsWindow = from->GetUInt32(kConfigStatsWindow, kDefaultStatisticsWindow);
+	if(fStatisticsWindow == 0)
+		fStatisticsWindow = kDefaultStatisticsWindow;
+	if(from->FindMessage(kConfigAlertRules, &fAlertRules) != B_OK)
+		AlertEngine::DefaultRules(&fAlertRules);
+	fAlertHook = from->GetString(kConfigAlertHook, "");
+	fAdaptiveSampling = from->GetBool(kConfigSampAdaptive, false);
+	AdaptivePolicy policy;
+	policy.fastest = from->GetInt64(kConfigSampFastest, kDefaultAdaptiveFastest);
+	policy.slowest = from->GetInt64(kConfigSampSlowest, kDefaultAdaptiveSlowest);
+	policy.slope = from->GetFloat(kConfigSampSlope, kDefaultAdaptiveSlope);
+	policy.margin = from->GetFloat(kConfigSampMargin, kDefaultAdaptiveMargin);
+	SetSamplingPolicy(policy);
 }
 
 DataFactory::DataFactory(const DataFactory& other)
 : fStandaloneMode(other.fStandaloneMode),
   fWindowRect(other.fWindowRect),
   fActiveDevice(other.fActiveDevice),
-  fSecondsToRefresh(other.fSecondsToRefresh),
+  fRefreshInterval(other.fRefreshInterval),
+  fDeviceRefreshIntervals(other.fDeviceRefreshIntervals),
   fGraphWatermarkShown(other.fGraphWatermarkShown),
   fGraphLineColor(other.fGraphLineColor),
+  fGraphResolution(other.fGraphResolution),
   fGraphRunningStatus(other.fGraphRunningStatus),
-  fTemperatureScale(other.fTemperatureScale)
+  fTemperatureScale(other.fTemperatureScale),
+  fHistoryLogging(other.fHistoryLogging),
+  fStatisticsWindow(other.fStatisticsWindow),
+  fAlertRules(other.fAlertRules),
+  fAlertHook(other.fAlertHook),
+  fAdaptiveSampling(other.fAdaptiveSampling),
+  fSamplingPolicy(other.fSamplingPolicy)
 {
-	DataFactory::FindThermalDevices(&fDevicesList);
+	for(int32 i = 0; i < HISTORY_RESOLUTION_COUNT; i++)
+		fHistoryCapacities[i] = other.fHistoryCapacities[i];
 }
 
 DataFactory::~DataFactory()
@@ -86,16 +142,48 @@ status_t DataFactory::Archive(BMessage* into, bool deep) const
 		into->AddRect(kConfigWndFrame, fWindowRect);
 	if(into->ReplaceString(kConfigDevicePath, fActiveDevice) != B_OK)
 		into->AddString(kConfigDevicePath, fActiveDevice);
-	if(into->ReplaceUInt32(kConfigWndPulse, fSecondsToRefresh) != B_OK)
-		into->AddUInt32(kConfigWndPulse, fSecondsToRefresh);
+	if(into->ReplaceInt64(kConfigWndInterval, fRefreshInterval) != B_OK)
+		into->AddInt64(kConfigWndInterval, fRefreshInterval);
+	// Older versions only read whole seconds
+	uint32 seconds = std::max((bigtime_t)1, (fRefreshInterval + 500000) / 1000000);
+	if(into->ReplaceUInt32(kConfigWndPulse, seconds) != B_OK)
+		into->AddUInt32(kConfigWndPulse, seconds);
+	if(into->ReplaceMessage(kConfigDeviceIntervals, &fDeviceRefreshIntervals) != B_OK)
+		into->AddMessage(kConfigDeviceIntervals, &fDeviceRefreshIntervals);
 	if(into->ReplaceBool(kConfigGraphWMark, fGraphWatermarkShown) != B_OK)
 		into->AddBool(kConfigGraphWMark, fGraphWatermarkShown);
 	if(into->ReplaceColor(kConfigGraphLColor, fGraphLineColor) != B_OK)
 		into->AddColor(kConfigGraphLColor, fGraphLineColor);
+	if(into->ReplaceInt32(kConfigGraphTier, fGraphResolution) != B_OK)
+		into->AddInt32(kConfigGraphTier, fGraphResolution);
 	if(into->ReplaceBool(kConfigGraphRun, fGraphRunningStatus) != B_OK)
 		into->AddBool(kConfigGraphRun, fGraphRunningStatus);
 	if(into->ReplaceData(kConfigTempScale, B_CHAR_TYPE, &fTemperatureScale, sizeof(char)) != B_OK)
 		into->AddData(kConfigTempScale, B_CHAR_TYPE, &fTemperatureScale, sizeof(char));
+	if(into->ReplaceUInt32(kConfigHistoryRaw, fHistoryCapacities[HISTORY_RAW]) != B_OK)
+		into->AddUInt32(kConfigHistoryRaw, fHistoryCapacities[HISTORY_RAW]);
+	if(into->ReplaceUInt32(kConfigHistoryMin, fHistoryCapacities[HISTORY_MINUTE]) != B_OK)
+		into->AddUInt32(kConfigHistoryMin, fHistoryCapacities[HISTORY_MINUTE]);
+	if(into->ReplaceUInt32(kConfigHistoryHour, fHistoryCapacities[HISTORY_HOUR]) != B_OK)
+		into->AddUInt32(kConfigHistoryHour, fHistoryCapacities[HISTORY_HOUR]);
+	if(into->ReplaceBool(kConfigHistoryLog, fHistoryLogging) != B_OK)
+		into->AddBool(kConfigHistoryLog, fHistoryLogging);
+	if(into->ReplaceUInt32(kConfigStatsWindow, fStatisticsWindow) != B_OK)
+		into->AddUInt32(kConfigStatsWindow, fStatisticsWindow);
+	if(into->ReplaceMessage(kConfigAlertRules, &fAlertRules) != B_OK)
+		into->AddMessage(kConfigAlertRules, &fAlertRules);
+	if(into->ReplaceString(kConfigAlertHook, fAlertHook) != B_OK)
+		into->AddString(kConfigAlertHook, fAlertHook);
+	if(into->ReplaceBool(kConfigSampAdaptive, fAdaptiveSampling) != B_OK)
+		into->AddBool(kConfigSampAdaptive, fAdaptiveSampling);
+	if(into->ReplaceInt64(kConfigSampFastest, fSamplingPolicy.fastest) != B_OK)
+		into->AddInt64(kConfigSampFastest, fSamplingPolicy.fastest);
+	if(into->ReplaceInt64(kConfigSampSlowest, fSamplingPolicy.slowest) != B_OK)
+		into->AddInt64(kConfigSampSlowest, fSamplingPolicy.slowest);
+	if(into->ReplaceFloat(kConfigSampSlope, fSamplingPolicy.slope) != B_OK)
+		into->AddFloat(kConfigSampSlope, fSamplingPolicy.slope);
+	if(into->ReplaceFloat(kConfigSampMargin, fSamplingPolicy.margin) != B_OK)
+		into->AddFloat(kConfigSampMargin, fSamplingPolicy.margin);
 
 	return BArchivable::Archive(into, deep);
 }
@@ -111,16 +199,31 @@ status_t DataFactory::Perform(perform_code opcode, void* argument)
 
 			BMessage defaults;
 			DataFactory::DefaultSettings(&defaults);
-			SetActiveDevice(fDevicesList.StringAt(0).String());
-			SetRefreshRate(defaults.GetUInt32(kConfigWndPulse, 1));
+			SetActiveDevice(ThermalDevices().StringAt(0).String());
+			SetRefreshInterval(defaults.GetInt64(kConfigWndInterval, kDefaultRefreshInterval));
+			fDeviceRefreshIntervals.MakeEmpty();
 			SetWatermarkVisibility(defaults.GetBool(kConfigGraphWMark));
 			SetLineColor(defaults.GetColor(kConfigGraphLColor, ui_color(B_FAILURE_COLOR)));
+			SetGraphResolution(static_cast<HistoryResolution>(
+				defaults.GetInt32(kConfigGraphTier, HISTORY_RAW)));
 			SetRunningStatus(defaults.GetBool(kConfigGraphRun));
 			const void* ptr = NULL;
 			ssize_t length = 0;
 			defaults.FindData(kConfigTempScale, B_CHAR_TYPE, &ptr, &length);
 			char c = *(static_cast<const char*>(ptr));
 			SetTemperatureScale(c);
+			// Logging only starts or stops with the next launch
+			SetHistoryLogging(defaults.GetBool(kConfigHistoryLog, true));
+			SetStatisticsWindow(defaults.GetUInt32(kConfigStatsWindow, kDefaultStatisticsWindow));
+			defaults.FindMessage(kConfigAlertRules, &fAlertRules);
+			SetAlertHook(defaults.GetString(kConfigAlertHook, ""));
+			SetAdaptiveSampling(defaults.GetBool(kConfigSampAdaptive, false));
+			AdaptivePolicy policy;
+			policy.fastest = defaults.GetInt64(kConfigSampFastest, kDefaultAdaptiveFastest);
+			policy.slowest = defaults.GetInt64(kConfigSampSlowest, kDefaultAdaptiveSlowest);
+			policy.slope = defaults.GetFloat(kConfigSampSlope, kDefaultAdaptiveSlope);
+			policy.margin = defaults.GetFloat(kConfigSampMargin, kDefaultAdaptiveMargin);
+			SetSamplingPolicy(policy);
 			return B_OK;
 		}
 		default:
@@ -139,42 +242,12 @@ DataFactory* DataFactory::Instantiate(BMessage* archive)
 
 // #pragma mark - Devices
 
-/* static */
-status_t DataFactory::FindThermalDevices(BStringList* outList)
-{
-	BDirectory powerDirectory("/dev/power");
-	if(powerDirectory.InitCheck() != B_OK)
-		return B_IO_ERROR;
-
-	BEntry powerEntry;
-	while(powerDirectory.GetNextEntry(&powerEntry, false) == B_OK) {
-		BPath path;
-		powerEntry.GetPath(&path);
-		if(strstr(path.Leaf(), "thermal") == nullptr)
-			continue;
-
-		if(powerEntry.IsDirectory()) {
-			BEntry powerSubEntry;
-			BDirectory powerEntryDirectory(&powerEntry);
-			while(powerEntryDirectory.GetNextEntry(&powerSubEntry, false) == B_OK) {
-				if(!powerSubEntry.IsDirectory()) {
-					BPath subEntryPath;
-					powerSubEntry.GetPath(&subEntryPath);
-					outList->Add(BString(subEntryPath.Path()));
-				}
-			}
-		}
-		else {
-			outList->Add(BString(path.Path()));
-		}
-	}
-
-	return B_OK;
-}
-
-const BStringList& DataFactory::ThermalDevices() const
+BStringList DataFactory::ThermalDevices() const
 {
-	return fDevicesList;
+	// Scanned once per process, see DeviceRegistry
+	BStringList devices;
+	DeviceRegistry::Default()->GetDevices(&devices);
+	return devices;
 }
 
 // #pragma mark - Settings
@@ -186,12 +259,27 @@ void DataFactory::DefaultSettings(BMessage* archive)
 
     archive->AddString(kConfigDevicePath, "");
     archive->AddRect(kConfigWndFrame, BRect(100,100,500,400));
-    archive->AddUInt32(kConfigWndPulse, 1);
+    archive->AddInt64(kConfigWndInterval, kDefaultRefreshInterval);
     archive->AddBool(kConfigGraphRun, true);
 	archive->AddColor(kConfigGraphLColor, ui_color(B_FAILURE_COLOR));
+	archive->AddInt32(kConfigGraphTier, HISTORY_RAW);
     archive->AddBool(kConfigGraphWMark, true);
 	char scale = SCALE_CELSIUS;
 	archive->AddData(kConfigTempScale, B_CHAR_TYPE, &scale, sizeof(scale));
+	archive->AddUInt32(kConfigHistoryRaw, kDefaultHistoryRaw);
+	archive->AddUInt32(kConfigHistoryMin, kDefaultHistoryMinutes);
+	archive->AddUInt32(kConfigHistoryHour, kDefaultHistoryHours);
+	archive->AddBool(kConfigHistoryLog, true);
+	archive->AddUInt32(kConfigStatsWindow, kDefaultStatisticsWindow);
+	BMessage alertRules;
+	AlertEngine::DefaultRules(&alertRules);
+	archive->AddMessage(kConfigAlertRules, &alertRules);
+	archive->AddString(kConfigAlertHook, "");
+	archive->AddBool(kConfigSampAdaptive, false);
+	archive->AddInt64(kConfigSampFastest, kDefaultAdaptiveFastest);
+	archive->AddInt64(kConfigSampSlowest, kDefaultAdaptiveSlowest);
+	archive->AddFloat(kConfigSampSlope, kDefaultAdaptiveSlope);
+	archive->AddFloat(kConfigSampMargin, kDefaultAdaptiveMargin);
 }
 
 void DataFactory::SetWindowRect(BRect frame)
@@ -214,14 +302,33 @@ const char* DataFactory::ActiveDevice() const
 	return fActiveDevice.String();
 }
 
-void DataFactory::SetRefreshRate(uint32 seconds)
+void DataFactory::SetRefreshInterval(bigtime_t interval)
 {
-	fSecondsToRefresh = seconds;
+	fRefreshInterval = std::max(interval, (bigtime_t)kMinimumRefreshInterval);
 }
 
-uint32 DataFactory::RefreshRate() const
+bigtime_t DataFactory::RefreshInterval() const
 {
-	return fSecondsToRefresh;
+	return fRefreshInterval;
+}
+
+void DataFactory::SetDeviceRefreshInterval(const char* devicePath, bigtime_t interval)
+{
+	if(!devicePath)
+		return;
+
+	interval = std::max(interval, (bigtime_t)kMinimumRefreshInterval);
+	if(fDeviceRefreshIntervals.ReplaceInt64(devicePath, interval) != B_OK)
+		fDeviceRefreshIntervals.AddInt64(devicePath, interval);
+}
+
+bigtime_t DataFactory::DeviceRefreshInterval(const char* devicePath) const
+{
+	if(!devicePath)
+		return fRefreshInterval;
+
+	// Devices without a period of their own follow the global one
+	return fDeviceRefreshIntervals.GetInt64(devicePath, fRefreshInterval);
 }
 
 void DataFactory::SetWatermarkVisibility(bool state)
@@ -244,6 +351,19 @@ rgb_color DataFactory::LineColor() const
 	return fGraphLineColor;
 }
 
+void DataFactory::SetGraphResolution(HistoryResolution resolution)
+{
+	if(resolution < 0 || resolution >= HISTORY_RESOLUTION_COUNT)
+		return;
+
+	fGraphResolution = resolution;
+}
+
+HistoryResolution DataFactory::GraphResolution() const
+{
+	return fGraphResolution;
+}
+
 void DataFactory::SetRunningStatus(bool state)
 {
 	fGraphRunningStatus = state;
@@ -263,3 +383,95 @@ const char DataFactory::TemperatureScale() const
 {
 	return fTemperatureScale;
 }
+
+void DataFactory::SetHistoryCapacity(HistoryResolution resolution, uint32 points)
+{
+	if(resolution < 0 || resolution >= HISTORY_RESOLUTION_COUNT || points == 0)
+		return;
+
+	fHistoryCapacities[resolution] = points;
+}
+
+uint32 DataFactory::HistoryCapacity(HistoryResolution resolution) const
+{
+	if(resolution < 0 || resolution >= HISTORY_RESOLUTION_COUNT)
+		return 0;
+
+	return fHistoryCapacities[resolution];
+}
+
+void DataFactory::SetHistoryLogging(bool state)
+{
+	fHistoryLogging = state;
+}
+
+bool DataFactory::HistoryLogging() const
+{
+	return fHistoryLogging;
+}
+
+void DataFactory::SetStatisticsWindow(uint32 seconds)
+{
+	if(seconds == 0)
+		return;
+
+	fStatisticsWindow = seconds;
+}
+
+uint32 DataFactory::StatisticsWindow() const
+{
+	return fStatisticsWindow;
+}
+
+void DataFactory::SetAlertRules(const BMessage& rules)
+{
+	fAlertRules = rules;
+}
+
+const BMessage& DataFactory::AlertRules() const
+{
+	return fAlertRules;
+}
+
+void DataFactory::SetAlertHook(const char* path)
+{
+	fAlertHook.SetTo(path);
+}
+
+const char* DataFactory::AlertHook() const
+{
+	return fAlertHook.String();
+}
+
+void DataFactory::SetAdaptiveSampling(bool state)
+{
+	fAdaptiveSampling = state;
+}
+
+bool DataFactory::AdaptiveSampling() const
+{
+	return fAdaptiveSampling;
+}
+
+void DataFactory::SetSamplingPolicy(const AdaptivePolicy& policy)
+{
+	// Intervals that make no sense fall back to the defaults, the fastest
+	//	one is held to the refresh rate limit. So do bad thresholds.
+	fSamplingPolicy = policy;
+	if(policy.fastest <= 0 || policy.slowest < policy.fastest) {
+		fSamplingPolicy.fastest = kDefaultAdaptiveFastest;
+		fSamplingPolicy.slowest = kDefaultAdaptiveSlowest;
+	}
+	fSamplingPolicy.fastest = std::max(fSamplingPolicy.fastest,
+		(bigtime_t)kMinimumRefreshInterval);
+	fSamplingPolicy.slowest = std::max(fSamplingPolicy.slowest, fSamplingPolicy.fastest);
+	if(!std::isfinite(policy.slope) || policy.slope < 0)
+		fSamplingPolicy.slope = kDefaultAdaptiveSlope;
+	if(!std::isfinite(policy.margin) || policy.margin < 0)
+		fSamplingPolicy.margin = kDefaultAdaptiveMargin;
+}
+
+const AdaptivePolicy& DataFactory::SamplingPolicy() const
+{
+	return fSamplingPolicy;
+}
@@ -7,8 +7,13 @@
 
 #include <Archivable.h>
 #include <GraphicsDefs.h>
+#include <Message.h>
 #include <String.h>
 #include <StringList.h>
+#include "AlertEngine.h"
+#include "HistoryStore.h"
+#include "RollingStatistics.h"
+#include "SamplerEngine.h"
 
 class DataFactory : public BArchivable
 {
@@ -27,8 +32,7 @@ public:
 	static DataFactory* Instantiate(BMessage* archive);
 
 	// Device utils
-	static status_t FindThermalDevices(BStringList* outList);
-	const BStringList& ThermalDevices() const;
+	BStringList ThermalDevices() const;
 
 	// Application settings
 	static void DefaultSettings(BMessage* archive);
@@ -39,8 +43,12 @@ public:
 	void SetActiveDevice(const char* devicePath);
 	const char* ActiveDevice() const;
 
-	void SetRefreshRate(uint32 seconds);
-	uint32 RefreshRate() const;
+	// In microseconds, kMinimumRefreshInterval at least
+	void SetRefreshInterval(bigtime_t interval);
+	bigtime_t RefreshInterval() const;
+
+	void SetDeviceRefreshInterval(const char* devicePath, bigtime_t interval);
+	bigtime_t DeviceRefreshInterval(const char* devicePath) const;
 
 	void SetWatermarkVisibility(bool state);
 	bool WatermarkVisibility() const;
@@ -48,23 +56,59 @@ public:
 	void SetLineColor(rgb_color color);
 	rgb_color LineColor() const;
 
+	// Tier of the history store the graph plots, when it has one
+	void SetGraphResolution(HistoryResolution resolution);
+	HistoryResolution GraphResolution() const;
+
 	void SetRunningStatus(bool state);
 	bool RunningStatus() const;
 
 	void SetTemperatureScale(char scale);
 	const char TemperatureScale() const;
+
+	// Only read when the history store is created
+	void SetHistoryCapacity(HistoryResolution resolution, uint32 points);
+	uint32 HistoryCapacity(HistoryResolution resolution) const;
+
+	void SetHistoryLogging(bool state);
+	bool HistoryLogging() const;
+
+	void SetStatisticsWindow(uint32 seconds);
+	uint32 StatisticsWindow() const;
+
+	// Archived with AlertEngine::RulesToMessage()
+	void SetAlertRules(const BMessage& rules);
+	const BMessage& AlertRules() const;
+
+	// Program run on every alert, empty for none
+	void SetAlertHook(const char* path);
+	const char* AlertHook() const;
+
+	// The refresh rate is the starting point of adaptive devices
+	void SetAdaptiveSampling(bool state);
+	bool AdaptiveSampling() const;
+
+	void SetSamplingPolicy(const AdaptivePolicy& policy);
+	const AdaptivePolicy& SamplingPolicy() const;
 public:
 	bool fStandaloneMode;
 private:
-	BStringList fDevicesList;
-
 	BRect fWindowRect;
 	BString fActiveDevice;
-	uint32 fSecondsToRefresh;
+	bigtime_t fRefreshInterval;
+	BMessage fDeviceRefreshIntervals;
 	bool fGraphWatermarkShown;
 	rgb_color fGraphLineColor;
+	HistoryResolution fGraphResolution;
 	bool fGraphRunningStatus;
 	char fTemperatureScale;
+	uint32 fHistoryCapacities[HISTORY_RESOLUTION_COUNT];
+	bool fHistoryLogging;
+	uint32 fStatisticsWindow;
+	BMessage fAlertRules;
+	BString fAlertHook;
+	bool fAdaptiveSampling;
+	AdaptivePolicy fSamplingPolicy;
 };
 
 #endif /* __DATA_FACTORY__ */
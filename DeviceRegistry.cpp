@@ -0,0 +1,346 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <Autolock.h>
+#include <Directory.h>
+#include <Entry.h>
+#include <NodeMonitor.h>
+#include <Path.h>
+#include <algorithm>
+#include <cstring>
+#include "DeviceRegistry.h"
+#include "TemperatureDefs.h"
+
+DeviceRegistry* DeviceRegistry::sDefault = NULL;
+static BLocker sDefaultLock("Device registry creation");
+
+class DeviceRegistry::Watcher : public BLooper
+{
+public:
+	Watcher(DeviceRegistry* registry)
+	: BLooper("Device watcher", B_LOW_PRIORITY),
+	  fRegistry(registry)
+	{
+	}
+
+	void MessageReceived(BMessage* message) override
+	{
+		if(message->what == B_NODE_MONITOR)
+			fRegistry->HandleNodeMonitor(message);
+		else
+			BLooper::MessageReceived(message);
+	}
+private:
+	DeviceRegistry*	fRegistry;
+};
+
+static node_ref
+NodeRefFor(const char* path)
+{
+	node_ref node;
+	BEntry(path).GetNodeRef(&node);
+	return node;
+}
+
+// #pragma mark - Public
+
+/* static */
+DeviceRegistry*
+DeviceRegistry::Default()
+{
+	BAutolock lock(sDefaultLock);
+	if(sDefault == NULL)
+		sDefault = new DeviceRegistry(kThermalDeviceRoot);
+
+	return sDefault;
+}
+
+/* static */
+void
+DeviceRegistry::DeleteDefault()
+{
+	BAutolock lock(sDefaultLock);
+	delete sDefault;
+	sDefault = NULL;
+}
+
+int32
+DeviceRegistry::Register(const char* path)
+{
+	if(!path || strlen(path) == 0)
+		return B_BAD_VALUE;
+
+	BAutolock lock(fLock);
+	auto found = fIDs.find(BString(path));
+	if(found != fIDs.end())
+		return found->second;
+
+	// Known from now on, but only present once the tree says so
+	Entry entry;
+	entry.path.SetTo(path);
+	entry.present = false;
+	fEntries.push_back(entry);
+
+	int32 id = fEntries.size() - 1;
+	fIDs[entry.path] = id;
+	return id;
+}
+
+int32
+DeviceRegistry::FindDevice(const char* path) const
+{
+	if(!path)
+		return B_BAD_VALUE;
+
+	BAutolock lock(fLock);
+	auto found = fIDs.find(BString(path));
+	return found != fIDs.end() ? found->second : B_NAME_NOT_FOUND;
+}
+
+BString
+DeviceRegistry::DevicePath(int32 device) const
+{
+	BAutolock lock(fLock);
+	if(device < 0 || device >= (int32)fEntries.size())
+		return BString();
+
+	return fEntries[device].path;
+}
+
+bool
+DeviceRegistry::IsPresent(int32 device) const
+{
+	BAutolock lock(fLock);
+	return device >= 0 && device < (int32)fEntries.size() && fEntries[device].present;
+}
+
+int32
+DeviceRegistry::CountDevices() const
+{
+	BAutolock lock(fLock);
+	return std::count_if(fEntries.begin(), fEntries.end(),
+		[](const Entry& entry) { return entry.present; });
+}
+
+void
+DeviceRegistry::GetDevices(BStringList* outPaths, std::vector<int32>* outIDs) const
+{
+	BAutolock lock(fLock);
+	for(size_t i = 0; i < fEntries.size(); i++) {
+		if(!fEntries[i].present)
+			continue;
+
+		if(outPaths)
+			outPaths->Add(fEntries[i].path);
+		if(outIDs)
+			outIDs->push_back(i);
+	}
+}
+
+status_t
+DeviceRegistry::StartWatching(BMessenger target)
+{
+	BAutolock lock(fLock);
+	fSubscribers.push_back(target);
+	if(fWatcher)
+		return B_OK;
+
+	fWatcher = new Watcher(this);
+	fWatcher->Run();
+
+	// Without the root watch nothing would ever be reported; leave no
+	//	watcher behind, so that the next call tries again.
+	status_t status = watch_node(&fRootNode, B_WATCH_DIRECTORY, fWatcher);
+	if(status != B_OK) {
+		fWatcher->Lock();
+		fWatcher->Quit();
+		fWatcher = NULL;
+		fSubscribers.pop_back();
+		return status;
+	}
+
+	// Drivers that publish a directory of nodes need their own watch
+	BDirectory root(fRoot);
+	BEntry entry;
+	while(root.GetNextEntry(&entry, false) == B_OK) {
+		BPath path;
+		if(entry.IsDirectory() && entry.GetPath(&path) == B_OK
+			&& strstr(path.Leaf(), "thermal") != NULL)
+			WatchDirectory(path.Path());
+	}
+
+	return B_OK;
+}
+
+void
+DeviceRegistry::StopWatching(BMessenger target)
+{
+	BAutolock lock(fLock);
+	fSubscribers.erase(std::remove(fSubscribers.begin(), fSubscribers.end(), target),
+		fSubscribers.end());
+}
+
+// #pragma mark - Private
+
+DeviceRegistry::DeviceRegistry(const char* root)
+: fLock("Device registry"),
+  fRoot(root),
+  fWatcher(NULL)
+{
+	fRootNode = NodeRefFor(root);
+	Scan();
+}
+
+DeviceRegistry::~DeviceRegistry()
+{
+	if(fWatcher) {
+		stop_watching(fWatcher);
+		fWatcher->Lock();
+		fWatcher->Quit();
+	}
+}
+
+void
+DeviceRegistry::Scan()
+{
+	ThermalDevice::FindDevices(fRoot,
+		[](const char* path, void* cookie) {
+			static_cast<DeviceRegistry*>(cookie)->SetPresent(path, true);
+		}, this);
+}
+
+int32
+DeviceRegistry::SetPresent(const char* path, bool present)
+{
+	int32 id = Register(path);
+	if(id < 0)
+		return id;
+
+	BAutolock lock(fLock);
+	Entry& entry = fEntries[id];
+	if(entry.present == present)
+		return B_NAME_IN_USE;
+
+	entry.present = present;
+	if(present) {
+		entry.node = NodeRefFor(path);
+		BPath parent;
+		if(BPath(path).GetParent(&parent) == B_OK)
+			entry.parent = NodeRefFor(parent.Path());
+	}
+
+	return id;
+}
+
+void
+DeviceRegistry::WatchDirectory(const char* path)
+{
+	node_ref node = NodeRefFor(path);
+	if(fDirectories.find(node) != fDirectories.end())
+		return;
+	if(fWatcher)
+		watch_node(&node, B_WATCH_DIRECTORY, fWatcher);
+	fDirectories[node] = path;
+
+	BDirectory directory(path);
+	BEntry entry;
+	while(directory.GetNextEntry(&entry, false) == B_OK) {
+		BPath entryPath;
+		if(!entry.IsDirectory() && entry.GetPath(&entryPath) == B_OK)
+			Notify(SetPresent(entryPath.Path(), true));
+	}
+}
+
+void
+DeviceRegistry::HandleNodeMonitor(BMessage* message)
+{
+	int32 opcode;
+	if(message->FindInt32("opcode", &opcode) != B_OK)
+		return;
+
+	BAutolock lock(fLock);
+	node_ref node;
+	node.device = message->GetInt32("device", -1);
+	node.node = message->GetInt64("node", -1);
+	node_ref directory;
+	directory.device = node.device;
+
+	switch(opcode) {
+		case B_ENTRY_CREATED:
+			directory.node = message->GetInt64("directory", -1);
+			EntryCreated(directory, message->GetString("name"));
+			break;
+		case B_ENTRY_REMOVED:
+			EntryRemoved(node);
+			break;
+		case B_ENTRY_MOVED:
+			EntryRemoved(node);
+			directory.node = message->GetInt64("to directory", -1);
+			EntryCreated(directory, message->GetString("name"));
+			break;
+	}
+}
+
+void
+DeviceRegistry::EntryCreated(const node_ref& directory, const char* name)
+{
+	if(!name)
+		return;
+
+	entry_ref ref(directory.device, directory.node, name);
+	BEntry entry(&ref);
+	BPath path;
+	if(entry.GetPath(&path) != B_OK)
+		return;
+
+	if(directory == fRootNode) {
+		if(strstr(name, "thermal") == NULL)
+			return;
+		if(entry.IsDirectory())
+			WatchDirectory(path.Path());
+		else
+			Notify(SetPresent(path.Path(), true));
+	}
+	else if(fDirectories.find(directory) != fDirectories.end() && !entry.IsDirectory())
+		Notify(SetPresent(path.Path(), true));
+}
+
+void
+DeviceRegistry::EntryRemoved(const node_ref& node)
+{
+	auto directory = fDirectories.find(node);
+	if(directory != fDirectories.end()) {
+		watch_node(&node, B_STOP_WATCHING, fWatcher);
+		fDirectories.erase(directory);
+	}
+
+	// Either the node itself or everything that was inside it
+	for(size_t i = 0; i < fEntries.size(); i++) {
+		Entry& entry = fEntries[i];
+		if(entry.present && (entry.node == node || entry.parent == node)) {
+			entry.present = false;
+			Notify(i);
+		}
+	}
+}
+
+void
+DeviceRegistry::Notify(int32 device)
+{
+	if(device < 0)
+		return;
+
+	BMessage message(M_DEVICES_CHANGED);
+	message.AddInt32("device", device);
+	message.AddString("path", fEntries[device].path);
+	message.AddBool("present", fEntries[device].present);
+
+	// Never wait on a busy subscriber, and forget the ones that are gone
+	for(auto subscriber = fSubscribers.begin(); subscriber != fSubscribers.end();) {
+		if(subscriber->SendMessage(&message, (BHandler*)NULL, 0) == B_BAD_PORT_ID)
+			subscriber = fSubscribers.erase(subscriber);
+		else
+			subscriber++;
+	}
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef __DEVICE_REGISTRY__
+#define __DEVICE_REGISTRY__
+
+#include <Locker.h>
+#include <Looper.h>
+#include <Messenger.h>
+#include <Node.h>
+#include <String.h>
+#include <StringList.h>
+#include <SupportDefs.h>
+#include <map>
+#include <vector>
+#include "ThermalDevice.h"
+
+/*
+ * Process-wide list of thermal devices. The device tree is scanned once,
+ * on first use; every path then keeps the same integer id for the life of
+ * the process, even across unplugging, so hot paths never compare strings.
+ * Once StartWatching() is called, node monitoring keeps the list current
+ * and subscribers receive M_DEVICES_CHANGED with "device" (int32), "path"
+ * (string) and "present" (bool).
+ */
+class DeviceRegistry
+{
+public:
+	static	DeviceRegistry* Default();
+	static	void		DeleteDefault();
+
+			int32		Register(const char* path);
+			int32		FindDevice(const char* path) const;
+			BString		DevicePath(int32 device) const;
+			bool		IsPresent(int32 device) const;
+
+			// Present devices only, ordered by id
+			int32		CountDevices() const;
+			void		GetDevices(BStringList* outPaths,
+							std::vector<int32>* outIDs = NULL) const;
+
+			status_t	StartWatching(BMessenger target);
+			void		StopWatching(BMessenger target);
+private:
+						DeviceRegistry(const char* root);
+						~DeviceRegistry();
+
+	struct Entry {
+		BString		path;
+		node_ref	node;
+		node_ref	parent;
+		bool		present;
+	};
+
+	class Watcher;
+	friend class Watcher;
+
+			void		Scan();
+			int32		SetPresent(const char* path, bool present);
+			void		WatchDirectory(const char* path);
+			void		HandleNodeMonitor(BMessage* message);
+			void		EntryCreated(const node_ref& directory, const char* name);
+			void		EntryRemoved(const node_ref& node);
+			void		Notify(int32 device);
+private:
+	mutable BLocker		fLock;
+	BString				fRoot;
+	node_ref			fRootNode;
+	std::vector<Entry>	fEntries;			// indexed by id
+	std::map<BString, int32> fIDs;
+	std::map<node_ref, BString> fDirectories;	// watched thermal directories
+	std::vector<BMessenger> fSubscribers;
+	BLooper*			fWatcher;
+
+	static	DeviceRegistry* sDefault;
+};
+
+#endif /* __DEVICE_REGISTRY__ */
@@ -3,6 +3,9 @@
 #include <LayoutBuilder.h>
 #include <NumberFormat.h>
 #include <StringFormat.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include "GraphView.h"
 #include "TemperatureDefs.h"
 #include "TemperatureUtils.h"
@@ -10,14 +13,35 @@
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "GraphView"
 
+// Offered in the refresh rate menu, in microseconds
+static const bigtime_t kRefreshIntervals[] = {
+	100000, 250000, 500000, 1000000, 2000000, 3000000, 4000000, 5000000
+};
+static const int32 kRefreshIntervalCount
+	= sizeof(kRefreshIntervals) / sizeof(kRefreshIntervals[0]);
+
+// Watermark font sizes, relative to the width of the view
+static const float kTemperatureFontScale = 0.06f;
+static const float kDeviceFontScale = 0.03f;
+
 GraphView::GraphView(DataFactory* dataRepo)
-: BView("GraphView", B_SUPPORTS_LAYOUT | B_WILL_DRAW | B_FRAME_EVENTS | B_PULSE_NEEDED, NULL),
+: BView("GraphView", B_SUPPORTS_LAYOUT | B_WILL_DRAW | B_FRAME_EVENTS, NULL),
   fStandaloneMode(false),
-  fMaxDataPoints(100),
-  fDataPoints(NULL),
   fCurrentValues(NULL),
-  fDataRepository(dataRepo),
-  fStandaloneDevice(NULL)
+  fHistoryStore(NULL),
+  fNewestBucket(-1),
+  fDisplayedDevice(0),
+  fBackgroundLayer(NULL),
+  fPlotLayer(NULL),
+  fLayersValid(false),
+  fPlotScale(SCALE_CELSIUS),
+  fPlotBottom(0.0f),
+  fPlotTop(100.0f),
+  fColumnWidth(1.0f),
+  fVisibleColumns(0),
+  fStatistics(NULL),
+  fSummary(),
+  fDataRepository(dataRepo)
 {
 	InitGraphView();
 	InitDragger();
@@ -26,11 +50,21 @@ GraphView::GraphView(DataFactory* dataRepo)
 GraphView::GraphView(BMessage* archive)
 : BView(archive),
   fStandaloneMode(true),
-  fMaxDataPoints(100),
-  fDataPoints(NULL),
   fCurrentValues(NULL),
-  fDataRepository(NULL),
-  fStandaloneDevice(new ThermalDevice)
+  fHistoryStore(NULL),
+  fNewestBucket(-1),
+  fDisplayedDevice(0),
+  fBackgroundLayer(NULL),
+  fPlotLayer(NULL),
+  fLayersValid(false),
+  fPlotScale(SCALE_CELSIUS),
+  fPlotBottom(0.0f),
+  fPlotTop(100.0f),
+  fColumnWidth(1.0f),
+  fVisibleColumns(0),
+  fStatistics(NULL),
+  fSummary(),
+  fDataRepository(NULL)
 {
 	BMessage config;
 	status_t status = archive->FindMessage("config", &config);
@@ -39,15 +73,19 @@ GraphView::GraphView(BMessage* archive)
 	else
 		fDataRepository = new DataFactory;
 	fDataRepository->fStandaloneMode = fStandaloneMode;
-	fStandaloneDevice->SetTo(fDataRepository->ActiveDevice());
+	fStatistics = new RollingStatistics(
+		static_cast<bigtime_t>(fDataRepository->StatisticsWindow()) * 1000000);
 
 	InitGraphView();
 }
 
 GraphView::~GraphView()
 {
-	delete[] fCurrentValues;
-	delete[] fDataPoints;
+	for(auto& history : fHistories)
+		delete history.second;
+	delete fBackgroundLayer;
+	delete fPlotLayer;
+	delete fStatistics;
 
 	if(Standalone() && fDataRepository)
 		delete fDataRepository;
@@ -84,7 +122,20 @@ void GraphView::AttachedToWindow()
 
 	fGraphMenu->SetTargetForItems(this);
 	fRefreshRateMenu->SetTargetForItems(this);
+	fResolutionMenu->SetTargetForItems(this);
 	fTemperatureScaleMenu->SetTargetForItems(this);
+
+	// Samples come from the sample feed, which shares the application's
+	//	sampler when it runs instead of reading the device for every view.
+	if(Standalone())
+		SampleFeed::Subscribe(fDataRepository->ActiveDevice(),
+			fDataRepository->RefreshInterval(), BMessenger(this));
+}
+
+void GraphView::DetachedFromWindow()
+{
+	if(Standalone())
+		SampleFeed::Unsubscribe(fDataRepository->ActiveDevice(), BMessenger(this));
 }
 
 void GraphView::MessageReceived(BMessage* message)
@@ -93,14 +144,22 @@ void GraphView::MessageReceived(BMessage* message)
 	{
 		case M_DEVICE_CHANGED:
 		{
+			// Hosted graphs keep the history of every device and are
+			//	switched through SetDisplayedDevice() instead.
+			if(!Standalone())
+				break;
+
 			fDataRepository->SetRunningStatus(false);
 
-			for(int i = 0; i < fMaxDataPoints; i++)
-				fCurrentValues[i] = 0.0f;
+			fCurrentValues->MakeEmpty();
+			fStatistics->MakeEmpty();
+			fSummary = RollingSummary();
+			InvalidateLayers();
 
-			if(Standalone()) {
-				fDataRepository->SetActiveDevice(message->GetString("target"));
-			}
+			SampleFeed::Unsubscribe(fDataRepository->ActiveDevice(), BMessenger(this));
+			fDataRepository->SetActiveDevice(message->GetString("target"));
+			SampleFeed::Subscribe(fDataRepository->ActiveDevice(),
+				fDataRepository->RefreshInterval(), BMessenger(this));
 
 			fDataRepository->SetRunningStatus(true);
 			break;
@@ -108,11 +167,21 @@ void GraphView::MessageReceived(BMessage* message)
 		case M_TEMPERATURE_REPLY:
 		{
 			float temperature = 0.0f;
-			if(fDataRepository->RunningStatus() && message->FindFloat("temperature", &temperature) == B_OK) {
-				for(int i = 0; i < fMaxDataPoints; i++)
-					fCurrentValues[i] = fCurrentValues[i + 1];
-				fCurrentValues[fMaxDataPoints - 1] = temperature;
-			}
+			if(message->FindFloat("temperature", &temperature) == B_OK)
+				AddSample(message->GetInt32("device", fDisplayedDevice), temperature,
+					message->GetInt64("when", system_time()));
+			break;
+		}
+		case M_SAMPLE_BROADCAST:
+		{
+			if(!Standalone() || !fDataRepository->RunningStatus()
+				|| strcmp(message->GetString("path", ""), fDataRepository->ActiveDevice()) != 0)
+				break;
+
+			float temperature = 0.0f;
+			if(message->FindFloat("temperature", &temperature) == B_OK)
+				AddSample(fDisplayedDevice, temperature,
+					message->GetInt64("when", system_time()));
 			break;
 		}
 		case M_GRAPHVIEW_PAUSE:
@@ -126,6 +195,10 @@ void GraphView::MessageReceived(BMessage* message)
 		{
 			fDataRepository->SetWatermarkVisibility(!fDataRepository->WatermarkVisibility());
 			fGraphMenu->FindItem(M_GRAPHVIEW_WATERMARK)->SetMarked(fDataRepository->WatermarkVisibility());
+			for(int32 i = 0; i < WATERMARK_COUNT; i++) {
+				if(fWatermark[i].frame.IsValid())
+					Invalidate(fWatermark[i].frame);
+			}
 			break;
 		}
 		case M_GRAPHVIEW_COLOR_CHANGED:
@@ -151,24 +224,49 @@ void GraphView::MessageReceived(BMessage* message)
 				fDataRepository->SetLineColor(color);
 				fLineColor = fDataRepository->LineColor();
 
-				Invalidate();
+				InvalidateLayers();
 			}
 
 			break;
 		}
 		case M_REFRESH_RATE:
 		{
-			uint32 rate = 1;
-			if(message->FindUInt32("rate", &rate) == B_OK) {
+			bigtime_t interval = 0;
+			if(message->FindInt64("interval", &interval) == B_OK) {
 				if(Window())
 					Window()->PostMessage(message);
-				fDataRepository->SetRefreshRate(rate);
-
-				for(int32 i = 0; i < 5; i++)
-					fRefreshRateMenu->ItemAt(i)->SetMarked(i == static_cast<int32>(rate - 1));
+				fDataRepository->SetRefreshInterval(interval);
+				if(Standalone())
+					SampleFeed::Subscribe(fDataRepository->ActiveDevice(),
+						fDataRepository->RefreshInterval(), BMessenger(this));
+
+				for(int32 i = 0; i < kRefreshIntervalCount; i++) {
+					fRefreshRateMenu->ItemAt(i)->SetMarked(
+						kRefreshIntervals[i] == fDataRepository->RefreshInterval());
+				}
 			}
 			break;
 		}
+		case M_GRAPHVIEW_RESOLUTION:
+		{
+			int32 resolution = message->GetInt32("resolution", HISTORY_RAW);
+			if(resolution != HISTORY_RAW && fHistoryStore == NULL)
+				break;
+
+			fDataRepository->SetGraphResolution(static_cast<HistoryResolution>(resolution));
+			MarkResolution();
+			InvalidateLayers();
+			break;
+		}
+		case M_ADAPTIVE_SAMPLING:
+		{
+			fDataRepository->SetAdaptiveSampling(!fDataRepository->AdaptiveSampling());
+			fRefreshRateMenu->FindItem(M_ADAPTIVE_SAMPLING)->SetMarked(
+				fDataRepository->AdaptiveSampling());
+			if(Window())
+				Window()->PostMessage(message);
+			break;
+		}
 		case M_SCALE_CHANGED:
 		{
 			const void* ptr = NULL;
@@ -193,112 +291,94 @@ void GraphView::MessageReceived(BMessage* message)
 			for(int32 i = 0; i < SCALE_COUNT; i++)
 				fTemperatureScaleMenu->ItemAt(i)->SetMarked(i == scaleIndex);
 
+			// A hosted graph sees the new scale before the window stores it
+			SetPlotScale(c);
 			break;
 		}
+		case B_COLORS_UPDATED:
+			InvalidateLayers();
+			BView::MessageReceived(message);
+			break;
 		default:
 			BView::MessageReceived(message);
 			break;
 	}
 }
 
-void GraphView::Pulse()
+void GraphView::AddSample(int32 device, float temperature, bigtime_t when)
 {
-	if(fDataRepository->RunningStatus()) {
-		BMessage request;
-
-		if(Standalone()) {
-			request.what = M_TEMPERATURE_REPLY;
-			request.AddFloat("temperature", fStandaloneDevice->ReadTemperature());
-			BMessenger(this).SendMessage(&request);
-		}
-		else {
-			request.what = M_TEMPERATURE_REQUESTED;
-			request.AddMessenger("handler", this);
-			Window()->PostMessage(&request, Window(), this);
-		}
+	if(!fDataRepository->RunningStatus())
+		return;
+
+	HistoryFor(device)->Push(temperature);
+	if(device != fDisplayedDevice)
+		return;
+
+	if(PlotsHistoryStore()) {
+		// The store has the sample already; replot as its buckets open
+		bigtime_t length = HistoryStore::BucketLength(fDataRepository->GraphResolution());
+		if(when - when % length != fNewestBucket)
+			InvalidateLayers();
+	}
+	else {
+		BRect dirty = UpdatePlotLayer(temperature);
+		if(dirty.IsValid())
+			Invalidate(dirty);
+	}
 
-		Invalidate();
+	if(fStatistics) {
+		fStatistics->Add(when, temperature);
+		fStatistics->GetSummary(&fSummary);
 	}
+
+	UpdateWatermark(fPlotScale);
 }
 
-void GraphView::Draw(BRect updateRect)
+void GraphView::SetSummary(const RollingSummary& summary)
 {
-	BView::Draw(updateRect);
-
-	auto calculateX = [=] (int initial) {
-		return ((initial * Bounds().Width()) / fMaxDataPoints);
-	};
-	auto calculateY = [=] (float initial) {
-		return (Bounds().Height() - ((initial * Bounds().Height()) / 100));
-	};
-
-	BRect borderFrame(Bounds());
-	SetHighUIColor(B_CONTROL_BORDER_COLOR);
-	SetPenSize(2.0f);
-	StrokeRect(Bounds());
-
-	BRect backgroundFrame(borderFrame.InsetByCopy(2.0f, 2.0f));
-
-	if(fDataRepository->WatermarkVisibility()) {
-		drawing_mode oldDwMode = DrawingMode();
-		int32 stringProportion = fMaxDataPoints / 30;
-
-		SetHighUIColor(B_CONTROL_BORDER_COLOR, B_DARKEN_2_TINT);
-
-		BString numberString;
-		BNumberFormat format;
-		format.Format(numberString,
-			ConvertToScale(static_cast<double>(fCurrentValues[fMaxDataPoints - 1]),
-			SCALE_CELSIUS, fDataRepository->TemperatureScale()));
-		BString watermarkTemp(B_TRANSLATE("%temperature% %scale%"));
-		watermarkTemp.ReplaceAll("%temperature%", numberString);
-		watermarkTemp.ReplaceAll("%scale%", SymbolForScale(fDataRepository->TemperatureScale()));
-
-		BFont watermarkTempFont(be_plain_font);
-		watermarkTempFont.SetSize(calculateX(stringProportion * 2));
-
-		BPoint watermarkInsPoint(backgroundFrame.left + 10, backgroundFrame.bottom - 12);
-
-		SetDrawingMode(B_OP_COPY);
-		SetFont(&watermarkTempFont);
-
-		DrawString(watermarkTemp.String(), watermarkInsPoint);
+	fSummary = summary;
+	UpdateWatermark(fPlotScale);
+}
 
-		BString watermarkDev(B_TRANSLATE("%device%"));
-		watermarkDev.ReplaceAll("%device%", fDataRepository->ActiveDevice());
+void GraphView::SetDisplayedDevice(int32 device)
+{
+	fDisplayedDevice = device;
+	fCurrentValues = HistoryFor(device);
 
-		BFont watermarkDevFont(be_plain_font);
-		watermarkDevFont.SetSize(calculateX(stringProportion));
+	InvalidateLayers();
+}
 
-		BPoint watermarkDevInsert(backgroundFrame.right - (StringWidth(watermarkDev.String()) / 2) - 10,
-			backgroundFrame.bottom - 12);
+void GraphView::SetHistoryStore(HistoryStore* store)
+{
+	fHistoryStore = store;
+	for(int32 i = HISTORY_RAW + 1; i < HISTORY_RESOLUTION_COUNT; i++)
+		fResolutionMenu->ItemAt(i)->SetEnabled(store != NULL);
+	MarkResolution();
 
-		SetFont(&watermarkDevFont);
+	InvalidateLayers();
+}
 
-		DrawString(watermarkDev.String(), watermarkDevInsert);
+void GraphView::Draw(BRect updateRect)
+{
+	if(!fLayersValid)
+		BuildLayers();
 
-		SetDrawingMode(oldDwMode);
+	if(fBackgroundLayer == NULL) {
+		SetHighUIColor(B_DOCUMENT_BACKGROUND_COLOR);
+		FillRect(updateRect);
+		return;
 	}
 
-	float midPointHeight = backgroundFrame.Height() / 2;
-	BPoint midPointStart(backgroundFrame.left, midPointHeight);
-	BPoint midPointEnd(backgroundFrame.Width() + 1, midPointHeight);
-
-	SetHighUIColor(B_CONTROL_BORDER_COLOR);
-	StrokeLine(midPointStart, midPointEnd);
-	MovePenTo(midPointStart);
-
-	SetHighColor(fLineColor);
-	SetPenSize(4.0f);
-	MovePenTo(BPoint(Bounds().left, Bounds().Height() - (fCurrentValues[0] * Bounds().Height() / 100)));
+	// Both layers match the view, so only the exposed part is copied
+	DrawBitmap(fBackgroundLayer, updateRect, updateRect);
 
-	BeginLineArray(fMaxDataPoints - 1);
-	for(int i = 0; i < fMaxDataPoints; i++)
-		AddLine(BPoint(calculateX(i), calculateY(fCurrentValues[i])),
-			BPoint(calculateX(i + 1), calculateY(fCurrentValues[i + 1])), HighColor());
-	EndLineArray();
+	if(fDataRepository->WatermarkVisibility())
+		DrawWatermark(updateRect);
 
-	// Invalidate();
+	SetDrawingMode(B_OP_ALPHA);
+	SetBlendingMode(B_PIXEL_ALPHA, B_ALPHA_OVERLAY);
+	DrawBitmap(fPlotLayer, updateRect, updateRect);
+	SetDrawingMode(B_OP_COPY);
 }
 
 void GraphView::MouseDown(BPoint where)
@@ -326,22 +406,19 @@ void GraphView::FrameResized(float newWidth, float newHeight)
 {
     BView::FrameResized(newWidth, newHeight);
 
-    Invalidate();
+    InvalidateLayers();
 }
 
 // #pragma mark - Private
 
 void GraphView::InitGraphView()
 {
-	fDataPoints = new int[fMaxDataPoints];
-	fCurrentValues = new float[fMaxDataPoints];
-	for(int i = 0; i < fMaxDataPoints; i++) {
-		fDataPoints[i] = 0;
-		fCurrentValues[i] = 0.0f;
-	}
+	fCurrentValues = HistoryFor(fDisplayedDevice);
 
-	SetViewUIColor(B_DOCUMENT_BACKGROUND_COLOR);
+	// Draw() covers every pixel from the layers
+	SetViewColor(B_TRANSPARENT_COLOR);
 	fLineColor = fDataRepository->LineColor();
+	SetPlotScale(fDataRepository->TemperatureScale());
 
 	SetExplicitMinSize(BSize(50, 50));
 
@@ -365,6 +442,352 @@ void GraphView::InitDragger()
 	AddChild(graphDragger);
 }
 
+GraphView::History* GraphView::HistoryFor(int32 device)
+{
+	auto found = fHistories.find(device);
+	if(found != fHistories.end())
+		return found->second;
+
+	History* history = new History;
+	fHistories[device] = history;
+	return history;
+}
+
+void GraphView::InvalidateLayers()
+{
+	fLayersValid = false;
+	Invalidate();
+}
+
+void GraphView::BuildLayers()
+{
+	BRect bounds(Bounds());
+	bounds.OffsetTo(0, 0);
+	if(fBackgroundLayer == NULL || fBackgroundLayer->Bounds() != bounds) {
+		delete fBackgroundLayer;
+		delete fPlotLayer;
+		fBackgroundLayer = new BBitmap(bounds, B_BITMAP_ACCEPTS_VIEWS, B_RGB32);
+		fPlotLayer = new BBitmap(bounds, B_BITMAP_ACCEPTS_VIEWS, B_RGBA32);
+		if(fBackgroundLayer->InitCheck() != B_OK || fPlotLayer->InitCheck() != B_OK) {
+			delete fBackgroundLayer;
+			delete fPlotLayer;
+			fBackgroundLayer = fPlotLayer = NULL;
+			return;
+		}
+		fBackgroundLayer->AddChild(new BView(bounds, "background", B_FOLLOW_NONE, B_WILL_DRAW));
+		fPlotLayer->AddChild(new BView(bounds, "plot", B_FOLLOW_NONE, B_WILL_DRAW));
+
+		fWatermarkTempFont = be_plain_font;
+		fWatermarkTempFont.SetSize(bounds.Width() * kTemperatureFontScale);
+		fWatermarkDevFont = be_plain_font;
+		fWatermarkDevFont.SetSize(bounds.Width() * kDeviceFontScale);
+	}
+
+	// The resolution may have changed without the size
+	LayoutPlotColumns(std::max(1.0f, bounds.Width()));
+	DrawBackgroundLayer();
+	DrawPlotLayer();
+
+	// The whole view is being redrawn already
+	for(int32 i = 0; i < WATERMARK_COUNT; i++)
+		fWatermark[i].text = "";
+	UpdateWatermark(fPlotScale);
+	fLayersValid = true;
+}
+
+void GraphView::DrawBackgroundLayer()
+{
+	fBackgroundLayer->Lock();
+	BView* view = fBackgroundLayer->ChildAt(0);
+	BRect bounds(view->Bounds());
+
+	view->SetHighColor(ui_color(B_DOCUMENT_BACKGROUND_COLOR));
+	view->FillRect(bounds);
+
+	view->SetHighColor(ui_color(B_CONTROL_BORDER_COLOR));
+	view->SetPenSize(2.0f);
+	view->StrokeRect(bounds);
+
+	BRect backgroundFrame(bounds.InsetByCopy(2.0f, 2.0f));
+	float midPointHeight = backgroundFrame.Height() / 2;
+	view->StrokeLine(BPoint(backgroundFrame.left, midPointHeight),
+		BPoint(backgroundFrame.Width() + 1, midPointHeight));
+
+	view->Sync();
+	fBackgroundLayer->Unlock();
+}
+
+void GraphView::LayoutPlotColumns(float width)
+{
+	// As many columns as fit the width, each folding as many points as it
+	//	takes for them to span all the source holds: the graph's own
+	//	samples, or the whole of a tier of the store.
+	size_t span = PlotsHistoryStore()
+		? fHistoryStore->Capacity(fDataRepository->GraphResolution()) : kGraphHistorySize;
+	size_t columns = std::max<size_t>(1, std::min<size_t>(width / kGraphColumnWidth,
+		kGraphHistorySize - 2));
+	size_t bucketSize = std::max<size_t>(1, span / columns);
+	columns = std::max<size_t>(1, std::min(columns, span / bucketSize));
+
+	fPlotColumns.SetBucketSize(bucketSize);
+	fColumnWidth = std::max(1.0f, floorf(width / columns));
+
+	// Enough columns to fill the width, plus one entering from the left
+	fVisibleColumns = std::min<int>(width / fColumnWidth + 2, kGraphHistorySize);
+}
+
+void GraphView::FillPlotColumns()
+{
+	fPlotColumns.MakeEmpty();
+	if(!PlotsHistoryStore()) {
+		// The newest samples, converted to the plotted scale in one pass
+		size_t count = std::min(fCurrentValues->Count(),
+			fVisibleColumns * fPlotColumns.BucketSize());
+		fPlotValues.resize(count);
+		fCurrentValues->ForEachLast(count, [this](size_t i, float value) {
+			fPlotValues[i] = value;
+		});
+		ConvertSpan(fPlotValues.data(), fPlotValues.data(), count, SCALE_CELSIUS, fPlotScale);
+		for(size_t i = 0; i < count; i++)
+			fPlotColumns.Push(fPlotValues[i]);
+		return;
+	}
+
+	// The newest buckets that fill the view, the open one included
+	HistoryResolution resolution = fDataRepository->GraphResolution();
+	bigtime_t length = HistoryStore::BucketLength(resolution);
+	bigtime_t now = system_time();
+	fNewestBucket = now - now % length;
+
+	size_t wanted = std::min(fVisibleColumns * fPlotColumns.BucketSize(),
+		fHistoryStore->Capacity(resolution));
+	std::vector<HistoryPoint> points(wanted);
+	size_t count = fHistoryStore->Query(fDisplayedDevice, resolution,
+		fNewestBucket - static_cast<bigtime_t>(wanted - 1) * length, points.data(), wanted);
+
+	// Every mean, minimum and maximum converted in one pass
+	fPlotValues.resize(count * 3);
+	for(size_t i = 0; i < count; i++) {
+		fPlotValues[i * 3] = points[i].mean;
+		fPlotValues[i * 3 + 1] = points[i].minimum;
+		fPlotValues[i * 3 + 2] = points[i].maximum;
+	}
+	ConvertSpan(fPlotValues.data(), fPlotValues.data(), count * 3, SCALE_CELSIUS, fPlotScale);
+	for(size_t i = 0; i < count; i++) {
+		const float* value = &fPlotValues[i * 3];
+		PlotColumns::Column point = { value[0], value[0], value[1], value[2] };
+		fPlotColumns.Push(point);
+	}
+}
+
+void GraphView::SetPlotScale(char scale)
+{
+	// The plot keeps showing 0 to 100 °C, only the values it holds change
+	fPlotScale = scale;
+	fPlotBottom = ConvertToScale(0.0f, SCALE_CELSIUS, scale);
+	fPlotTop = ConvertToScale(100.0f, SCALE_CELSIUS, scale);
+
+	InvalidateLayers();
+}
+
+bool GraphView::PlotsHistoryStore() const
+{
+	return fHistoryStore != NULL && fDataRepository->GraphResolution() != HISTORY_RAW;
+}
+
+void GraphView::DrawPlotLayer()
+{
+	FillPlotColumns();
+
+	fPlotLayer->Lock();
+	BView* view = fPlotLayer->ChildAt(0);
+	BRect bounds(view->Bounds());
+
+	view->SetDrawingMode(B_OP_COPY);
+	view->SetHighColor(B_TRANSPARENT_COLOR);
+	view->FillRect(bounds);
+
+	// The newest column sits on the right edge
+	int visible = std::min<int>(fPlotColumns.Count(), fVisibleColumns);
+	if(visible > 0) {
+		SetPlotPen(view);
+
+		PlotColumns::Column previous;
+		view->BeginLineArray(visible * 2);
+		fPlotColumns.ForEachLast(visible, [&](size_t i, const PlotColumns::Column& column) {
+			AddColumnLines(view, i > 0 ? &previous : NULL, column,
+				bounds.right - (visible - 1 - i) * fColumnWidth);
+			previous = column;
+		});
+		view->EndLineArray();
+	}
+
+	view->Sync();
+	fPlotLayer->Unlock();
+}
+
+BRect GraphView::UpdatePlotLayer(float temperature)
+{
+	// A pending rebuild picks the sample up anyway
+	if(!fLayersValid || fPlotLayer == NULL)
+		return BRect();
+
+	// The same conversion as the rebuild's, so the two agree to the bit
+	bool newColumn = fPlotColumns.Push(ConvertToScale(temperature, SCALE_CELSIUS, fPlotScale));
+	size_t count = fPlotColumns.Count();
+
+	fPlotLayer->Lock();
+	BView* view = fPlotLayer->ChildAt(0);
+	BRect bounds(view->Bounds());
+	float right = bounds.right;
+
+	// Everything moves one column left when one is completed, otherwise
+	//	only the newest column changed.
+	if(newColumn) {
+		view->CopyBits(BRect(bounds.left + fColumnWidth, bounds.top, right, bounds.bottom),
+			BRect(bounds.left, bounds.top, right - fColumnWidth, bounds.bottom));
+	}
+
+	view->SetDrawingMode(B_OP_COPY);
+	view->SetHighColor(B_TRANSPARENT_COLOR);
+	view->FillRect(BRect(right - fColumnWidth + 1, bounds.top, right, bounds.bottom));
+
+	// The previous column is stroked again as its pen overlaps the strip
+	SetPlotPen(view);
+	view->BeginLineArray(4);
+	PlotColumns::Column column = fPlotColumns.ColumnAt(count - 1);
+	if(count > 1) {
+		PlotColumns::Column previous = fPlotColumns.ColumnAt(count - 2);
+		if(count > 2) {
+			PlotColumns::Column beforePrevious = fPlotColumns.ColumnAt(count - 3);
+			AddColumnLines(view, &beforePrevious, previous, right - fColumnWidth);
+		}
+		else
+			AddColumnLines(view, NULL, previous, right - fColumnWidth);
+		AddColumnLines(view, &previous, column, right);
+	}
+	else
+		AddColumnLines(view, NULL, column, right);
+	view->EndLineArray();
+
+	view->Sync();
+	fPlotLayer->Unlock();
+
+	if(newColumn)
+		return bounds;
+
+	// Two columns and the pen reaching past them
+	float penSize = 4.0f;
+	return BRect(right - 2 * fColumnWidth - penSize / 2, bounds.top, right, bounds.bottom);
+}
+
+void GraphView::SetPlotPen(BView* view)
+{
+	// Compose onto the transparent layer, keeping its alpha
+	view->SetDrawingMode(B_OP_ALPHA);
+	view->SetBlendingMode(B_CONSTANT_ALPHA, B_ALPHA_COMPOSITE);
+	view->SetHighColor(fLineColor);
+	view->SetPenSize(4.0f);
+}
+
+void GraphView::AddColumnLines(BView* view, const PlotColumns::Column* previous,
+	const PlotColumns::Column& column, float x)
+{
+	// The join from the previous column, then the range of this one
+	if(previous) {
+		view->AddLine(BPoint(x - fColumnWidth, PlotY(previous->last)),
+			BPoint(x, PlotY(column.first)), fLineColor);
+	}
+	if(column.max > column.min || !previous)
+		view->AddLine(BPoint(x, PlotY(column.min)), BPoint(x, PlotY(column.max)), fLineColor);
+}
+
+float GraphView::PlotY(float temperature) const
+{
+	float height = Bounds().Height();
+	return height - (((temperature - fPlotBottom) * height) / (fPlotTop - fPlotBottom));
+}
+
+void GraphView::UpdateWatermark(char scale)
+{
+	BRect backgroundFrame(Bounds().InsetByCopy(2.0f, 2.0f));
+
+	auto formatTemperature = [&](float celsius) {
+		BString string;
+		fNumberFormat.Format(string,
+			ConvertToScale(static_cast<double>(celsius), SCALE_CELSIUS, scale));
+		return string;
+	};
+
+	BString watermarkTemp(B_TRANSLATE("%temperature% %scale%"));
+	watermarkTemp.ReplaceAll("%temperature%", formatTemperature(fCurrentValues->Last(0.0f)));
+	watermarkTemp.ReplaceAll("%scale%", SymbolForScale(scale));
+	SetWatermarkText(WATERMARK_TEMPERATURE, watermarkTemp,
+		BPoint(backgroundFrame.left + 10, backgroundFrame.bottom - 12), false);
+
+	BString watermarkDev(B_TRANSLATE("%device%"));
+	watermarkDev.ReplaceAll("%device%", fDataRepository->ActiveDevice());
+	SetWatermarkText(WATERMARK_DEVICE, watermarkDev,
+		BPoint(backgroundFrame.right - 10, backgroundFrame.bottom - 12), true);
+
+	BString watermarkStats;
+	if(fSummary.count > 0) {
+		watermarkStats = B_TRANSLATE("min %min% · max %max% · p95 %p95%");
+		watermarkStats.ReplaceAll("%min%", formatTemperature(fSummary.minimum));
+		watermarkStats.ReplaceAll("%max%", formatTemperature(fSummary.maximum));
+		watermarkStats.ReplaceAll("%p95%", formatTemperature(fSummary.quantiles[QUANTILE_P95]));
+	}
+	font_height height;
+	WatermarkFont(WATERMARK_STATISTICS).GetHeight(&height);
+	SetWatermarkText(WATERMARK_STATISTICS, watermarkStats,
+		BPoint(backgroundFrame.left + 10, backgroundFrame.top + 8 + ceilf(height.ascent)), false);
+}
+
+void GraphView::SetWatermarkText(int32 which, const BString& text, BPoint where,
+	bool alignRight)
+{
+	WatermarkText& watermark = fWatermark[which];
+	if(text == watermark.text)
+		return;
+
+	const BFont& font = WatermarkFont(which);
+	float width = ceilf(font.StringWidth(text.String()));
+	if(alignRight)
+		where.x -= width;
+
+	font_height height;
+	font.GetHeight(&height);
+
+	BRect oldFrame(watermark.frame);
+	watermark.text = text;
+	watermark.where = where;
+	watermark.frame = BRect(where.x, where.y - ceilf(height.ascent),
+		where.x + width, where.y + ceilf(height.descent));
+
+	if(fDataRepository->WatermarkVisibility() && fLayersValid)
+		Invalidate(oldFrame.IsValid() ? oldFrame | watermark.frame : watermark.frame);
+}
+
+const BFont& GraphView::WatermarkFont(int32 which) const
+{
+	return which == WATERMARK_TEMPERATURE ? fWatermarkTempFont : fWatermarkDevFont;
+}
+
+void GraphView::DrawWatermark(BRect updateRect)
+{
+	SetHighUIColor(B_CONTROL_BORDER_COLOR, B_DARKEN_2_TINT);
+	SetDrawingMode(B_OP_COPY);
+
+	for(int32 i = 0; i < WATERMARK_COUNT; i++) {
+		const WatermarkText& watermark = fWatermark[i];
+		if(watermark.text.IsEmpty() || !watermark.frame.Intersects(updateRect))
+			continue;
+
+		SetFont(&WatermarkFont(i));
+		DrawString(watermark.text.String(), watermark.where);
+	}
+}
+
 #undef B_TRANSLATION_CONTEXT
 #define B_TRANSLATION_CONTEXT "Graph menu"
 
@@ -374,27 +797,57 @@ BPopUpMenu* GraphView::BuildPopUpMenu()
 	BLayoutBuilder::Menu<>(menu)
 		.AddItem(B_TRANSLATE("Pause"), M_GRAPHVIEW_PAUSE)
 		.AddMenu(fRefreshRateMenu = new BMenu(B_TRANSLATE("Refresh rate"))).End()
+		.AddMenu(fResolutionMenu = new BMenu(B_TRANSLATE("Resolution"))).End()
 		.AddSeparator()
 		.AddMenu(fTemperatureScaleMenu = new BMenu(B_TRANSLATE("Scale"))).End()
 		.AddItem(B_TRANSLATE("Show watermark"), M_GRAPHVIEW_WATERMARK)
 	.End();
 
-	for(uint32 i = 1; i <= 5; i++) {
+	for(int32 i = 0; i < kRefreshIntervalCount; i++) {
 		BString menuItemName;
-		static BStringFormat format(B_TRANSLATE(
+		static BStringFormat secondsFormat(B_TRANSLATE(
 			"{0, plural,"
 			"=1{# second}"
 			"other{# seconds}}"
 		));
-		format.Format(menuItemName, static_cast<long>(i));
+		static BStringFormat millisecondsFormat(B_TRANSLATE(
+			"{0, plural,"
+			"=1{# millisecond}"
+			"other{# milliseconds}}"
+		));
+		bigtime_t interval = kRefreshIntervals[i];
+		if(interval % 1000000 == 0)
+			secondsFormat.Format(menuItemName, static_cast<long>(interval / 1000000));
+		else
+			millisecondsFormat.Format(menuItemName, static_cast<long>(interval / 1000));
 
 		BMessage* message = new BMessage(M_REFRESH_RATE);
-		message->AddUInt32("rate", i);
-		fRefreshRateMenu->AddItem(new BMenuItem(menuItemName, message));
+		message->AddInt64("interval", interval);
+		BMenuItem* item = new BMenuItem(menuItemName, message);
+		item->SetMarked(interval == fDataRepository->RefreshInterval());
+		fRefreshRateMenu->AddItem(item);
 	}
-	int32 rate = fDataRepository->RefreshRate();
-	if(rate > 0 && rate <= 5)
-		fRefreshRateMenu->ItemAt(rate - 1)->SetMarked(true);
+
+	fRefreshRateMenu->AddSeparatorItem();
+	BMenuItem* adaptiveItem = new BMenuItem(B_TRANSLATE("Adaptive"),
+		new BMessage(M_ADAPTIVE_SAMPLING));
+	adaptiveItem->SetMarked(fDataRepository->AdaptiveSampling());
+	fRefreshRateMenu->AddItem(adaptiveItem);
+
+	// The minute and hour tiers come from the window's history store
+	const char* resolutionLabels[HISTORY_RESOLUTION_COUNT] = {
+		B_TRANSLATE("Samples"),
+		B_TRANSLATE("Minutes"),
+		B_TRANSLATE("Hours")
+	};
+	for(int32 i = 0; i < HISTORY_RESOLUTION_COUNT; i++) {
+		BMessage* message = new BMessage(M_GRAPHVIEW_RESOLUTION);
+		message->AddInt32("resolution", i);
+		BMenuItem* item = new BMenuItem(resolutionLabels[i], message);
+		item->SetEnabled(i == HISTORY_RAW);
+		fResolutionMenu->AddItem(item);
+	}
+	MarkResolution();
 
 	BMessage* scaleMessage = new BMessage(M_SCALE_CHANGED);
 	auto c = SCALE_CELSIUS;
@@ -414,3 +867,10 @@ BPopUpMenu* GraphView::BuildPopUpMenu()
 
 	return menu;
 }
+
+void GraphView::MarkResolution()
+{
+	int32 shown = PlotsHistoryStore() ? fDataRepository->GraphResolution() : HISTORY_RAW;
+	for(int32 i = 0; i < HISTORY_RESOLUTION_COUNT; i++)
+		fResolutionMenu->ItemAt(i)->SetMarked(i == shown);
+}
@@ -5,27 +5,48 @@
 #ifndef __TEMPERATURE_GRAPH__
 #define __TEMPERATURE_GRAPH__
 
+#include <Bitmap.h>
+#include <Font.h>
+#include <NumberFormat.h>
 #include <PopUpMenu.h>
 #include <View.h>
-#include <queue>
+#include <map>
+#include <vector>
+#include "ColumnDecimator.h"
 #include "DataFactory.h"
+#include "RollingStatistics.h"
+#include "SampleFeed.h"
+#include "SampleRing.h"
 #include "ThermalDevice.h"
 
+#define kGraphHistorySize 1024
+#define kGraphColumnWidth 2.0f	// narrowest plotted column, in pixels
+
 class GraphView : public BView
 {
 public:
+	typedef SampleRing<float, kGraphHistorySize> History;
+	typedef ColumnDecimator<kGraphHistorySize> PlotColumns;
+
 	GraphView(DataFactory* dataRepo);
 	GraphView(BMessage* archive);
 	~GraphView() override;
 
 	void AttachedToWindow() override;
+	void DetachedFromWindow() override;
 	void MessageReceived(BMessage* message) override;
-	void Pulse() override;
 	void Draw(BRect updateRect) override;
 	void MouseDown(BPoint where) override;
     void FrameMoved(BPoint newPosition) override;
     void FrameResized(float newWidth, float newHeight) override;
 
+	void AddSample(int32 device, float temperature, bigtime_t when);
+	void SetDisplayedDevice(int32 device);
+	// Hosted graphs can plot the minute and hour tiers of the window's store
+	void SetHistoryStore(HistoryStore* store);
+	// Hosted graphs are given the statistics of the displayed device
+	void SetSummary(const RollingSummary& summary);
+
 	status_t Archive(BMessage* into, bool deep = true) const override;
 	static GraphView* Instantiate(BMessage* archive);
 protected:
@@ -34,19 +55,78 @@ private:
 	void InitUIData(BMessage* settings);
 	void InitGraphView();
 	void InitDragger();
+	History* HistoryFor(int32 device);
 	BPopUpMenu* BuildPopUpMenu();
+	void MarkResolution();
+
+	// Border and midline are rendered once into fBackgroundLayer, the line
+	//	into fPlotLayer, which is scrolled in place as columns complete.
+	void InvalidateLayers();
+	void BuildLayers();
+	void DrawBackgroundLayer();
+	void LayoutPlotColumns(float width);
+	void FillPlotColumns();
+	void SetPlotScale(char scale);
+	bool PlotsHistoryStore() const;
+	void DrawPlotLayer();
+	BRect UpdatePlotLayer(float temperature);
+	void SetPlotPen(BView* view);
+	void AddColumnLines(BView* view, const PlotColumns::Column* previous,
+		const PlotColumns::Column& column, float x);
+	float PlotY(float temperature) const;
+
+	// The watermark is drawn straight into the view between the layers;
+	//	its text and frames are kept so partial updates can skip it.
+	enum {
+		WATERMARK_TEMPERATURE = 0,
+		WATERMARK_DEVICE,
+		WATERMARK_STATISTICS,
+		WATERMARK_COUNT
+	};
+	struct WatermarkText {
+		BString		text;
+		BPoint		where;
+		BRect		frame;
+	};
+
+	void UpdateWatermark(char scale);
+	void SetWatermarkText(int32 which, const BString& text, BPoint where,
+		bool alignRight);
+	const BFont& WatermarkFont(int32 which) const;
+	void DrawWatermark(BRect updateRect);
 private:
 	bool		fStandaloneMode;
-	int			fMaxDataPoints;
-	int*		fDataPoints;
-	float*		fCurrentValues;
+	History*	fCurrentValues;
+	std::map<int32, History*> fHistories;
+	HistoryStore* fHistoryStore;	// not owned, NULL for replicants
+	bigtime_t	fNewestBucket;		// start of the newest store bucket plotted
+	int32		fDisplayedDevice;
 	rgb_color	fLineColor;
 
+	BBitmap*	fBackgroundLayer;
+	BBitmap*	fPlotLayer;
+	bool		fLayersValid;
+	PlotColumns	fPlotColumns;	// displayed history, one bucket per column
+	std::vector<float> fPlotValues;	// rebuild scratch, in the plotted scale
+	char		fPlotScale;
+	float		fPlotBottom;	// 0 and 100 °C in the plotted scale
+	float		fPlotTop;
+	float		fColumnWidth;	// whole pixels, so scrolling stays exact
+	int			fVisibleColumns;
+
+	BNumberFormat fNumberFormat;
+	BFont		fWatermarkTempFont;
+	BFont		fWatermarkDevFont;
+	WatermarkText fWatermark[WATERMARK_COUNT];
+
+	RollingStatistics* fStatistics;	// standalone only
+	RollingSummary fSummary;
+
 	DataFactory* fDataRepository;
-	ThermalDevice* fStandaloneDevice;
 
 	BPopUpMenu* fGraphMenu;
 	BMenu*		fRefreshRateMenu;
+	BMenu*		fResolutionMenu;
 	BMenu*		fTemperatureScaleMenu;
 };
 
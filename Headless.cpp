@@ -0,0 +1,424 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "Headless.h"
+#include "SampleArea.h"
+#include "SampleLog.h"
+#include "SamplerEngine.h"
+#include "ThermalDevice.h"
+
+static volatile sig_atomic_t sQuitRequested = 0;
+
+static void
+HandleQuitSignal(int /* signal */)
+{
+	sQuitRequested = 1;
+}
+
+static const char*
+StatusString(status_t status)
+{
+#ifdef __HAIKU__
+	return strerror(status);
+#else
+	return strerror(-status);
+#endif
+}
+
+static void
+FormatTemperature(const ThermalSnapshot& snapshot, DeviceTemperature which,
+	char* buffer, size_t size)
+{
+	if(snapshot.IsReported(which))
+		snprintf(buffer, size, "%.2f", snapshot.Temperature(which));
+	else
+		snprintf(buffer, size, "-");
+}
+
+static int
+PrintDevices(const std::vector<ThermalDevice*>& devices)
+{
+	int result = 0;
+	for(ThermalDevice* device : devices) {
+		ThermalSnapshot snapshot;
+		status_t status = device->ReadSnapshot(&snapshot);
+		if(status != B_OK) {
+			fprintf(stderr, "%s: %s\n", device->Location(), StatusString(status));
+			result = 1;
+			continue;
+		}
+
+		char current[16];
+		char critical[16];
+		char hot[16];
+		FormatTemperature(snapshot, TEMPERATURE_CURRENT, current, sizeof(current));
+		FormatTemperature(snapshot, TEMPERATURE_CRITICAL, critical, sizeof(critical));
+		FormatTemperature(snapshot, TEMPERATURE_HOT, hot, sizeof(hot));
+		printf("%s\t%s\t%s\t%s\n", device->Location(), current, critical, hot);
+	}
+
+	return result;
+}
+
+static int
+SampleDevices(const HeadlessOptions& options, const std::vector<ThermalDevice*>& devices,
+	const std::vector<int32>& ids)
+{
+	SampleLog log;
+	if(options.mode == HEADLESS_DAEMON) {
+		if(options.logDirectory == NULL) {
+			fprintf(stderr, "No sample log directory given\n");
+			return 1;
+		}
+
+		int status = log.Open(options.logDirectory);
+		if(status != 0) {
+			fprintf(stderr, "Could not open the sample log in %s: %s\n",
+				options.logDirectory, strerror(status));
+			return 1;
+		}
+		for(size_t i = 0; i < devices.size(); i++)
+			log.RegisterDevice(ids[i], devices[i]->Location());
+	}
+
+	// Other programs read the samples from there, as when the window runs
+	SampleArea area;
+	status_t status = area.Init();
+	if(status == B_OK) {
+		for(size_t i = 0; i < devices.size(); i++)
+			area.RegisterDevice(ids[i], devices[i]->Location());
+	}
+	else if(status == B_BUSY)
+		fprintf(stderr, "Another sampler already publishes the shared samples\n");
+	else
+		fprintf(stderr, "Could not create the shared sample area\n");
+
+	// The same engine as the window's, each device read on its own deadline
+	bigtime_t interval = options.interval > 0 ? options.interval : kDefaultRefreshInterval;
+	AdaptivePolicy policy;
+	policy.fastest = std::min((bigtime_t)kDefaultAdaptiveFastest, interval);
+	policy.slowest = std::max((bigtime_t)kDefaultAdaptiveSlowest, interval);
+	policy.slope = kDefaultAdaptiveSlope;
+	policy.margin = kDefaultAdaptiveMargin;
+
+	SamplerEngine engine;
+	for(size_t i = 0; i < devices.size(); i++) {
+		engine.AddDevice(ids[i], devices[i]->Location(), interval);
+		if(options.adaptive)
+			engine.SetAdaptive(ids[i], &policy);
+	}
+
+	signal(SIGINT, HandleQuitSignal);
+	signal(SIGTERM, HandleQuitSignal);
+
+	status = engine.Start();
+	if(status != B_OK) {
+		fprintf(stderr, "Could not start sampling: %s\n", StatusString(status));
+		return 1;
+	}
+
+	// Reads of each device, --count of every one of them ends the run
+	std::vector<int32> reads(devices.size(), 0);
+	size_t finished = 0;
+	bigtime_t lastSync = system_time();
+	while(!sQuitRequested && (options.count == 0 || finished < devices.size())) {
+		if(engine.WaitForSamples(100000) != B_OK)
+			continue;
+
+		// Snapshots carry system time, the output and the log wall clock time
+		bigtime_t offset = real_time_clock_usecs() - system_time();
+		ThermalSample sample;
+		while(engine.PopSample(&sample)) {
+			size_t i = std::find(ids.begin(), ids.end(), sample.device) - ids.begin();
+			if(i == ids.size())
+				continue;
+			if(options.count > 0 && ++reads[i] == options.count)
+				finished++;
+			if(options.count > 0 && reads[i] > options.count)
+				continue;
+
+			const ThermalSnapshot& snapshot = sample.snapshot;
+			if(sample.status != B_OK || !snapshot.IsReported(TEMPERATURE_CURRENT))
+				continue;
+
+			area.Publish(ids[i], snapshot);
+
+			float temperature = snapshot.Temperature(TEMPERATURE_CURRENT);
+			bigtime_t when = snapshot.timestamp + offset;
+			if(options.mode == HEADLESS_STREAM) {
+				printf("%lld.%03lld\t%s\t%.2f\n", (long long)(when / 1000000),
+					(long long)(when % 1000000 / 1000), devices[i]->Location(), temperature);
+			}
+			else
+				log.Append(ids[i], when, temperature);
+		}
+
+		bigtime_t now = system_time();
+		if(options.mode == HEADLESS_STREAM)
+			fflush(stdout);
+		else if(now - lastSync > 60000000) {
+			log.Sync();
+			lastSync = now;
+		}
+	}
+	engine.Stop();
+	log.Close();
+
+	for(size_t i = 0; i < devices.size(); i++) {
+		SamplerMetrics metrics;
+		if(engine.GetMetrics(ids[i], &metrics) != B_OK || metrics.missed == 0)
+			continue;
+
+		fprintf(stderr, "%s: %llu reads missed their deadline, up to %lld microseconds late\n",
+			devices[i]->Location(), (unsigned long long)metrics.missed,
+			(long long)metrics.maxLateness);
+	}
+	return 0;
+}
+
+static int
+ExportSamples(const HeadlessOptions& options)
+{
+	if(options.logDirectory == NULL) {
+		fprintf(stderr, "No sample log directory given\n");
+		return 1;
+	}
+
+	int fd = STDOUT_FILENO;
+	if(options.output != NULL) {
+		fd = open(options.output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if(fd < 0) {
+			fprintf(stderr, "Could not create %s: %s\n", options.output, strerror(errno));
+			return 1;
+		}
+	}
+
+	uint64_t count = 0;
+	int status = ExportSampleLog(options.logDirectory, fd, options.exportFormat,
+		options.since, options.until, options.device, &count);
+	if(options.output != NULL && close(fd) != 0 && status == 0)
+		status = errno;
+	if(status != 0) {
+		fprintf(stderr, "Could not export the sample log in %s: %s\n",
+			options.logDirectory, strerror(status));
+		return 1;
+	}
+
+	if(options.output != NULL)
+		fprintf(stderr, "%llu samples exported\n", (unsigned long long)count);
+	return 0;
+}
+
+static status_t
+ParseTime(const char* value, bigtime_t* outTime)
+{
+	char* end = NULL;
+	double seconds = strtod(value, &end);
+	if(end == value || *end != '\0' || seconds < 0 || seconds > LLONG_MAX / 1000000)
+		return B_BAD_VALUE;
+
+	*outTime = static_cast<bigtime_t>(seconds * 1000000);
+	return B_OK;
+}
+
+// #pragma mark - Public
+
+HeadlessOptions::HeadlessOptions()
+:
+mode(HEADLESS_NONE),
+root(kThermalDeviceRoot),
+device(NULL),
+interval(0),
+adaptive(false),
+count(0),
+logDirectory(NULL),
+exportFormat(EXPORT_CSV),
+output(NULL),
+since(0),
+until(LLONG_MAX)
+{
+}
+
+status_t
+ParseHeadlessOptions(int argc, char** argv, HeadlessOptions* outOptions)
+{
+	HeadlessOptions& options = *outOptions;
+	for(int i = 1; i < argc; i++) {
+		const char* argument = argv[i];
+		if(strcmp(argument, "--print") == 0) {
+			options.mode = HEADLESS_PRINT;
+			continue;
+		}
+		if(strcmp(argument, "--stream") == 0) {
+			options.mode = HEADLESS_STREAM;
+			continue;
+		}
+		if(strcmp(argument, "--daemon") == 0) {
+			options.mode = HEADLESS_DAEMON;
+			continue;
+		}
+		if(strcmp(argument, "--adaptive") == 0) {
+			options.adaptive = true;
+			continue;
+		}
+		if(strcmp(argument, "--help") == 0 || strcmp(argument, "-h") == 0) {
+			PrintHeadlessUsage(stdout, argv[0]);
+			exit(0);
+		}
+
+		// Everything else takes a value
+		if(i + 1 == argc)
+			return B_BAD_VALUE;
+		const char* value = argv[++i];
+
+		if(strcmp(argument, "--root") == 0)
+			options.root = value;
+		else if(strcmp(argument, "--device") == 0)
+			options.device = value;
+		else if(strcmp(argument, "--log") == 0)
+			options.logDirectory = value;
+		else if(strcmp(argument, "--export") == 0) {
+			if(SampleExporter::ParseFormat(value, &options.exportFormat) != 0)
+				return B_BAD_VALUE;
+			options.mode = HEADLESS_EXPORT;
+		}
+		else if(strcmp(argument, "--output") == 0)
+			options.output = value;
+		else if(strcmp(argument, "--since") == 0) {
+			if(ParseTime(value, &options.since) != B_OK)
+				return B_BAD_VALUE;
+		}
+		else if(strcmp(argument, "--until") == 0) {
+			if(ParseTime(value, &options.until) != B_OK)
+				return B_BAD_VALUE;
+		}
+		else if(strcmp(argument, "--interval") == 0) {
+			char* end = NULL;
+			double seconds = strtod(value, &end);
+			if(end == value || *end != '\0'
+				|| !(seconds * 1000000 >= kMinimumRefreshInterval) || seconds > 86400)
+				return B_BAD_VALUE;
+			options.interval = static_cast<bigtime_t>(seconds * 1000000);
+		}
+		else if(strcmp(argument, "--count") == 0) {
+			char* end = NULL;
+			long count = strtol(value, &end, 10);
+			if(end == value || *end != '\0' || count < 1)
+				return B_BAD_VALUE;
+			options.count = count;
+		}
+		else
+			return B_BAD_VALUE;
+	}
+
+	return B_OK;
+}
+
+void
+PrintHeadlessUsage(FILE* stream, const char* program)
+{
+	fprintf(stream,
+		"Usage: %s [--print | --stream | --daemon | --export FORMAT] [options]\n"
+		"  --print           print every device once and exit\n"
+		"  --stream          print the current temperature of every device\n"
+		"                    each interval\n"
+		"  --daemon          append samples to the sample log until stopped\n"
+		"  --export FORMAT   write the sample log out as csv, influx (InfluxDB\n"
+		"                    line protocol) or binary\n"
+		"Options:\n"
+		"  --device PATH     only use this device\n"
+		"  --root DIR        look for devices below DIR (default %s)\n"
+		"  --interval SECS   sampling interval in seconds, 0.1 at least\n"
+		"  --adaptive        read faster while the temperature moves or is\n"
+		"                    close to a trip point, slower while it is flat\n"
+		"  --count N         stop after N reads of every device\n"
+		"  --log DIR         sample log directory for --daemon and --export\n"
+		"  --output FILE     export to FILE instead of the standard output\n"
+		"  --since SECS      only export samples taken from SECS on, in seconds\n"
+		"                    since the epoch\n"
+		"  --until SECS      only export samples taken before SECS\n",
+		program, kThermalDeviceRoot);
+}
+
+int
+RunHeadless(const HeadlessOptions& options)
+{
+	// Only the log is read, the devices may not even be there
+	if(options.mode == HEADLESS_EXPORT)
+		return ExportSamples(options);
+
+	// Ids are handed out as DeviceRegistry does, so that the log and the
+	//	shared area use the same ones as the application: the order of the
+	//	scan of the root, then other paths in the order they come.
+	std::vector<std::string> scanned;
+	int32 found = ThermalDevice::FindDevices(options.root,
+		[](const char* path, void* cookie) {
+			static_cast<std::vector<std::string>*>(cookie)->push_back(path);
+		}, &scanned);
+	if(found < 0 && options.device == NULL) {
+		fprintf(stderr, "Could not read %s\n", options.root);
+		return 1;
+	}
+
+	std::vector<std::string> paths(scanned);
+	if(options.device != NULL)
+		paths.assign(1, options.device);
+
+	std::vector<ThermalDevice*> devices;
+	std::vector<int32> ids;
+	for(const std::string& path : paths) {
+		ThermalDevice* device = new ThermalDevice(path.c_str());
+		if(device->InitCheck() != B_OK) {
+			delete device;
+			continue;
+		}
+
+		size_t id = std::find(scanned.begin(), scanned.end(), path) - scanned.begin();
+		if(id == scanned.size())
+			scanned.push_back(path);
+		devices.push_back(device);
+		ids.push_back(id);
+	}
+	if(devices.empty()) {
+		fprintf(stderr, "No thermal devices found\n");
+		return 1;
+	}
+
+	int result = options.mode == HEADLESS_PRINT
+		? PrintDevices(devices) : SampleDevices(options, devices, ids);
+
+	for(ThermalDevice* device : devices)
+		delete device;
+
+	return result;
+}
+
+#ifndef __HAIKU__
+
+int
+main(int argc, char** argv)
+{
+	HeadlessOptions options;
+	if(ParseHeadlessOptions(argc, argv, &options) != B_OK) {
+		PrintHeadlessUsage(stderr, argv[0]);
+		return 1;
+	}
+
+	if(options.mode == HEADLESS_NONE)
+		options.mode = HEADLESS_PRINT;
+
+	return RunHeadless(options);
+}
+
+#endif /* __HAIKU__ */
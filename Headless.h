@@ -0,0 +1,54 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef __HEADLESS__
+#define __HEADLESS__
+
+/*
+ * Command line modes that run without the application server: print every
+ * device once, stream samples, keep a daemon writing to the sample log, or
+ * export what the log holds. Sampling runs on the window's SamplerEngine.
+ * Only that, ThermalDevice, SampleLog, SampleArea and SampleExport are
+ * used, so this also builds without libbe; off Haiku the file provides
+ * main() itself.
+ */
+
+#include <cstdio>
+#include "PlatformDefs.h"
+#include "SampleExport.h"
+
+enum HeadlessMode {
+	HEADLESS_NONE = 0,	// start the application
+	HEADLESS_PRINT,
+	HEADLESS_STREAM,
+	HEADLESS_DAEMON,
+	HEADLESS_EXPORT
+};
+
+struct HeadlessOptions
+{
+	HeadlessMode	mode;
+	const char*		root;			// device tree, kThermalDeviceRoot by default
+	const char*		device;			// NULL for every device
+	bigtime_t		interval;		// 0 until set by the caller or the user
+	bool			adaptive;		// follow the default AdaptivePolicy
+	int32			count;			// reads of every device, 0 for no limit
+	const char*		logDirectory;	// required by the daemon and the export
+	SampleExportFormat exportFormat;
+	const char*		output;			// export file, NULL for the standard output
+	bigtime_t		since;			// exported span, real time in µs
+	bigtime_t		until;
+
+					HeadlessOptions();
+};
+
+// B_OK when the arguments are understood; mode stays HEADLESS_NONE if none
+//	of them picks a headless run.
+status_t	ParseHeadlessOptions(int argc, char** argv, HeadlessOptions* outOptions);
+void		PrintHeadlessUsage(FILE* stream, const char* program);
+
+// Returns the process exit code
+int			RunHeadless(const HeadlessOptions& options);
+
+#endif /* __HEADLESS__ */
@@ -0,0 +1,350 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <Autolock.h>
+#include <algorithm>
+#include "HistoryStore.h"
+
+// #pragma mark - HistorySeries
+
+HistorySeries::HistorySeries(size_t rawCapacity, size_t minuteCapacity,
+	size_t hourCapacity)
+: fNewest(0)
+{
+	size_t capacities[HISTORY_RESOLUTION_COUNT] = {
+		rawCapacity, minuteCapacity, hourCapacity
+	};
+
+	for(int32 i = 0; i < HISTORY_RESOLUTION_COUNT; i++) {
+		fRings[i].capacity = capacities[i] > 0 ? capacities[i] : 1;
+		fRings[i].points = new HistoryPoint[fRings[i].capacity];
+		fRings[i].start = 0;
+		fRings[i].count = 0;
+		fOpen[i].Reset(0);
+	}
+}
+
+HistorySeries::~HistorySeries()
+{
+	for(int32 i = 0; i < HISTORY_RESOLUTION_COUNT; i++)
+		delete[] fRings[i].points;
+}
+
+void
+HistorySeries::Add(bigtime_t when, float value)
+{
+	bigtime_t duration = 0;
+	if(fRings[HISTORY_RAW].count > 0)
+		duration = std::min(when - fNewest, (bigtime_t)kHistoryMaxSampleSpan);
+
+	HistoryPoint point = { when, value, value, value, 1, duration };
+	fRings[HISTORY_RAW].Push(point);
+	fNewest = when;
+
+	RollUp(HISTORY_MINUTE, point);
+}
+
+void
+HistorySeries::MakeEmpty()
+{
+	for(int32 i = 0; i < HISTORY_RESOLUTION_COUNT; i++) {
+		fRings[i].start = 0;
+		fRings[i].count = 0;
+		fOpen[i].Reset(0);
+	}
+	fNewest = 0;
+}
+
+size_t
+HistorySeries::Query(HistoryResolution resolution, bigtime_t since,
+	HistoryPoint* outPoints, size_t maxPoints) const
+{
+	if(resolution < 0 || resolution >= HISTORY_RESOLUTION_COUNT
+		|| !outPoints || maxPoints == 0)
+		return 0;
+
+	// A bucket is part of the answer when any of it is newer than since
+	bigtime_t length = HistoryStore::BucketLength(resolution);
+	const Ring& ring = fRings[resolution];
+	const Bucket& open = fOpen[resolution];
+	bool withOpen = resolution != HISTORY_RAW && open.count > 0
+		&& open.start + length > since;
+
+	size_t first = ring.FindFirst(since - length + 1);
+	size_t available = ring.count - first + (withOpen ? 1 : 0);
+
+	// Keep the newest points when the caller has no room for all of them;
+	//	as maxPoints > 0 only ring points are ever skipped.
+	if(available > maxPoints)
+		first += available - maxPoints;
+
+	size_t count = 0;
+	for(size_t i = first; i < ring.count && count < maxPoints; i++)
+		outPoints[count++] = ring.At(i);
+	if(withOpen && count < maxPoints)
+		outPoints[count++] = open.ToPoint();
+
+	return count;
+}
+
+size_t
+HistorySeries::Count(HistoryResolution resolution) const
+{
+	if(resolution < 0 || resolution >= HISTORY_RESOLUTION_COUNT)
+		return 0;
+
+	return fRings[resolution].count + (fOpen[resolution].count > 0 ? 1 : 0);
+}
+
+size_t
+HistorySeries::CountSince(HistoryResolution resolution, bigtime_t since) const
+{
+	if(resolution < 0 || resolution >= HISTORY_RESOLUTION_COUNT)
+		return 0;
+
+	// As in Query()
+	bigtime_t length = HistoryStore::BucketLength(resolution);
+	const Ring& ring = fRings[resolution];
+	const Bucket& open = fOpen[resolution];
+	bool withOpen = resolution != HISTORY_RAW && open.count > 0
+		&& open.start + length > since;
+
+	return ring.count - ring.FindFirst(since - length + 1) + (withOpen ? 1 : 0);
+}
+
+bigtime_t
+HistorySeries::Oldest(HistoryResolution resolution) const
+{
+	if(resolution < 0 || resolution >= HISTORY_RESOLUTION_COUNT)
+		return -1;
+
+	const Ring& ring = fRings[resolution];
+	if(ring.count > 0)
+		return ring.At(0).timestamp;
+
+	return fOpen[resolution].count > 0 ? fOpen[resolution].start : -1;
+}
+
+bigtime_t
+HistorySeries::Newest() const
+{
+	return fNewest;
+}
+
+void
+HistorySeries::RollUp(int32 tier, const HistoryPoint& point)
+{
+	if(tier >= HISTORY_RESOLUTION_COUNT)
+		return;
+
+	bigtime_t length = HistoryStore::BucketLength(static_cast<HistoryResolution>(tier));
+	bigtime_t bucketStart = point.timestamp - point.timestamp % length;
+
+	Bucket& bucket = fOpen[tier];
+	if(bucket.count > 0 && bucket.start != bucketStart) {
+		HistoryPoint closed = bucket.ToPoint();
+		fRings[tier].Push(closed);
+		RollUp(tier + 1, closed);
+		bucket.Reset(bucketStart);
+	}
+	else if(bucket.count == 0)
+		bucket.Reset(bucketStart);
+
+	bucket.Add(point);
+}
+
+void
+HistorySeries::Ring::Push(const HistoryPoint& point)
+{
+	if(count < capacity) {
+		points[(start + count) % capacity] = point;
+		count++;
+	}
+	else {
+		points[start] = point;
+		start = (start + 1) % capacity;
+	}
+}
+
+size_t
+HistorySeries::Ring::FindFirst(bigtime_t since) const
+{
+	// Timestamps are pushed in increasing order
+	size_t low = 0;
+	size_t high = count;
+	while(low < high) {
+		size_t middle = low + (high - low) / 2;
+		if(At(middle).timestamp < since)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	return low;
+}
+
+void
+HistorySeries::Bucket::Reset(bigtime_t bucketStart)
+{
+	start = bucketStart;
+	minimum = 0.0f;
+	maximum = 0.0f;
+	sum = 0.0;
+	count = 0;
+	weightedSum = 0.0;
+	duration = 0;
+}
+
+void
+HistorySeries::Bucket::Add(const HistoryPoint& point)
+{
+	if(count == 0 || point.minimum < minimum)
+		minimum = point.minimum;
+	if(count == 0 || point.maximum > maximum)
+		maximum = point.maximum;
+	sum += static_cast<double>(point.mean) * point.count;
+	count += point.count;
+	weightedSum += static_cast<double>(point.mean) * point.duration;
+	duration += point.duration;
+}
+
+HistoryPoint
+HistorySeries::Bucket::ToPoint() const
+{
+	// Only the very first sample of a series covers no time
+	float mean = 0.0f;
+	if(duration > 0)
+		mean = static_cast<float>(weightedSum / duration);
+	else if(count > 0)
+		mean = static_cast<float>(sum / count);
+
+	HistoryPoint point = { start, minimum, maximum, mean, count, duration };
+	return point;
+}
+
+// #pragma mark - HistoryStore
+
+HistoryStore::HistoryStore(size_t rawCapacity, size_t minuteCapacity,
+	size_t hourCapacity)
+: fLock("History lock")
+{
+	fCapacities[HISTORY_RAW] = rawCapacity;
+	fCapacities[HISTORY_MINUTE] = minuteCapacity;
+	fCapacities[HISTORY_HOUR] = hourCapacity;
+}
+
+HistoryStore::~HistoryStore()
+{
+	for(auto& series : fSeries)
+		delete series.second;
+}
+
+void
+HistoryStore::Add(int32 device, bigtime_t when, float value)
+{
+	BAutolock lock(fLock);
+	auto found = fSeries.find(device);
+	HistorySeries* series = NULL;
+	if(found == fSeries.end()) {
+		series = new HistorySeries(fCapacities[HISTORY_RAW],
+			fCapacities[HISTORY_MINUTE], fCapacities[HISTORY_HOUR]);
+		fSeries[device] = series;
+	}
+	else
+		series = found->second;
+
+	// Out of order samples would break the binary searches
+	if(series->Newest() > when)
+		return;
+
+	series->Add(when, value);
+}
+
+void
+HistoryStore::RemoveDevice(int32 device)
+{
+	BAutolock lock(fLock);
+	auto found = fSeries.find(device);
+	if(found == fSeries.end())
+		return;
+
+	delete found->second;
+	fSeries.erase(found);
+}
+
+size_t
+HistoryStore::Query(int32 device, HistoryResolution resolution, bigtime_t since,
+	HistoryPoint* outPoints, size_t maxPoints) const
+{
+	BAutolock lock(fLock);
+	auto found = fSeries.find(device);
+	if(found == fSeries.end())
+		return 0;
+
+	return found->second->Query(resolution, since, outPoints, maxPoints);
+}
+
+size_t
+HistoryStore::Query(int32 device, HistoryResolution resolution, bigtime_t since,
+	std::vector<HistoryPoint>* outPoints) const
+{
+	BAutolock lock(fLock);
+	auto found = fSeries.find(device);
+	if(found == fSeries.end())
+		return 0;
+
+	// Sized under the same lock, so no point is cut off
+	size_t start = outPoints->size();
+	outPoints->resize(start + found->second->CountSince(resolution, since));
+	size_t count = found->second->Query(resolution, since, outPoints->data() + start,
+		outPoints->size() - start);
+	outPoints->resize(start + count);
+	return count;
+}
+
+HistoryResolution
+HistoryStore::BestResolution(int32 device, bigtime_t since) const
+{
+	BAutolock lock(fLock);
+	auto found = fSeries.find(device);
+	if(found == fSeries.end())
+		return HISTORY_RAW;
+
+	// The finest tier that still reaches back to since, or that has not
+	//	dropped anything yet.
+	const HistorySeries* series = found->second;
+	for(int32 i = 0; i < HISTORY_RESOLUTION_COUNT; i++) {
+		HistoryResolution resolution = static_cast<HistoryResolution>(i);
+		bigtime_t oldest = series->Oldest(resolution);
+		if(oldest >= 0 && (oldest <= since || series->Count(resolution) < fCapacities[i]))
+			return resolution;
+	}
+
+	return HISTORY_HOUR;
+}
+
+size_t
+HistoryStore::Capacity(HistoryResolution resolution) const
+{
+	if(resolution < 0 || resolution >= HISTORY_RESOLUTION_COUNT)
+		return 0;
+
+	// The bucket still open counts too
+	return fCapacities[resolution] + (resolution != HISTORY_RAW ? 1 : 0);
+}
+
+/* static */
+bigtime_t
+HistoryStore::BucketLength(HistoryResolution resolution)
+{
+	switch(resolution) {
+		case HISTORY_MINUTE:
+			return 60LL * 1000000;
+		case HISTORY_HOUR:
+			return 3600LL * 1000000;
+		case HISTORY_RAW:
+		default:
+			return 1;
+	}
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef __HISTORY_STORE__
+#define __HISTORY_STORE__
+
+#include <Locker.h>
+#include <SupportDefs.h>
+#include <map>
+#include <vector>
+
+#define kDefaultHistoryRaw     3600	// one hour at one sample per second
+#define kDefaultHistoryMinutes 1440	// one day
+#define kDefaultHistoryHours   720	// thirty days
+#define kHistoryMaxSampleSpan  60000000	// longer gaps are not credited to a sample
+
+enum HistoryResolution {
+	HISTORY_RAW    = 0,
+	HISTORY_MINUTE = 1,
+	HISTORY_HOUR   = 2,
+
+	HISTORY_RESOLUTION_COUNT
+};
+
+struct HistoryPoint
+{
+	bigtime_t	timestamp;	// sample time, or start of the bucket
+	float		minimum;
+	float		maximum;
+	float		mean;		// weighted by the time each sample covers
+	uint32		count;
+	bigtime_t	duration;	// time covered by the samples
+};
+
+/*
+ * History of one device: raw samples at full rate that roll up into
+ * one-minute and one-hour min/max/mean buckets. All storage is allocated
+ * up front, so memory use does not grow with uptime. Samples may come at
+ * any pace; each one stands for the time since the one before it, so a
+ * burst of fast samples does not outweigh a long quiet stretch.
+ */
+class HistorySeries
+{
+public:
+						HistorySeries(size_t rawCapacity, size_t minuteCapacity,
+							size_t hourCapacity);
+						~HistorySeries();
+
+			void		Add(bigtime_t when, float value);
+			void		MakeEmpty();
+
+			size_t		Query(HistoryResolution resolution, bigtime_t since,
+							HistoryPoint* outPoints, size_t maxPoints) const;
+			size_t		Count(HistoryResolution resolution) const;
+			// What Query() would return with enough room
+			size_t		CountSince(HistoryResolution resolution, bigtime_t since) const;
+			bigtime_t	Oldest(HistoryResolution resolution) const;
+			bigtime_t	Newest() const;
+private:
+	// Runtime-sized ring of points, oldest first
+	struct Ring {
+		HistoryPoint*	points;
+		size_t			capacity;
+		size_t			start;
+		size_t			count;
+
+		const HistoryPoint& At(size_t index) const
+			{ return points[(start + index) % capacity]; }
+		void Push(const HistoryPoint& point);
+		size_t FindFirst(bigtime_t since) const;
+	};
+
+	struct Bucket {
+		bigtime_t	start;
+		float		minimum;
+		float		maximum;
+		double		sum;
+		uint32		count;
+		double		weightedSum;
+		bigtime_t	duration;
+
+		void Reset(bigtime_t bucketStart);
+		void Add(const HistoryPoint& point);
+		HistoryPoint ToPoint() const;
+	};
+
+			void		RollUp(int32 tier, const HistoryPoint& point);
+private:
+	Ring				fRings[HISTORY_RESOLUTION_COUNT];
+	Bucket				fOpen[HISTORY_RESOLUTION_COUNT];
+	bigtime_t			fNewest;
+};
+
+/*
+ * Thread safe collection of HistorySeries keyed by device id.
+ */
+class HistoryStore
+{
+public:
+						HistoryStore(size_t rawCapacity = kDefaultHistoryRaw,
+							size_t minuteCapacity = kDefaultHistoryMinutes,
+							size_t hourCapacity = kDefaultHistoryHours);
+						~HistoryStore();
+
+			void		Add(int32 device, bigtime_t when, float value);
+			void		RemoveDevice(int32 device);
+
+			// Points newer than or equal to since, oldest first; runs in
+			//	O(log n + points returned).
+			size_t		Query(int32 device, HistoryResolution resolution,
+							bigtime_t since, HistoryPoint* outPoints,
+							size_t maxPoints) const;
+			// Same, appending every point to outPoints
+			size_t		Query(int32 device, HistoryResolution resolution,
+							bigtime_t since, std::vector<HistoryPoint>* outPoints) const;
+			HistoryResolution BestResolution(int32 device, bigtime_t since) const;
+			// Most points a query at resolution can return
+			size_t		Capacity(HistoryResolution resolution) const;
+
+	static	bigtime_t	BucketLength(HistoryResolution resolution);
+private:
+	mutable BLocker		fLock;
+	std::map<int32, HistorySeries*> fSeries;
+	size_t				fCapacities[HISTORY_RESOLUTION_COUNT];
+};
+
+#endif /* __HISTORY_STORE__ */
@@ -1,19 +1,28 @@
 #include "MainWindow.h"
 #include "DataFactory.h"
+#include "DeviceRegistry.h"
+#include "SampleExport.h"
+#include "SampleRing.h"
 #include "TemperatureDefs.h"
 #include "TemperatureUtils.h"
 #include "ThermalDevice.h"
 
 #include <Alert.h>
 #include <Application.h>
+#include <Autolock.h>
 #include <Window.h>
 #include <LayoutBuilder.h>
 #include <View.h>
 #include <Button.h>
 #include <String.h>
 #include <File.h>
+#include <Directory.h>
+#include <FindDirectory.h>
+#include <Path.h>
 #include <Catalog.h>
+#include <Notification.h>
 #include <NumberFormat.h>
+#include <StringFormat.h>
 
 #include <Menu.h>
 #include <MenuField.h>
@@ -21,7 +30,10 @@
 #include <PopUpMenu.h>
 
 #include <cassert>
+#include <cmath>
 #include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
 #include <unordered_map>
 
 #undef B_TRANSLATION_CONTEXT
@@ -33,28 +45,68 @@ static std::unordered_map<int32, std::pair<char, BString>> tempMenuItems = {
 	{ 2, { SCALE_KELVIN, B_TRANSLATE("Kelvin") } }
 };
 
+// Formats offered by the export menu, with the extension of the default name
+static const std::pair<SampleExportFormat, const char*> kExportMenuItems[] = {
+	{ EXPORT_CSV, "csv" },
+	{ EXPORT_LINE_PROTOCOL, "txt" },
+	{ EXPORT_BINARY, "bin" }
+};
+
+struct ExportJob
+{
+	BString				logDirectory;
+	BString				output;
+	SampleExportFormat	format;
+};
+
 MainWindow::MainWindow(BRect frame, DataFactory* dataRepo)
 	:	BWindow(frame, B_TRANSLATE_SYSTEM_NAME("Temperature"), B_TITLED_WINDOW, B_ASYNCHRONOUS_CONTROLS),
 	dataRepository(dataRepo),
-	activeDevice(NULL),
+	displayedDevice(-1),
+	samplesLock("Latest samples"),
+	lastLogSync(0),
+	exportPanel(NULL),
+	tempUpdaterThread(-1),
 	shouldStopUpdater(false)
 {
 	assert(dataRepository != NULL);
 
-	activeDevice.SetTo(dataRepository->ActiveDevice());
+	history = new HistoryStore(dataRepository->HistoryCapacity(HISTORY_RAW),
+		dataRepository->HistoryCapacity(HISTORY_MINUTE),
+		dataRepository->HistoryCapacity(HISTORY_HOUR));
+	statistics = new StatisticsStore(
+		static_cast<bigtime_t>(dataRepository->StatisticsWindow()) * 1000000);
+	ApplyAlertRules();
+
+	// Every device is polled so that switching between them is instant
+	BStringList devices(dataRepository->ThermalDevices());
+	for(int32 i = 0; i < devices.CountStrings(); i++) {
+		BString devicePath(devices.StringAt(i));
+		samplerEngine.AddDevice(devicePath,
+			dataRepository->DeviceRefreshInterval(devicePath));
+	}
+	if(strlen(dataRepository->ActiveDevice()) > 0
+		&& samplerEngine.FindDevice(dataRepository->ActiveDevice()) < 0) {
+		samplerEngine.AddDevice(dataRepository->ActiveDevice(),
+			dataRepository->DeviceRefreshInterval(dataRepository->ActiveDevice()));
+	}
+	displayedDevice.store(samplerEngine.FindDevice(dataRepository->ActiveDevice()));
+	if(dataRepository->AdaptiveSampling())
+		ApplyRefreshRates();
+
+	if(dataRepository->HistoryLogging())
+		OpenSampleLog();
 
 	temperatureGraph = new GraphView(dataRepository);
+	temperatureGraph->SetDisplayedDevice(displayedDevice.load());
+	temperatureGraph->SetHistoryStore(history);
 
     // Device selector
     devicesField = new BMenuField("devices", B_TRANSLATE("Device"), new BPopUpMenu("", true, true));
-	for(int32 i = 0; i < dataRepository->ThermalDevices().CountStrings(); i++) {
-		BString deviceString(dataRepository->ThermalDevices().StringAt(i));
-		BMessage* deviceMessage = new BMessage(M_DEVICE_CHANGED);
-		deviceMessage->AddString("target", deviceString);
-		devicesField->Menu()->AddItem(new BMenuItem(deviceString, deviceMessage));
-	}
-	if(HasDevice() && devicesField->Menu()->FindItem(activeDevice.Location()))
-		devicesField->Menu()->FindItem(activeDevice.Location())->SetMarked(true);
+	for(int32 i = 0; i < devices.CountStrings(); i++)
+		AddDeviceItem(devices.StringAt(i));
+	if(HasDevice() && devicesField->Menu()->FindItem(dataRepository->ActiveDevice()))
+		devicesField->Menu()->FindItem(dataRepository->ActiveDevice())->SetMarked(true);
 
     // Reported temperatures
     criticalTempControl = new BTextControl("critical_temp", B_TRANSLATE("Critical"), NULL, NULL);
@@ -65,6 +117,13 @@ MainWindow::MainWindow(BRect frame, DataFactory* dataRepo)
 	currentTempControl->TextView()->MakeEditable(false);
 	currentTempControl->SetModificationMessage(new BMessage(B_MODIFIERS_CHANGED));
 
+	forecastView = new BStringView("forecast", "");
+	forecastView->SetToolTip(B_TRANSLATE("Time left until the critical temperature "
+		"at the current trend"));
+
+	statisticsView = new BStringView("statistics", "");
+	statisticsView->SetExplicitMinSize(BSize(0, B_SIZE_UNSET));
+
 	// Temperature settings
 	BMenu* temperatureMenu = new BMenu("⚙️");
 	for(int32 i = 0; i < SCALE_COUNT; i++) {
@@ -75,6 +134,21 @@ MainWindow::MainWindow(BRect frame, DataFactory* dataRepo)
 		temperatureMenu->AddItem(new BMenuItem(tempMenuItems[i].second, scaleMessage));
 	}
 
+	// Scales stay the first items, they are marked by index
+	BMenu* exportMenu = new BMenu(B_TRANSLATE("Export history"));
+	const char* exportLabels[] = {
+		B_TRANSLATE("CSV" B_UTF8_ELLIPSIS),
+		B_TRANSLATE("InfluxDB line protocol" B_UTF8_ELLIPSIS),
+		B_TRANSLATE("Binary" B_UTF8_ELLIPSIS)
+	};
+	for(int32 i = 0; i < EXPORT_FORMAT_COUNT; i++) {
+		BMessage* exportMessage = new BMessage(M_EXPORT_HISTORY);
+		exportMessage->AddInt32("format", kExportMenuItems[i].first);
+		exportMenu->AddItem(new BMenuItem(exportLabels[i], exportMessage));
+	}
+	temperatureMenu->AddSeparatorItem();
+	temperatureMenu->AddItem(exportMenu);
+
 	temperatureField = new BMenuField("temperature_options", "️", temperatureMenu);
     temperatureField->SetExplicitSize(BSize(temperatureMenu->StringWidth("⚙️") * 4.0f, B_SIZE_UNSET));
 	for(int32 i = 0; i < SCALE_COUNT; i++) { // Initialize temperature scale in menu
@@ -89,12 +163,14 @@ MainWindow::MainWindow(BRect frame, DataFactory* dataRepo)
 		.AddGrid()
 			.SetSpacing(B_USE_HALF_ITEM_SPACING, B_USE_HALF_ITEM_SPACING)
 			.Add(devicesField->CreateLabelLayoutItem(), 0, 0)
-			.Add(devicesField->CreateMenuBarLayoutItem(), 1, 0, 4)
+			.Add(devicesField->CreateMenuBarLayoutItem(), 1, 0, 5)
 			.Add(currentTempControl->CreateLabelLayoutItem(), 0, 1)
 			.Add(currentTempControl->CreateTextViewLayoutItem(), 1, 1)
 			.Add(criticalTempControl->CreateLabelLayoutItem(), 2, 1)
 			.Add(criticalTempControl->CreateTextViewLayoutItem(), 3, 1)
-			.Add(temperatureField, 4, 1)
+			.Add(forecastView, 4, 1)
+			.Add(temperatureField, 5, 1)
+			.Add(statisticsView, 0, 2, 6)
 		.End()
 	.End();
 
@@ -103,21 +179,33 @@ MainWindow::MainWindow(BRect frame, DataFactory* dataRepo)
 	AddShortcut(B_DELETE, B_COMMAND_KEY, new BMessage(M_RESTORE_DEFAULTS));
 
 	// Start live monitoring
-	if(HasDevice()) {
-		tempUpdaterThread = spawn_thread(CallUpdateTemperature, "Temperature updater",
-			B_NORMAL_PRIORITY, this);
-		resume_thread(tempUpdaterThread);
-	}
+	DeviceRegistry::Default()->StartWatching(BMessenger(this));
+	status_t status = sharedSamples.Init();
+	if(status == B_BUSY)
+		fprintf(stderr, "Temperature: another sampler already publishes the shared samples\n");
+	else if(status != B_OK)
+		fprintf(stderr, "Temperature: could not create the shared sample area\n");
+	samplerEngine.Start();
+	tempUpdaterThread = spawn_thread(CallUpdateTemperature, "Temperature updater",
+		B_NORMAL_PRIORITY, this);
+	resume_thread(tempUpdaterThread);
 
-	float rateMultiplier = static_cast<int64>(dataRepository->RefreshRate());
-	if(rateMultiplier < 1)
-		rateMultiplier = 1;
-	SetPulseRate(rateMultiplier * 1000000);
+	SetPulseRate(dataRepository->RefreshInterval());
 }
 
 MainWindow::~MainWindow()
 {
+	DeviceRegistry::Default()->StopWatching(BMessenger(this));
 	shouldStopUpdater.store(true, std::memory_order_release); // exit the thread
+	if(tempUpdaterThread >= 0) {
+		status_t exitCode = B_OK;
+		wait_for_thread(tempUpdaterThread, &exitCode);
+	}
+	samplerEngine.Stop();
+	sampleLog.Close();
+	delete exportPanel;
+	delete history;
+	delete statistics;
 }
 
 void MainWindow::MessageReceived(BMessage *msg)
@@ -164,6 +252,53 @@ void MainWindow::MessageReceived(BMessage *msg)
 			}
 			break;
 		}
+		case M_SAMPLES_SUBSCRIBE:
+		case M_SAMPLES_UNSUBSCRIBE:
+			HandleSampleSubscription(msg);
+			break;
+		case M_EXPORT_HISTORY:
+			ShowExportPanel(msg->GetInt32("format", EXPORT_CSV));
+			break;
+		case B_SAVE_REQUESTED:
+			ExportHistory(msg);
+			break;
+		case M_DEVICES_CHANGED:
+		{
+			int32 device = msg->GetInt32("device", -1);
+			BString devicePath(msg->GetString("path", ""));
+			if(msg->GetBool("present")) {
+				samplerEngine.AddDevice(devicePath,
+					dataRepository->DeviceRefreshInterval(devicePath));
+				ApplySamplingPolicy(device);
+				AddDeviceItem(devicePath);
+				break;
+			}
+
+			// Keep the id and history, the device may come back
+			samplerEngine.RemoveDevice(device);
+			broadcast.RevokeFeeds(device, B_ENTRY_NOT_FOUND);
+			alerts.RemoveDevice(device);
+			forecasts.RemoveDevice(device);
+			BMenuItem* item = devicesField->Menu()->FindItem(devicePath);
+			if(item) {
+				devicesField->Menu()->RemoveItem(item);
+				delete item;
+			}
+			if(device == displayedDevice.load()) {
+				BNumberFormat numberFormat;
+				BString currentTempString;
+				BString criticalTempString;
+				ThermalSample empty;
+				empty.status = B_NO_INIT;
+				FormatSample(empty, numberFormat, dataRepository->TemperatureScale(),
+					&currentTempString, &criticalTempString);
+				currentTempControl->SetText(currentTempString);
+				criticalTempControl->SetText(criticalTempString);
+				forecastView->SetText("");
+				statisticsView->SetText("");
+			}
+			break;
+		}
 		case M_SCALE_CHANGED:
 		{
 			const void* ptr = NULL;
@@ -187,8 +322,16 @@ void MainWindow::MessageReceived(BMessage *msg)
 		}
 		case M_TEMPERATURE_REQUESTED:
 		{
+			// Answer with the last published sample, the device is only
+			//	read by the sampler engine.
+			ThermalSnapshot snapshot;
+			ThermalSample sample;
+			if(FindLatestSample(displayedDevice.load(), &sample))
+				snapshot = sample.snapshot;
+
 			BMessage reply(M_TEMPERATURE_REPLY);
-			reply.AddFloat("temperature", activeDevice.ReadTemperature());
+			reply.AddFloat("temperature", snapshot.Temperature(TEMPERATURE_CURRENT));
+			reply.AddInt64("when", snapshot.timestamp);
 
 			BMessenger messenger;
 			msg->FindMessenger("handler", &messenger);
@@ -201,13 +344,21 @@ void MainWindow::MessageReceived(BMessage *msg)
 			break;
 		case M_REFRESH_RATE:
 		{
-			uint32 rate = -1;
-			if(msg->FindUInt32("rate", 0, &rate) == B_OK) {
-				dataRepository->SetRefreshRate(rate);
-				SetPulseRate((bigtime_t)(dataRepository->RefreshRate() * 1000000));
+			bigtime_t interval = 0;
+			if(msg->FindInt64("interval", &interval) == B_OK) {
+				dataRepository->SetRefreshInterval(interval);
+				dataRepository->SetDeviceRefreshInterval(dataRepository->ActiveDevice(), interval);
+				ApplyRefreshRates();
+				SetPulseRate(dataRepository->RefreshInterval());
 			}
 			break;
 		}
+		case M_ADAPTIVE_SAMPLING:
+			ApplyRefreshRates();
+			break;
+		case M_STATISTICS_WINDOW:
+			SetStatisticsWindow(msg->GetUInt32("seconds", 0));
+			break;
 		case M_GRAPHVIEW_COLOR_CHANGED:
 		{
 			PostMessage(msg, temperatureGraph);
@@ -230,30 +381,45 @@ void MainWindow::DeviceChanged(const char* devicePath)
 	if(!devicePath)
 		return;
 
-	// Wait for thread to end
-	if(tempUpdaterThread >= 0) {
-		shouldStopUpdater.store(true, std::memory_order_release);
-		status_t exitCode = B_OK;
-		wait_for_thread(tempUpdaterThread, &exitCode);
-		shouldStopUpdater.store(true, std::memory_order_release);
-	}
-
-	// Update target
+	// Update target, the sampler is already polling it in most cases
 	dataRepository->SetActiveDevice(devicePath);
-	if(strcmp(activeDevice.Location(), dataRepository->ActiveDevice()) != 0)
-		activeDevice.SetTo(dataRepository->ActiveDevice());
-
-	// and restart updater
-	tempUpdaterThread = spawn_thread(CallUpdateTemperature, "Temperature updater",
-		B_NORMAL_PRIORITY, this);
-	shouldStopUpdater.store(false, std::memory_order_release);
-	resume_thread(tempUpdaterThread);
+	int32 device = samplerEngine.FindDevice(devicePath);
+	if(device < 0) {
+		device = samplerEngine.AddDevice(devicePath,
+			dataRepository->DeviceRefreshInterval(devicePath));
+	}
+	displayedDevice.store(device);
 
 	// Update interface
 	LockLooper();
 	if(devicesField->Menu()->FindItem(dataRepository->ActiveDevice()))
 		devicesField->Menu()->FindItem(dataRepository->ActiveDevice())->SetMarked(true);
-    PostMessage(M_DEVICE_CHANGED, temperatureGraph);
+	temperatureGraph->SetDisplayedDevice(device);
+
+	BNumberFormat numberFormat;
+	char scale = dataRepository->TemperatureScale();
+	BString currentTempString;
+	BString criticalTempString;
+	ThermalSample latest;
+	if(!FindLatestSample(device, &latest))
+		latest.status = B_NO_INIT;
+	FormatSample(latest, numberFormat, scale, &currentTempString, &criticalTempString);
+	currentTempControl->SetText(currentTempString);
+	criticalTempControl->SetText(criticalTempString);
+
+	BString forecastString;
+	CriticalForecast forecast;
+	if(forecasts.GetForecast(device, &forecast) == B_OK)
+		FormatForecast(forecast, &forecastString);
+	forecastView->SetText(forecastString);
+
+	BString statisticsString;
+	RollingSummary summary;
+	if(statistics->GetSummary(device, &summary) == B_OK) {
+		FormatSummary(summary, numberFormat, scale, &statisticsString);
+		temperatureGraph->SetSummary(summary);
+	}
+	statisticsView->SetText(statisticsString);
 	UnlockLooper();
 }
 
@@ -273,48 +439,297 @@ void MainWindow::Update()
 {
 	PostMessage(M_STARTED_RUNNING);
 
-	BString notAvailable(B_TRANSLATE_COMMENT("N/A",
-		"Abbreviated: when something is not available."));
+	// dataRepository belongs to the window; this thread only reads the
+	//	copy, which is refreshed with every batch.
+	UpdaterSettings settings;
+	Lock();
+	GetUpdaterSettings(&settings);
+	Unlock();
 
+	BNumberFormat numberFormat;
 	if(!HasDevice()) {
-		Lock();
+		ThermalSample empty;
+		empty.status = B_NO_INIT;
 
-		currentTempControl->SetText(notAvailable);
-		criticalTempControl->SetText(notAvailable);
+		BString currentTempString;
+		BString criticalTempString;
+		FormatSample(empty, numberFormat, settings.scale, &currentTempString,
+			&criticalTempString);
 
+		Lock();
+		currentTempControl->SetText(currentTempString);
+		criticalTempControl->SetText(criticalTempString);
 		Unlock();
-		return;
 	}
 
+	const int32 kBatchSize = 32;
+	ThermalSample samples[kBatchSize];
+	const int32 kMaxAlerts = 8;
+	AlertEvent alertEvents[kMaxAlerts];
+	// Samples the graph missed while the window was busy, added once it is
+	//	not; should it stay busy for a whole graph, the oldest are lost
+	struct GraphPoint {
+		int32		device;
+		float		temperature;
+		bigtime_t	when;
+	};
+	SampleRing<GraphPoint, kGraphHistorySize> graphPoints;
+	// Texts of the newest sample of the shown device, kept until they are set
+	int32 textDevice = -1;
+	BString currentTempString;
+	BString criticalTempString;
+	BString statisticsString;
+	BString forecastString;
+	RollingSummary summary;
+	bool hasSummary = false;
 	while(!shouldStopUpdater.load(std::memory_order_acquire)) {
-		Lock();
+		if(samplerEngine.WaitForSamples(100000) != B_OK)
+			continue;
 
-		auto scale = dataRepository->TemperatureScale();
-		float currentTemp = activeDevice.ReadTemperature(TEMPERATURE_CURRENT);
-		float convertedTemp = ConvertToScale(currentTemp, SCALE_CELSIUS, scale);
+		int32 count = 0;
+		while(count < kBatchSize && samplerEngine.PopSample(&samples[count]))
+			count++;
 
-		BString currentTempString;
-		BNumberFormat numberFormat;
-		numberFormat.Format(currentTempString, static_cast<double>(convertedTemp));
-		currentTempString.Append(SymbolForScale(scale, 1));
-		currentTempControl->SetText(currentTempString);
+		// Only the newest sample of the shown device makes it to the text
+		//	controls, and it is formatted outside of the window lock.
+		int32 device = displayedDevice.load();
+		const ThermalSample* shown = NULL;
+		for(int32 i = 0; i < count; i++) {
+			if(samples[i].device == device && samples[i].status == B_OK)
+				shown = &samples[i];
+		}
 
-		BString criticalTempString;
-		if(activeDevice.IsTemperatureReported(TEMPERATURE_CRITICAL)) {
-			float criticalTemp = activeDevice.ReadTemperature(TEMPERATURE_CRITICAL);
-			float criticalConverted = ConvertToScale(criticalTemp, SCALE_CELSIUS, scale);
+		if(shown) {
+			FormatSample(*shown, numberFormat, settings.scale, &currentTempString,
+				&criticalTempString);
+		}
 
-			BNumberFormat criticalFormat;
-			criticalFormat.Format(criticalTempString, static_cast<double>(criticalConverted));
-			criticalTempString.Append(SymbolForScale(scale, 1));
+		int32 alertCount = 0;
+		for(int32 i = 0; i < count; i++) {
+			if(samples[i].status == B_OK) {
+				// Deadlines are evenly spaced where read times jitter
+				history->Add(samples[i].device, samples[i].deadline,
+					samples[i].snapshot.Temperature(TEMPERATURE_CURRENT));
+				statistics->Add(samples[i].device, samples[i].snapshot.timestamp,
+					samples[i].snapshot.Temperature(TEMPERATURE_CURRENT));
+				forecasts.Add(samples[i].device, samples[i].snapshot);
+				broadcast.Publish(samples[i]);
+				alertCount += alerts.Evaluate(samples[i].device, samples[i].snapshot,
+					alertEvents + alertCount, kMaxAlerts - alertCount);
+			}
+		}
+		for(int32 i = 0; i < alertCount; i++)
+			FireAlert(alertEvents[i], settings);
+
+		if(shown) {
+			textDevice = shown->device;
+			hasSummary = statistics->GetSummary(shown->device, &summary) == B_OK;
+			if(hasSummary)
+				FormatSummary(summary, numberFormat, settings.scale, &statisticsString);
+
+			CriticalForecast forecast;
+			forecastString = "";
+			if(forecasts.GetForecast(shown->device, &forecast) == B_OK)
+				FormatForecast(forecast, &forecastString);
+		}
+
+		LogSamples(samples, count);
+		ShareSamples(samples, count);
+
+		// Scripting reads these off the window thread, under their own lock
+		samplesLock.Lock();
+		for(int32 i = 0; i < count; i++) {
+			if(samples[i].status == B_OK)
+				lastSamples[samples[i].device] = samples[i];
+		}
+		samplesLock.Unlock();
+
+		for(int32 i = 0; i < count; i++) {
+			const ThermalSample& sample = samples[i];
+			if(sample.status == B_OK) {
+				graphPoints.Push({ sample.device,
+					sample.snapshot.Temperature(TEMPERATURE_CURRENT), sample.snapshot.timestamp });
+			}
 		}
-		else
-			criticalTempString.SetTo(notAvailable);
-		criticalTempControl->SetText(criticalTempString);
 
+		// The window may be busy waiting for this thread, so do not block on it
+		if(LockWithTimeout(100000) != B_OK)
+			continue;
+
+		graphPoints.ForEachLast(graphPoints.Count(), [this](size_t, const GraphPoint& point) {
+			temperatureGraph->AddSample(point.device, point.temperature, point.when);
+		});
+		graphPoints.MakeEmpty();
+		if(textDevice >= 0 && textDevice == displayedDevice.load()) {
+			currentTempControl->SetText(currentTempString);
+			criticalTempControl->SetText(criticalTempString);
+			forecastView->SetText(forecastString);
+			if(hasSummary) {
+				statisticsView->SetText(statisticsString);
+				temperatureGraph->SetSummary(summary);
+			}
+		}
+		textDevice = -1;
+
+		GetUpdaterSettings(&settings);
 		Unlock();
+	}
+}
+
+void MainWindow::AddDeviceItem(const char* devicePath)
+{
+	if(devicesField->Menu()->FindItem(devicePath))
+		return;
+
+	BMessage* deviceMessage = new BMessage(M_DEVICE_CHANGED);
+	deviceMessage->AddString("target", devicePath);
+	BMenuItem* item = new BMenuItem(devicePath, deviceMessage);
+	item->SetMarked(strcmp(devicePath, dataRepository->ActiveDevice()) == 0);
+	devicesField->Menu()->AddItem(item);
+}
+
+void MainWindow::OpenSampleLog()
+{
+	BPath path;
+	if(find_directory(B_USER_DATA_DIRECTORY, &path) != B_OK
+		|| path.Append(kHistoryLogDirectory) != B_OK
+		|| create_directory(path.Path(), 0755) != B_OK)
+		return;
+
+	if(sampleLog.Open(path.Path()) != B_OK)
+		fprintf(stderr, "Temperature: could not open the sample log in %s\n", path.Path());
+}
+
+void MainWindow::ShowExportPanel(int32 format)
+{
+	if(format < 0 || format >= EXPORT_FORMAT_COUNT)
+		return;
+
+	if(exportPanel == NULL) {
+		BMessenger target(this);
+		exportPanel = new BFilePanel(B_SAVE_PANEL, &target);
+	}
+
+	BMessage saveMessage(B_SAVE_REQUESTED);
+	saveMessage.AddInt32("format", format);
+	exportPanel->SetMessage(&saveMessage);
+
+	BString name(B_TRANSLATE("Temperature history"));
+	name << "." << kExportMenuItems[format].second;
+	exportPanel->SetSaveText(name);
+	exportPanel->Show();
+}
+
+void MainWindow::ExportHistory(BMessage* message)
+{
+	entry_ref directory;
+	const char* name = NULL;
+	int32 format = message->GetInt32("format", -1);
+	if(message->FindRef("directory", &directory) != B_OK
+		|| message->FindString("name", &name) != B_OK
+		|| format < 0 || format >= EXPORT_FORMAT_COUNT)
+		return;
+
+	BPath output(&directory);
+	BPath logPath;
+	if(output.Append(name) != B_OK
+		|| find_directory(B_USER_DATA_DIRECTORY, &logPath) != B_OK
+		|| logPath.Append(kHistoryLogDirectory) != B_OK)
+		return;
+
+	// A month of samples takes a while, keep the window responsive
+	ExportJob* job = new ExportJob;
+	job->logDirectory = logPath.Path();
+	job->output = output.Path();
+	job->format = static_cast<SampleExportFormat>(format);
+	thread_id thread = spawn_thread(CallExportHistory, "History exporter",
+		B_LOW_PRIORITY, job);
+	if(thread < 0) {
+		delete job;
+		return;
+	}
+	resume_thread(thread);
+}
+
+/* static */
+int32 MainWindow::CallExportHistory(void* data)
+{
+	ExportJob* job = static_cast<ExportJob*>(data);
+
+	uint64_t count = 0;
+	int status = ENOENT;
+	int fd = open(job->output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(fd >= 0) {
+		status = ExportSampleLog(job->logDirectory, fd, job->format, 0, INT64_MAX,
+			NULL, &count);
+		if(close(fd) != 0 && status == 0)
+			status = errno;
+	}
+	else
+		status = errno;
+
+	BString content;
+	if(status == 0) {
+		static BStringFormat format(B_TRANSLATE("{0, plural,"
+			"=1{One sample exported to %path%.}"
+			"other{# samples exported to %path%.}}"));
+		format.Format(content, static_cast<int64>(count));
+	}
+	else {
+		content.SetTo(B_TRANSLATE("Could not export the history to %path%: %error%."));
+		content.ReplaceAll("%error%", strerror(status));
+	}
+	content.ReplaceAll("%path%", job->output);
+
+	BNotification notification(status == 0
+		? B_INFORMATION_NOTIFICATION : B_ERROR_NOTIFICATION);
+	notification.SetGroup(B_TRANSLATE_SYSTEM_NAME("Temperature"));
+	notification.SetTitle(B_TRANSLATE("Export history"));
+	notification.SetContent(content);
+	notification.Send();
+
+	delete job;
+	return status == 0 ? B_OK : B_ERROR;
+}
+
+void MainWindow::LogSamples(const ThermalSample* samples, int32 count)
+{
+	if(!sampleLog.IsOpen())
+		return;
+
+	// Samples carry system time, the log keeps wall clock time
+	bigtime_t now = system_time();
+	bigtime_t offset = real_time_clock_usecs() - now;
+	for(int32 i = 0; i < count; i++) {
+		const ThermalSample& sample = samples[i];
+		if(sample.status != B_OK)
+			continue;
 
-		snooze((bigtime_t)(dataRepository->RefreshRate() * 1000000));
+		if(!sampleLog.HasDevice(sample.device))
+			sampleLog.RegisterDevice(sample.device, samplerEngine.DevicePath(sample.device));
+		sampleLog.Append(sample.device, sample.snapshot.timestamp + offset,
+			sample.snapshot.Temperature(TEMPERATURE_CURRENT));
+	}
+
+	if(now - lastLogSync > 60000000) {
+		sampleLog.Sync();
+		lastLogSync = now;
+	}
+}
+
+void MainWindow::ShareSamples(const ThermalSample* samples, int32 count)
+{
+	if(sharedSamples.InitCheck() != B_OK)
+		return;
+
+	for(int32 i = 0; i < count; i++) {
+		const ThermalSample& sample = samples[i];
+		if(sample.status != B_OK)
+			continue;
+
+		if(!sharedSamples.HasDevice(sample.device))
+			sharedSamples.RegisterDevice(sample.device, samplerEngine.DevicePath(sample.device));
+		sharedSamples.Publish(sample.device, sample.snapshot);
 	}
 }
 
@@ -327,12 +742,119 @@ void MainWindow::CallNotifyStopped(void* data)
 	}
 }
 
+status_t MainWindow::GetStatistics(RollingSummary* outSummary) const
+{
+	return statistics->GetSummary(displayedDevice.load(), outSummary);
+}
+
+void MainWindow::SetStatisticsWindow(uint32 seconds)
+{
+	if(seconds == 0)
+		return;
+
+	dataRepository->SetStatisticsWindow(seconds);
+	statistics->SetWindow(static_cast<bigtime_t>(seconds) * 1000000);
+}
+
+status_t MainWindow::GetForecast(CriticalForecast* outForecast) const
+{
+	return forecasts.GetForecast(displayedDevice.load(), outForecast);
+}
+
+status_t MainWindow::GetSamplerMetrics(SamplerMetrics* outMetrics) const
+{
+	return samplerEngine.GetMetrics(displayedDevice.load(), outMetrics);
+}
+
+status_t MainWindow::SubscribeUpdates(int32 device, BMessenger target,
+	bigtime_t interval, float delta)
+{
+	if(!target.IsValid() || interval < 0 || delta < 0)
+		return B_BAD_VALUE;
+	if(!samplerEngine.HasDevice(device))
+		return B_NAME_NOT_FOUND;
+
+	broadcast.Subscribe(device, samplerEngine.DevicePath(device), target,
+		M_TEMPERATURE_REPLY, interval, delta);
+	return B_OK;
+}
+
+void MainWindow::UnsubscribeUpdates(int32 device, BMessenger target)
+{
+	broadcast.Unsubscribe(device, target);
+}
+
+void MainWindow::GetLatestSnapshots(const std::vector<int32>& devices,
+	std::vector<ThermalSnapshot>* outSnapshots) const
+{
+	outSnapshots->resize(devices.size());
+	BAutolock lock(samplesLock);
+	for(size_t i = 0; i < devices.size(); i++) {
+		auto found = lastSamples.find(devices[i]);
+		if(RunningStatus() && found != lastSamples.end())
+			(*outSnapshots)[i] = found->second.snapshot;
+		else
+			(*outSnapshots)[i].MakeEmpty();
+	}
+}
+
+bool MainWindow::FindLatestSample(int32 device, ThermalSample* outSample) const
+{
+	BAutolock lock(samplesLock);
+	auto found = lastSamples.find(device);
+	if(found == lastSamples.end())
+		return false;
+
+	*outSample = found->second;
+	return true;
+}
+
+void MainWindow::HandleSampleSubscription(BMessage* message)
+{
+	BString path;
+	BMessenger target;
+	if(message->FindString("path", &path) != B_OK
+		|| message->FindMessenger("target", &target) != B_OK)
+		return;
+
+	int32 device = samplerEngine.FindDevice(path);
+	if(message->what == M_SAMPLES_UNSUBSCRIBE) {
+		if(device >= 0)
+			broadcast.Unsubscribe(device, target);
+		return;
+	}
+
+	// Answered through the target, the request may have been forwarded
+	status_t status = device >= 0 ? B_OK : device;
+	if(status == B_OK)
+		broadcast.Subscribe(device, path, target);
+
+	BMessage reply(M_SAMPLES_SUBSCRIBED);
+	reply.AddString("path", path);
+	reply.AddInt32("status", status);
+	target.SendMessage(&reply, (BHandler*)NULL, 0);
+}
+
+status_t MainWindow::GetLatestSnapshot(int32 device, ThermalSnapshot* outSnapshot) const
+{
+	if(!RunningStatus())
+		return B_NO_INIT;
+
+	ThermalSample sample;
+	if(!FindLatestSample(device, &sample))
+		return B_NO_INIT;
+
+	*outSnapshot = sample.snapshot;
+	return B_OK;
+}
+
 bool MainWindow::HasDevice() const
 {
+	int32 device = displayedDevice.load();
 	return
 		dataRepository->ActiveDevice() && // Valid path
-		strcmp(dataRepository->ActiveDevice(), activeDevice.Location()) == 0 && // Paths match
-		activeDevice.InitCheck() == B_OK; // Is initialized
+		samplerEngine.DevicePath(device) == dataRepository->ActiveDevice() && // Paths match
+		samplerEngine.HasDevice(device); // Is initialized
 }
 
 /* static */
@@ -347,19 +869,233 @@ void MainWindow::RestoreSettingsUI(BMessage *data)
 {
 	Lock();
 
-	// Wait for thread to end
-	if(tempUpdaterThread >= 0) {
-		shouldStopUpdater.store(true, std::memory_order_release);
-		status_t exitCode = B_OK;
-		wait_for_thread(tempUpdaterThread, &exitCode);
-		shouldStopUpdater.store(true, std::memory_order_release);
-	}
-
 	dataRepository->Perform(static_cast<perform_code>('rstr'), NULL);
-	if(dataRepository->ThermalDevices().CountStrings() > 0)
-		DeviceChanged(dataRepository->ThermalDevices().StringAt(0));
+	// Also hands every device the restored sampling policy
+	ApplyRefreshRates();
+	ApplyAlertRules();
+	statistics->SetWindow(
+		static_cast<bigtime_t>(dataRepository->StatisticsWindow()) * 1000000);
+	BStringList devices(dataRepository->ThermalDevices());
+	if(devices.CountStrings() > 0)
+		DeviceChanged(devices.StringAt(0));
 
 	Unlock();
 
 	UpdateIfNeeded();
 }
+
+// #pragma mark - Private
+
+void MainWindow::ApplyRefreshRates()
+{
+	BStringList devices(dataRepository->ThermalDevices());
+	for(int32 i = 0; i < devices.CountStrings(); i++) {
+		BString devicePath(devices.StringAt(i));
+		int32 device = samplerEngine.FindDevice(devicePath);
+		samplerEngine.SetInterval(device,
+			dataRepository->DeviceRefreshInterval(devicePath));
+		ApplySamplingPolicy(device);
+	}
+	samplerEngine.SetInterval(displayedDevice.load(),
+		dataRepository->DeviceRefreshInterval(dataRepository->ActiveDevice()));
+	ApplySamplingPolicy(displayedDevice.load());
+}
+
+void MainWindow::ApplySamplingPolicy(int32 device)
+{
+	samplerEngine.SetAdaptive(device, dataRepository->AdaptiveSampling()
+		? &dataRepository->SamplingPolicy() : NULL);
+}
+
+void MainWindow::ApplyAlertRules()
+{
+	std::vector<AlertRule> rules;
+	bigtime_t slopeWindow = kDefaultAlertSlopeWindow;
+	if(AlertEngine::RulesFromMessage(&dataRepository->AlertRules(), &rules, &slopeWindow) != B_OK) {
+		fprintf(stderr, "Temperature: invalid alert rules, using the defaults\n");
+		BMessage defaults;
+		AlertEngine::DefaultRules(&defaults);
+		rules.clear();
+		AlertEngine::RulesFromMessage(&defaults, &rules, &slopeWindow);
+	}
+	alerts.SetRules(rules, slopeWindow);
+}
+
+void MainWindow::GetUpdaterSettings(UpdaterSettings* outSettings) const
+{
+	outSettings->scale = dataRepository->TemperatureScale();
+	outSettings->alertHook = dataRepository->AlertHook();
+}
+
+void MainWindow::FireAlert(const AlertEvent& event, const UpdaterSettings& settings)
+{
+	AlertRule rule;
+	if(!alerts.GetRule(event.rule, &rule))
+		return;
+
+	BString devicePath(samplerEngine.DevicePath(event.device));
+	char scale = settings.scale;
+	BNumberFormat numberFormat;
+	BString value;
+	BString content;
+	if(rule.kind == ALERT_SLOPE) {
+		// A rate is a difference, so only the scale factor applies
+		numberFormat.Format(value, static_cast<double>(ConvertToScale(event.value,
+			SCALE_CELSIUS, scale) - ConvertToScale(0.0f, SCALE_CELSIUS, scale)));
+		value.Append(SymbolForScale(scale, 1));
+		content.SetTo(B_TRANSLATE("%device% is rising %rate% per second."));
+		content.ReplaceAll("%rate%", value);
+	}
+	else {
+		numberFormat.Format(value, static_cast<double>(ConvertToScale(event.value,
+			SCALE_CELSIUS, scale)));
+		value.Append(SymbolForScale(scale, 1));
+		content.SetTo(B_TRANSLATE("%device% is at %temperature%."));
+		content.ReplaceAll("%temperature%", value);
+	}
+	content.ReplaceAll("%device%", devicePath);
+
+	// Same id for the same rule and device, so repeats replace each other
+	BString messageID;
+	messageID.SetToFormat("alert-%" B_PRId32 "-%" B_PRId32, event.rule, event.device);
+
+	BNotification notification(rule.reference == ALERT_CRITICAL
+		? B_IMPORTANT_NOTIFICATION : B_INFORMATION_NOTIFICATION);
+	notification.SetGroup(B_TRANSLATE_SYSTEM_NAME("Temperature"));
+	notification.SetTitle(rule.name);
+	notification.SetContent(content);
+	notification.SetMessageID(messageID);
+	notification.Send();
+
+	const char* hook = settings.alertHook.String();
+	if(strlen(hook) == 0)
+		return;
+
+	// hook <rule> <device> <value in degrees Celsius, or per second>
+	BString celsius;
+	celsius.SetToFormat("%.2f", event.value);
+	const char* arguments[] = { hook, rule.name.String(), devicePath.String(),
+		celsius.String(), NULL };
+	thread_id hookThread = load_image(4, arguments, const_cast<const char**>(environ));
+	if(hookThread < 0) {
+		fprintf(stderr, "Temperature: could not run the alert hook %s: %s\n", hook,
+			strerror(hookThread));
+		return;
+	}
+	resume_thread(hookThread);
+
+	// Never wait on the hook from the updater
+	thread_id reaper = spawn_thread(CallReapAlertHook, "Alert hook reaper",
+		B_LOW_PRIORITY, reinterpret_cast<void*>(static_cast<addr_t>(hookThread)));
+	if(reaper >= 0)
+		resume_thread(reaper);
+}
+
+/* static */
+int32 MainWindow::CallReapAlertHook(void* data)
+{
+	status_t exitCode = B_OK;
+	wait_for_thread(static_cast<thread_id>(reinterpret_cast<addr_t>(data)), &exitCode);
+	return exitCode;
+}
+
+void MainWindow::FormatSample(const ThermalSample& sample, BNumberFormat& format,
+	char scale, BString* outCurrent, BString* outCritical) const
+{
+	BString notAvailable(B_TRANSLATE_COMMENT("N/A",
+		"Abbreviated: when something is not available."));
+
+	const ThermalSnapshot& snapshot = sample.snapshot;
+
+	if(sample.status == B_OK && snapshot.IsReported(TEMPERATURE_CURRENT)) {
+		float currentTemp = snapshot.Temperature(TEMPERATURE_CURRENT);
+		float convertedTemp = ConvertToScale(currentTemp, SCALE_CELSIUS, scale);
+
+		format.Format(*outCurrent, static_cast<double>(convertedTemp));
+		outCurrent->Append(SymbolForScale(scale, 1));
+	}
+	else
+		outCurrent->SetTo(notAvailable);
+
+	if(sample.status == B_OK && snapshot.IsReported(TEMPERATURE_CRITICAL)) {
+		float criticalTemp = snapshot.Temperature(TEMPERATURE_CRITICAL);
+		float criticalConverted = ConvertToScale(criticalTemp, SCALE_CELSIUS, scale);
+
+		format.Format(*outCritical, static_cast<double>(criticalConverted));
+		outCritical->Append(SymbolForScale(scale, 1));
+	}
+	else
+		outCritical->SetTo(notAvailable);
+}
+
+void MainWindow::FormatSummary(const RollingSummary& summary, BNumberFormat& format,
+	char scale, BString* outText) const
+{
+	auto formatTemperature = [&](float celsius) {
+		BString string;
+		format.Format(string, static_cast<double>(ConvertToScale(celsius, SCALE_CELSIUS, scale)));
+		string.Append(SymbolForScale(scale, 1));
+		return string;
+	};
+
+	BString window;
+	int64 seconds = summary.window / 1000000;
+	if(seconds % 60 == 0) {
+		static BStringFormat minutesFormat(B_TRANSLATE(
+			"{0, plural, =1{Last minute} other{Last # minutes}}"));
+		minutesFormat.Format(window, static_cast<long>(seconds / 60));
+	}
+	else {
+		static BStringFormat secondsFormat(B_TRANSLATE(
+			"{0, plural, =1{Last second} other{Last # seconds}}"));
+		secondsFormat.Format(window, static_cast<long>(seconds));
+	}
+
+	// The deviation is a difference, so only the scale factor applies
+	BString deviation;
+	format.Format(deviation, static_cast<double>(ConvertToScale(summary.deviation,
+		SCALE_CELSIUS, scale) - ConvertToScale(0.0f, SCALE_CELSIUS, scale)));
+
+	outText->SetTo(B_TRANSLATE("%window%: min %min%, max %max%, "
+		"mean %mean% ± %deviation%, p95 %p95%, p99 %p99%"));
+	outText->ReplaceAll("%window%", window);
+	outText->ReplaceAll("%min%", formatTemperature(summary.minimum));
+	outText->ReplaceAll("%max%", formatTemperature(summary.maximum));
+	outText->ReplaceAll("%mean%", formatTemperature(summary.mean));
+	outText->ReplaceAll("%deviation%", deviation);
+	outText->ReplaceAll("%p95%", formatTemperature(summary.quantiles[QUANTILE_P95]));
+	outText->ReplaceAll("%p99%", formatTemperature(summary.quantiles[QUANTILE_P99]));
+}
+
+void MainWindow::FormatForecast(const CriticalForecast& forecast, BString* outText) const
+{
+	if(std::isnan(forecast.critical)) {
+		outText->SetTo("");
+		return;
+	}
+	if(forecast.seconds < 0) {
+		outText->SetTo(B_TRANSLATE("Not rising"));
+		return;
+	}
+	if(forecast.seconds == 0) {
+		outText->SetTo(B_TRANSLATE("Critical now"));
+		return;
+	}
+
+	int64 seconds = static_cast<int64>(ceilf(forecast.seconds));
+	if(seconds < 120) {
+		static BStringFormat secondsFormat(B_TRANSLATE(
+			"{0, plural, =1{Critical in a second} other{Critical in # seconds}}"));
+		secondsFormat.Format(*outText, static_cast<long>(seconds));
+	}
+	else if(seconds < 7200) {
+		static BStringFormat minutesFormat(B_TRANSLATE(
+			"{0, plural, other{Critical in # minutes}}"));
+		minutesFormat.Format(*outText, static_cast<long>(seconds / 60));
+	}
+	else {
+		static BStringFormat hoursFormat(B_TRANSLATE(
+			"{0, plural, other{Critical in # hours}}"));
+		hoursFormat.Format(*outText, static_cast<long>(seconds / 3600));
+	}
+}
@@ -9,12 +9,25 @@
 #include <Window.h>
 #include <View.h>
 #include <Button.h>
+#include <FilePanel.h>
+#include <Locker.h>
 #include <String.h>
 #include <TextControl.h>
+#include <NumberFormat.h>
 #include <atomic>
+#include <unordered_map>
+#include <vector>
 
+#include "AlertEngine.h"
+#include "CriticalForecast.h"
 #include "DataFactory.h"
 #include "GraphView.h"
+#include "HistoryStore.h"
+#include "RollingStatistics.h"
+#include "SampleArea.h"
+#include "SampleFeed.h"
+#include "SampleLog.h"
+#include "SamplerEngine.h"
 #include "ThermalDevice.h"
 
 class MainWindow : public BWindow
@@ -39,15 +52,76 @@ public:
 							{ shouldStopUpdater = !shouldRun; }
 
 			bool		HasDevice()  const;
+
+			HistoryStore* History() { return history; }
+			StatisticsStore* Statistics() { return statistics; }
+
+			// Of the displayed device
+			status_t	GetStatistics(RollingSummary* outSummary) const;
+			status_t	GetForecast(CriticalForecast* outForecast) const;
+			status_t	GetSamplerMetrics(SamplerMetrics* outMetrics) const;
+			int32		DisplayedDevice() const { return displayedDevice.load(); }
+			// Pushes M_TEMPERATURE_REPLY to target as samples of device arrive
+			status_t	SubscribeUpdates(int32 device, BMessenger target,
+							bigtime_t interval, float delta);
+			void		UnsubscribeUpdates(int32 device, BMessenger target);
+			// Newest sample the sampler read of device, B_NO_INIT when stopped
+			status_t	GetLatestSnapshot(int32 device, ThermalSnapshot* outSnapshot) const;
+			// Of each device, empty where none was read or when stopped
+			void		GetLatestSnapshots(const std::vector<int32>& devices,
+							std::vector<ThermalSnapshot>* outSnapshots) const;
+private:
+	// The settings the updater thread uses, copied with the window locked
+	struct UpdaterSettings {
+		char		scale;
+		BString		alertHook;
+	};
+
+			bool		FindLatestSample(int32 device, ThermalSample* outSample) const;
+			void		HandleSampleSubscription(BMessage* message);
+			void		SetStatisticsWindow(uint32 seconds);
+			void		ApplyRefreshRates();
+			void		ApplySamplingPolicy(int32 device);
+			void		ApplyAlertRules();
+			void		GetUpdaterSettings(UpdaterSettings* outSettings) const;
+			void		FireAlert(const AlertEvent& event, const UpdaterSettings& settings);
+	static	int32		CallReapAlertHook(void* data);
+			void		AddDeviceItem(const char* devicePath);
+			void		OpenSampleLog();
+			void		ShowExportPanel(int32 format);
+			void		ExportHistory(BMessage* message);
+	static	int32		CallExportHistory(void* data);
+			void		LogSamples(const ThermalSample* samples, int32 count);
+			void		ShareSamples(const ThermalSample* samples, int32 count);
+			void		FormatSample(const ThermalSample& sample, BNumberFormat& format,
+							char scale, BString* outCurrent, BString* outCritical) const;
+			void		FormatSummary(const RollingSummary& summary, BNumberFormat& format,
+							char scale, BString* outText) const;
+			void		FormatForecast(const CriticalForecast& forecast,
+							BString* outText) const;
 private:
 		DataFactory*	dataRepository;
-		ThermalDevice 	activeDevice;
+		SamplerEngine	samplerEngine;
+		std::atomic<int32> displayedDevice;
+		mutable BLocker	samplesLock;	// guards lastSamples, read off the window
+		std::unordered_map<int32, ThermalSample> lastSamples;
+		HistoryStore*	history;
+		StatisticsStore* statistics;
+		AlertEngine		alerts;
+		ForecastStore	forecasts;
+		SampleBroadcast	broadcast;
+		SampleArea		sharedSamples;
+		SampleLog		sampleLog;
+		bigtime_t		lastLogSync;
+		BFilePanel*		exportPanel;
 
 		GraphView*		temperatureGraph;
 		BMenuField*		devicesField;
 		BMenuField*		temperatureField;
 		BTextControl*	criticalTempControl;
 		BTextControl*	currentTempControl;
+		BStringView*	forecastView;
+		BStringView*	statisticsView;
 
 		thread_id		tempUpdaterThread;
 		std::atomic<bool> shouldStopUpdater;
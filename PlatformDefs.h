@@ -0,0 +1,387 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef __PLATFORM_DEFS__
+#define __PLATFORM_DEFS__
+
+/*
+ * The few kernel kit types and calls the sampling core needs. On Haiku they
+ * come from libroot; elsewhere they are mapped onto POSIX so the core can
+ * be built and run against a fake device tree on other hosts, together
+ * with the support kit lock the sampler engine guards its state with.
+ */
+
+#ifdef __HAIKU__
+
+#include <OS.h>
+#include <SupportDefs.h>
+
+#else
+
+#include <cerrno>
+#include <cstdint>
+#include <ctime>
+#include <pthread.h>
+
+typedef int32_t		int32;
+typedef uint32_t	uint32;
+typedef int64_t		int64;
+typedef uint64_t	uint64;
+typedef int32		status_t;
+typedef int64		bigtime_t;
+
+enum {
+	B_OK				= 0,
+	B_ERROR				= -1,
+	B_NO_MEMORY			= -ENOMEM,
+	B_IO_ERROR			= -EIO,
+	B_BAD_VALUE			= -EINVAL,
+	B_NO_INIT			= -ENODEV,
+	B_BUSY				= -EBUSY,
+	B_WOULD_BLOCK		= -EAGAIN,
+	B_INTERRUPTED		= -EINTR,
+	B_NAME_TOO_LONG		= -ENAMETOOLONG,
+	B_ENTRY_NOT_FOUND	= -ENOENT,
+	B_NAME_NOT_FOUND	= -ENXIO,
+	B_BAD_INDEX			= -EDOM,
+	B_TIMED_OUT			= -ETIMEDOUT,
+	B_BAD_SEM_ID		= -EIDRM,
+	B_BAD_THREAD_ID		= -ESRCH,
+	B_NO_MORE_SEMS		= -ENOSPC,
+	B_NO_MORE_THREADS	= -EMFILE
+};
+
+#define B_SYSTEM_TIMEBASE 0
+#define B_INFINITE_TIMEOUT INT64_MAX
+
+typedef int32		sem_id;
+typedef int32		thread_id;
+typedef int32		(*thread_func)(void* data);
+
+enum {
+	B_DO_NOT_RESCHEDULE	= 0x02,		// ignored
+	B_RELATIVE_TIMEOUT	= 0x08,
+	B_ABSOLUTE_TIMEOUT	= 0x10
+};
+
+enum {
+	B_LOW_PRIORITY		= 5,		// ignored
+	B_NORMAL_PRIORITY	= 10
+};
+
+inline bigtime_t
+system_time()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return static_cast<bigtime_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+inline bigtime_t
+real_time_clock_usecs()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	return static_cast<bigtime_t>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+inline status_t
+snooze_until(bigtime_t when, int /* timeBase */)
+{
+	struct timespec until;
+	until.tv_sec = when / 1000000;
+	until.tv_nsec = (when % 1000000) * 1000;
+	int result = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL);
+	return result == 0 ? B_OK : (result == EINTR ? B_INTERRUPTED : B_ERROR);
+}
+
+// #pragma mark - Semaphores
+
+/*
+ * Counting semaphores in a fixed table, all behind one mutex: the core
+ * only ever has a handful. Slots are reused, their condition variables are
+ * set up once and never destroyed, so a waiter woken by delete_sem() can
+ * still leave safely; the generation tells it the semaphore is gone.
+ */
+#define kPlatformMaxSemaphores 64
+
+struct PlatformSemaphore
+{
+	bool			used;
+	bool			initialized;
+	int32			count;
+	uint32			generation;
+	pthread_cond_t	condition;
+};
+
+inline pthread_mutex_t gPlatformSemaphoreLock = PTHREAD_MUTEX_INITIALIZER;
+inline PlatformSemaphore gPlatformSemaphores[kPlatformMaxSemaphores];
+
+inline PlatformSemaphore*
+platform_semaphore(sem_id id)
+{
+	if(id < 0 || id >= kPlatformMaxSemaphores || !gPlatformSemaphores[id].used)
+		return NULL;
+
+	return &gPlatformSemaphores[id];
+}
+
+inline sem_id
+create_sem(int32 count, const char* /* name */)
+{
+	if(count < 0)
+		return B_BAD_VALUE;
+
+	pthread_mutex_lock(&gPlatformSemaphoreLock);
+	for(sem_id id = 0; id < kPlatformMaxSemaphores; id++) {
+		PlatformSemaphore& semaphore = gPlatformSemaphores[id];
+		if(semaphore.used)
+			continue;
+
+		if(!semaphore.initialized) {
+			// Timeouts are given in system_time()
+			pthread_condattr_t attributes;
+			pthread_condattr_init(&attributes);
+			pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+			pthread_cond_init(&semaphore.condition, &attributes);
+			pthread_condattr_destroy(&attributes);
+			semaphore.initialized = true;
+		}
+		semaphore.used = true;
+		semaphore.count = count;
+		pthread_mutex_unlock(&gPlatformSemaphoreLock);
+		return id;
+	}
+	pthread_mutex_unlock(&gPlatformSemaphoreLock);
+
+	return B_NO_MORE_SEMS;
+}
+
+inline status_t
+delete_sem(sem_id id)
+{
+	pthread_mutex_lock(&gPlatformSemaphoreLock);
+	PlatformSemaphore* semaphore = platform_semaphore(id);
+	if(semaphore != NULL) {
+		semaphore->used = false;
+		semaphore->generation++;
+		pthread_cond_broadcast(&semaphore->condition);
+	}
+	pthread_mutex_unlock(&gPlatformSemaphoreLock);
+
+	return semaphore != NULL ? B_OK : B_BAD_SEM_ID;
+}
+
+inline status_t
+acquire_sem_etc(sem_id id, int32 count, uint32 flags, bigtime_t timeout)
+{
+	if(count < 1)
+		return B_BAD_VALUE;
+
+	pthread_mutex_lock(&gPlatformSemaphoreLock);
+	PlatformSemaphore* semaphore = platform_semaphore(id);
+	if(semaphore == NULL) {
+		pthread_mutex_unlock(&gPlatformSemaphoreLock);
+		return B_BAD_SEM_ID;
+	}
+
+	bigtime_t until = B_INFINITE_TIMEOUT;
+	if((flags & B_ABSOLUTE_TIMEOUT) != 0)
+		until = timeout;
+	else if((flags & B_RELATIVE_TIMEOUT) != 0 && timeout < B_INFINITE_TIMEOUT - system_time())
+		until = system_time() + timeout;
+
+	status_t status = B_OK;
+	uint32 generation = semaphore->generation;
+	while(semaphore->count < count && status == B_OK) {
+		if(until == B_INFINITE_TIMEOUT)
+			pthread_cond_wait(&semaphore->condition, &gPlatformSemaphoreLock);
+		else {
+			struct timespec deadline;
+			deadline.tv_sec = until / 1000000;
+			deadline.tv_nsec = (until % 1000000) * 1000;
+			if(pthread_cond_timedwait(&semaphore->condition, &gPlatformSemaphoreLock,
+					&deadline) == ETIMEDOUT)
+				status = B_TIMED_OUT;
+		}
+		if(semaphore->generation != generation)
+			status = B_BAD_SEM_ID;
+	}
+	if(status == B_TIMED_OUT && semaphore->count >= count)
+		status = B_OK;
+	if(status == B_OK)
+		semaphore->count -= count;
+	pthread_mutex_unlock(&gPlatformSemaphoreLock);
+
+	return status;
+}
+
+inline status_t
+acquire_sem(sem_id id)
+{
+	return acquire_sem_etc(id, 1, 0, 0);
+}
+
+inline status_t
+release_sem_etc(sem_id id, int32 count, uint32 /* flags */)
+{
+	if(count < 0)
+		return B_BAD_VALUE;
+
+	pthread_mutex_lock(&gPlatformSemaphoreLock);
+	PlatformSemaphore* semaphore = platform_semaphore(id);
+	if(semaphore != NULL) {
+		semaphore->count += count;
+		pthread_cond_broadcast(&semaphore->condition);
+	}
+	pthread_mutex_unlock(&gPlatformSemaphoreLock);
+
+	return semaphore != NULL ? B_OK : B_BAD_SEM_ID;
+}
+
+inline status_t
+release_sem(sem_id id)
+{
+	return release_sem_etc(id, 1, 0);
+}
+
+// #pragma mark - Threads
+
+/*
+ * Threads are spawned suspended, as on Haiku: the pthread is only created
+ * by resume_thread(). wait_for_thread() joins it and frees the slot.
+ */
+#define kPlatformMaxThreads 64
+
+struct PlatformThread
+{
+	bool			used;
+	bool			running;
+	pthread_t		thread;
+	thread_func		function;
+	void*			data;
+	status_t		exitCode;
+};
+
+inline pthread_mutex_t gPlatformThreadLock = PTHREAD_MUTEX_INITIALIZER;
+inline PlatformThread gPlatformThreads[kPlatformMaxThreads];
+
+inline void*
+platform_thread_entry(void* data)
+{
+	PlatformThread* thread = static_cast<PlatformThread*>(data);
+	thread->exitCode = thread->function(thread->data);
+	return NULL;
+}
+
+inline thread_id
+spawn_thread(thread_func function, const char* /* name */, int32 /* priority */,
+	void* data)
+{
+	if(function == NULL)
+		return B_BAD_VALUE;
+
+	pthread_mutex_lock(&gPlatformThreadLock);
+	for(thread_id id = 0; id < kPlatformMaxThreads; id++) {
+		PlatformThread& thread = gPlatformThreads[id];
+		if(thread.used)
+			continue;
+
+		thread.used = true;
+		thread.running = false;
+		thread.function = function;
+		thread.data = data;
+		thread.exitCode = B_OK;
+		pthread_mutex_unlock(&gPlatformThreadLock);
+		return id;
+	}
+	pthread_mutex_unlock(&gPlatformThreadLock);
+
+	return B_NO_MORE_THREADS;
+}
+
+inline status_t
+resume_thread(thread_id id)
+{
+	pthread_mutex_lock(&gPlatformThreadLock);
+	status_t status = B_OK;
+	if(id < 0 || id >= kPlatformMaxThreads || !gPlatformThreads[id].used)
+		status = B_BAD_THREAD_ID;
+	else if(!gPlatformThreads[id].running) {
+		PlatformThread& thread = gPlatformThreads[id];
+		if(pthread_create(&thread.thread, NULL, &platform_thread_entry, &thread) != 0)
+			status = B_NO_MORE_THREADS;
+		else
+			thread.running = true;
+	}
+	pthread_mutex_unlock(&gPlatformThreadLock);
+
+	return status;
+}
+
+inline status_t
+wait_for_thread(thread_id id, status_t* outExitCode)
+{
+	pthread_mutex_lock(&gPlatformThreadLock);
+	if(id < 0 || id >= kPlatformMaxThreads || !gPlatformThreads[id].used) {
+		pthread_mutex_unlock(&gPlatformThreadLock);
+		return B_BAD_THREAD_ID;
+	}
+	PlatformThread& thread = gPlatformThreads[id];
+	bool running = thread.running;
+	pthread_mutex_unlock(&gPlatformThreadLock);
+
+	// A thread that never ran is simply forgotten
+	if(running)
+		pthread_join(thread.thread, NULL);
+	if(outExitCode)
+		*outExitCode = thread.exitCode;
+
+	pthread_mutex_lock(&gPlatformThreadLock);
+	thread.used = false;
+	pthread_mutex_unlock(&gPlatformThreadLock);
+	return running ? B_OK : B_BAD_THREAD_ID;
+}
+
+// #pragma mark - Locks
+
+// Recursive, as the support kit lock is
+class BLocker
+{
+public:
+	BLocker(const char* /* name */ = NULL)
+	{
+		pthread_mutexattr_t attributes;
+		pthread_mutexattr_init(&attributes);
+		pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE);
+		pthread_mutex_init(&fMutex, &attributes);
+		pthread_mutexattr_destroy(&attributes);
+	}
+
+	~BLocker() { pthread_mutex_destroy(&fMutex); }
+
+	bool Lock() { return pthread_mutex_lock(&fMutex) == 0; }
+	void Unlock() { pthread_mutex_unlock(&fMutex); }
+private:
+	BLocker(const BLocker&);
+	BLocker& operator=(const BLocker&);
+
+	pthread_mutex_t fMutex;
+};
+
+class BAutolock
+{
+public:
+	BAutolock(BLocker& locker) : fLocker(locker) { fLocked = fLocker.Lock(); }
+	~BAutolock() { if(fLocked) fLocker.Unlock(); }
+
+	bool IsLocked() const { return fLocked; }
+private:
+	BLocker&	fLocker;
+	bool		fLocked;
+};
+
+#endif /* __HAIKU__ */
+
+#endif /* __PLATFORM_DEFS__ */
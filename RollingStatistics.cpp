@@ -0,0 +1,337 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <Autolock.h>
+#include <algorithm>
+#include <cmath>
+#include "RollingStatistics.h"
+
+static const double kQuantiles[QUANTILE_COUNT] = { 0.50, 0.95, 0.99 };
+
+// #pragma mark - P2Quantile
+
+P2Quantile::P2Quantile(double quantile)
+: fQuantile(quantile)
+{
+	Reset();
+}
+
+void
+P2Quantile::Reset()
+{
+	fCount = 0;
+}
+
+void
+P2Quantile::Add(double value)
+{
+	if(fCount < 5) {
+		fHeights[fCount++] = value;
+		if(fCount < 5)
+			return;
+
+		std::sort(fHeights, fHeights + 5);
+		double p = fQuantile;
+		double desired[5] = { 0, 2 * p, 4 * p, 2 + 2 * p, 4 };
+		double increments[5] = { 0, p / 2, p, (1 + p) / 2, 1 };
+		for(int32 i = 0; i < 5; i++) {
+			fPositions[i] = i;
+			fDesired[i] = desired[i];
+			fIncrements[i] = increments[i];
+		}
+		return;
+	}
+
+	// Find the cell the value falls in, stretching the ends if needed
+	int32 cell;
+	if(value < fHeights[0]) {
+		fHeights[0] = value;
+		cell = 0;
+	}
+	else if(value >= fHeights[4]) {
+		fHeights[4] = value;
+		cell = 3;
+	}
+	else {
+		cell = 0;
+		while(cell < 3 && value >= fHeights[cell + 1])
+			cell++;
+	}
+
+	for(int32 i = cell + 1; i < 5; i++)
+		fPositions[i]++;
+	for(int32 i = 0; i < 5; i++)
+		fDesired[i] += fIncrements[i];
+
+	// Move the middle markers one step when they drift too far
+	for(int32 i = 1; i <= 3; i++) {
+		double drift = fDesired[i] - fPositions[i];
+		if((drift >= 1 && fPositions[i + 1] - fPositions[i] > 1)
+			|| (drift <= -1 && fPositions[i - 1] - fPositions[i] < -1)) {
+			int32 direction = drift > 0 ? 1 : -1;
+			double height = Parabolic(i, direction);
+			if(fHeights[i - 1] < height && height < fHeights[i + 1])
+				fHeights[i] = height;
+			else
+				fHeights[i] = Linear(i, direction);
+			fPositions[i] += direction;
+		}
+	}
+
+	fCount++;
+}
+
+double
+P2Quantile::Value() const
+{
+	if(fCount == 0)
+		return 0;
+
+	if(fCount < 5) {
+		double sorted[5];
+		std::copy(fHeights, fHeights + fCount, sorted);
+		std::sort(sorted, sorted + fCount);
+		return sorted[static_cast<size_t>(fQuantile * (fCount - 1) + 0.5)];
+	}
+
+	return fHeights[2];
+}
+
+double
+P2Quantile::Parabolic(int32 i, int32 direction) const
+{
+	const double* n = fPositions;
+	const double* q = fHeights;
+	return q[i] + direction / (n[i + 1] - n[i - 1])
+		* ((n[i] - n[i - 1] + direction) * (q[i + 1] - q[i]) / (n[i + 1] - n[i])
+			+ (n[i + 1] - n[i] - direction) * (q[i] - q[i - 1]) / (n[i] - n[i - 1]));
+}
+
+double
+P2Quantile::Linear(int32 i, int32 direction) const
+{
+	return fHeights[i] + direction * (fHeights[i + direction] - fHeights[i])
+		/ (fPositions[i + direction] - fPositions[i]);
+}
+
+// #pragma mark - RollingStatistics
+
+RollingStatistics::RollingStatistics(bigtime_t window, size_t capacity)
+: fWindow(window > 0 ? window : 1),
+  fCapacity(capacity > 0 ? capacity : 1)
+{
+	fSamples = new Sample[fCapacity];
+	fMinimum.items = new Sample[fCapacity];
+	fMaximum.items = new Sample[fCapacity];
+	fMinimum.capacity = fMaximum.capacity = fCapacity;
+
+	for(int32 i = 0; i < 2; i++) {
+		for(int32 j = 0; j < QUANTILE_COUNT; j++)
+			fQuantiles[i][j] = P2Quantile(kQuantiles[j]);
+	}
+
+	MakeEmpty();
+}
+
+RollingStatistics::~RollingStatistics()
+{
+	delete[] fSamples;
+	delete[] fMinimum.items;
+	delete[] fMaximum.items;
+}
+
+void
+RollingStatistics::Add(bigtime_t when, float value)
+{
+	while(fCount > 0 && (fCount == fCapacity || when - fSamples[fStart].when > fWindow))
+		Evict();
+
+	Sample sample = { when, value, fSequence++ };
+	fSamples[(fStart + fCount) % fCapacity] = sample;
+	fCount++;
+
+	fMinimum.Push(sample, true);
+	fMaximum.Push(sample, false);
+
+	double delta = value - fMean;
+	fMean += delta / fCount;
+	fSquares += delta * (value - fMean);
+
+	if(fGenerationStart[0] < 0) {
+		fGenerationStart[0] = when;
+		fGenerationStart[1] = when + fWindow / 2;
+	}
+	for(int32 i = 0; i < 2; i++) {
+		if(when < fGenerationStart[i])
+			continue;
+
+		if(when - fGenerationStart[i] >= fWindow) {
+			for(int32 j = 0; j < QUANTILE_COUNT; j++)
+				fQuantiles[i][j].Reset();
+			fGenerationStart[i] = when;
+		}
+		for(int32 j = 0; j < QUANTILE_COUNT; j++)
+			fQuantiles[i][j].Add(value);
+	}
+}
+
+void
+RollingStatistics::MakeEmpty()
+{
+	fStart = 0;
+	fCount = 0;
+	fSequence = 0;
+	fMinimum.start = fMinimum.count = 0;
+	fMaximum.start = fMaximum.count = 0;
+	fMean = 0;
+	fSquares = 0;
+
+	for(int32 i = 0; i < 2; i++) {
+		for(int32 j = 0; j < QUANTILE_COUNT; j++)
+			fQuantiles[i][j].Reset();
+		fGenerationStart[i] = -1;
+	}
+}
+
+void
+RollingStatistics::GetSummary(RollingSummary* outSummary) const
+{
+	RollingSummary& summary = *outSummary;
+	summary.count = fCount;
+	summary.window = fWindow;
+	if(fCount == 0) {
+		summary.minimum = summary.maximum = summary.mean = summary.deviation = 0;
+		for(int32 i = 0; i < QUANTILE_COUNT; i++)
+			summary.quantiles[i] = 0;
+		return;
+	}
+
+	summary.minimum = fMinimum.Front().value;
+	summary.maximum = fMaximum.Front().value;
+	summary.mean = fMean;
+	summary.deviation = fCount > 1 ? sqrt(fSquares / (fCount - 1)) : 0;
+
+	int32 fuller = fQuantiles[1][0].Count() > fQuantiles[0][0].Count() ? 1 : 0;
+	for(int32 i = 0; i < QUANTILE_COUNT; i++)
+		summary.quantiles[i] = fQuantiles[fuller][i].Value();
+}
+
+void
+RollingStatistics::Evict()
+{
+	Sample oldest = fSamples[fStart];
+	fStart = (fStart + 1) % fCapacity;
+	fCount--;
+
+	fMinimum.PopFront(oldest.sequence);
+	fMaximum.PopFront(oldest.sequence);
+
+	if(fCount == 0) {
+		fMean = 0;
+		fSquares = 0;
+		return;
+	}
+
+	double delta = oldest.value - fMean;
+	fMean -= delta / fCount;
+	fSquares -= delta * (oldest.value - fMean);
+	if(fSquares < 0)
+		fSquares = 0;
+}
+
+void
+RollingStatistics::MonotonicQueue::Push(const Sample& sample, bool keepLower)
+{
+	// Drop whatever can no longer be the extreme while this sample lives
+	while(count > 0) {
+		const Sample& back = At(count - 1);
+		if(keepLower ? back.value < sample.value : back.value > sample.value)
+			break;
+		count--;
+	}
+
+	items[(start + count) % capacity] = sample;
+	count++;
+}
+
+void
+RollingStatistics::MonotonicQueue::PopFront(uint64 sequence)
+{
+	if(count > 0 && items[start].sequence == sequence) {
+		start = (start + 1) % capacity;
+		count--;
+	}
+}
+
+// #pragma mark - StatisticsStore
+
+StatisticsStore::StatisticsStore(bigtime_t window)
+: fLock("Statistics store"),
+  fWindow(window)
+{
+}
+
+StatisticsStore::~StatisticsStore()
+{
+	for(auto& statistics : fStatistics)
+		delete statistics.second;
+}
+
+void
+StatisticsStore::Add(int32 device, bigtime_t when, float value)
+{
+	BAutolock lock(fLock);
+	auto found = fStatistics.find(device);
+	if(found == fStatistics.end())
+		found = fStatistics.insert(std::make_pair(device, new RollingStatistics(fWindow))).first;
+
+	found->second->Add(when, value);
+}
+
+void
+StatisticsStore::RemoveDevice(int32 device)
+{
+	BAutolock lock(fLock);
+	auto found = fStatistics.find(device);
+	if(found == fStatistics.end())
+		return;
+
+	delete found->second;
+	fStatistics.erase(found);
+}
+
+status_t
+StatisticsStore::GetSummary(int32 device, RollingSummary* outSummary) const
+{
+	if(!outSummary)
+		return B_BAD_VALUE;
+
+	BAutolock lock(fLock);
+	auto found = fStatistics.find(device);
+	if(found == fStatistics.end())
+		return B_NAME_NOT_FOUND;
+
+	found->second->GetSummary(outSummary);
+	return B_OK;
+}
+
+void
+StatisticsStore::SetWindow(bigtime_t window)
+{
+	BAutolock lock(fLock);
+	if(window <= 0 || window == fWindow)
+		return;
+
+	fWindow = window;
+	for(auto& statistics : fStatistics)
+		delete statistics.second;
+	fStatistics.clear();
+}
+
+bigtime_t
+StatisticsStore::Window() const
+{
+	BAutolock lock(fLock);
+	return fWindow;
+}
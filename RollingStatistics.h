@@ -0,0 +1,143 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef __ROLLING_STATISTICS__
+#define __ROLLING_STATISTICS__
+
+#include <Locker.h>
+#include <SupportDefs.h>
+#include <map>
+
+#define kDefaultStatisticsWindow	300		// seconds
+#define kStatisticsCapacity			4096	// samples kept per window at most
+
+enum StatisticsQuantile {
+	QUANTILE_P50 = 0,
+	QUANTILE_P95,
+	QUANTILE_P99,
+
+	QUANTILE_COUNT
+};
+
+struct RollingSummary
+{
+	uint32		count;
+	bigtime_t	window;
+	float		minimum;
+	float		maximum;
+	float		mean;
+	float		deviation;		// standard deviation
+	float		quantiles[QUANTILE_COUNT];
+};
+
+/*
+ * P-square estimate of one quantile (Jain and Chlamtac, 1985): five
+ * markers are nudged towards their ideal positions as values arrive, so
+ * memory and work per value are constant. The first five values are kept
+ * as they are and answered exactly.
+ */
+class P2Quantile
+{
+public:
+						P2Quantile(double quantile = 0.5);
+
+			void		Reset();
+			void		Add(double value);
+			double		Value() const;
+			uint32		Count() const { return fCount; }
+private:
+			double		Parabolic(int32 i, int32 direction) const;
+			double		Linear(int32 i, int32 direction) const;
+private:
+			double		fQuantile;
+			double		fHeights[5];
+			double		fPositions[5];
+			double		fDesired[5];
+			double		fIncrements[5];
+			uint32		fCount;
+};
+
+/*
+ * Statistics of one series over a sliding time window, updated in
+ * amortized O(1) per sample: monotonic queues give the minimum and
+ * maximum, Welford's method with removal gives mean and variance. The
+ * quantile sketches cannot forget values, so two of them run staggered by
+ * half a window and restart when a window old; the fuller one answers,
+ * covering between half and a whole window. Storage is fixed on creation.
+ */
+class RollingStatistics
+{
+public:
+						RollingStatistics(bigtime_t window,
+							size_t capacity = kStatisticsCapacity);
+						~RollingStatistics();
+
+			void		Add(bigtime_t when, float value);
+			void		MakeEmpty();
+
+			void		GetSummary(RollingSummary* outSummary) const;
+			bigtime_t	Window() const { return fWindow; }
+private:
+	struct Sample {
+		bigtime_t	when;
+		float		value;
+		uint64		sequence;
+	};
+
+	// Bounded double-ended queue of samples with monotonic values
+	struct MonotonicQueue {
+		Sample*		items;
+		size_t		capacity;
+		size_t		start;
+		size_t		count;
+
+		Sample& At(size_t index) { return items[(start + index) % capacity]; }
+		const Sample& Front() const { return items[start]; }
+		void Push(const Sample& sample, bool keepLower);
+		void PopFront(uint64 sequence);
+	};
+
+			void		Evict();
+private:
+			bigtime_t	fWindow;
+			Sample*		fSamples;		// the window, oldest first
+			size_t		fCapacity;
+			size_t		fStart;
+			size_t		fCount;
+			uint64		fSequence;
+
+			MonotonicQueue fMinimum;
+			MonotonicQueue fMaximum;
+
+			double		fMean;
+			double		fSquares;		// sum of squared differences from the mean
+
+			P2Quantile	fQuantiles[2][QUANTILE_COUNT];
+			bigtime_t	fGenerationStart[2];
+};
+
+/*
+ * Thread safe collection of RollingStatistics keyed by device id.
+ */
+class StatisticsStore
+{
+public:
+						StatisticsStore(bigtime_t window
+							= kDefaultStatisticsWindow * 1000000LL);
+						~StatisticsStore();
+
+			void		Add(int32 device, bigtime_t when, float value);
+			void		RemoveDevice(int32 device);
+			status_t	GetSummary(int32 device, RollingSummary* outSummary) const;
+
+			// Starts every device over
+			void		SetWindow(bigtime_t window);
+			bigtime_t	Window() const;
+private:
+	mutable BLocker		fLock;
+	std::map<int32, RollingStatistics*> fStatistics;
+	bigtime_t			fWindow;
+};
+
+#endif /* __ROLLING_STATISTICS__ */
@@ -0,0 +1,431 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <cstring>
+#include <unistd.h>
+#include "SampleArea.h"
+
+#ifndef __HAIKU__
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+static size_t
+MappedSize()
+{
+#ifdef __HAIKU__
+	return (sizeof(SampleAreaLayout) + B_PAGE_SIZE - 1) / B_PAGE_SIZE * B_PAGE_SIZE;
+#else
+	size_t page = sysconf(_SC_PAGESIZE);
+	return (sizeof(SampleAreaLayout) + page - 1) / page * page;
+#endif
+}
+
+// Copies the newest count samples of the slot, oldest first. Returns how
+//	many were copied, or B_BUSY when the writer kept changing the slot.
+static int32
+ReadSlot(const SharedDevice& slot, SharedSample* outSamples, int32 count)
+{
+	for(int32 attempt = 0; attempt < kSampleAreaRetries; attempt++) {
+		uint32 sequence = slot.sequence.load(std::memory_order_acquire);
+		if(sequence & 1)
+			continue;
+
+		uint64 written = slot.count;
+		int32 copied = written < (uint64)count ? written : count;
+		for(int32 i = 0; i < copied; i++) {
+			uint64 index = written - copied + i;
+			memcpy(&outSamples[i], &slot.ring[index & (kSampleAreaRingSize - 1)],
+				sizeof(SharedSample));
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if(slot.sequence.load(std::memory_order_relaxed) == sequence)
+			return copied;
+	}
+
+	return B_BUSY;
+}
+
+static bool
+IsValidLayout(const SampleAreaLayout* layout)
+{
+	return layout->magic == kSampleAreaMagic && layout->version == kSampleAreaVersion
+		&& layout->size == sizeof(SampleAreaLayout)
+		&& layout->deviceCount.load(std::memory_order_acquire) <= kSampleAreaDevices;
+}
+
+#ifndef __HAIKU__
+// The process publishing the object behind fd, negative while it is not a
+//	complete area of this version
+static pid_t
+WriterOf(int fd)
+{
+	struct stat info;
+	if(fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(SampleAreaLayout))
+		return -1;
+
+	void* address = mmap(NULL, MappedSize(), PROT_READ, MAP_SHARED, fd, 0);
+	if(address == MAP_FAILED)
+		return -1;
+
+	const SampleAreaLayout* layout = static_cast<const SampleAreaLayout*>(address);
+	std::atomic_thread_fence(std::memory_order_acquire);
+	pid_t writer = IsValidLayout(layout) ? layout->writer : -1;
+	munmap(address, MappedSize());
+	return writer;
+}
+
+// Removes the object a writer that crashed left behind, but never the one
+//	of a writer that still runs
+static status_t
+RemoveStaleObject()
+{
+	int fd = shm_open(kSampleAreaName, O_RDONLY, 0);
+	if(fd < 0)
+		return errno == ENOENT ? B_OK : -errno;
+
+	pid_t writer = WriterOf(fd);
+	if(writer < 0) {
+		// It may have only just been created, give its writer time to finish
+		usleep(10000);
+		writer = WriterOf(fd);
+	}
+	close(fd);
+
+	if(writer > 0 && (kill(writer, 0) == 0 || errno == EPERM))
+		return B_BUSY;
+
+	shm_unlink(kSampleAreaName);
+	return B_OK;
+}
+#endif
+
+// #pragma mark - SampleArea
+
+SampleArea::SampleArea()
+: fLayout(NULL)
+#ifdef __HAIKU__
+  , fArea(-1)
+#endif
+{
+}
+
+SampleArea::~SampleArea()
+{
+	Unset();
+}
+
+status_t
+SampleArea::Init()
+{
+	Unset();
+
+	void* address = NULL;
+#ifdef __HAIKU__
+	// Areas go away with their team, one that is found has a live writer
+	if(find_area(kSampleAreaName) >= 0)
+		return B_BUSY;
+
+	fArea = create_area(kSampleAreaName, &address, B_ANY_ADDRESS, MappedSize(),
+		B_NO_LOCK, B_READ_AREA | B_WRITE_AREA | B_CLONEABLE_AREA);
+	if(fArea < 0)
+		return fArea;
+#else
+	int fd = shm_open(kSampleAreaName, O_RDWR | O_CREAT | O_EXCL, 0644);
+	if(fd < 0 && errno == EEXIST) {
+		status_t status = RemoveStaleObject();
+		if(status != B_OK)
+			return status;
+		fd = shm_open(kSampleAreaName, O_RDWR | O_CREAT | O_EXCL, 0644);
+	}
+	if(fd < 0)
+		return errno == EEXIST ? B_BUSY : -errno;
+	if(ftruncate(fd, MappedSize()) != 0) {
+		status_t status = -errno;
+		close(fd);
+		shm_unlink(kSampleAreaName);
+		return status;
+	}
+	address = mmap(NULL, MappedSize(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(address == MAP_FAILED) {
+		shm_unlink(kSampleAreaName);
+		return B_NO_MEMORY;
+	}
+#endif
+
+	// The memory comes zeroed; readers check the magic last
+	fLayout = static_cast<SampleAreaLayout*>(address);
+	fLayout->version = kSampleAreaVersion;
+	fLayout->size = sizeof(SampleAreaLayout);
+	fLayout->writer = getpid();
+	std::atomic_thread_fence(std::memory_order_release);
+	fLayout->magic = kSampleAreaMagic;
+	return B_OK;
+}
+
+void
+SampleArea::Unset()
+{
+	if(fLayout == NULL)
+		return;
+
+#ifdef __HAIKU__
+	delete_area(fArea);
+	fArea = -1;
+#else
+	// The name may lead to another writer's object by now
+	int fd = shm_open(kSampleAreaName, O_RDONLY, 0);
+	if(fd >= 0) {
+		if(WriterOf(fd) == getpid())
+			shm_unlink(kSampleAreaName);
+		close(fd);
+	}
+	munmap(fLayout, MappedSize());
+#endif
+	fLayout = NULL;
+}
+
+status_t
+SampleArea::InitCheck() const
+{
+	return fLayout != NULL ? B_OK : B_NO_INIT;
+}
+
+bool
+SampleArea::HasDevice(int32 device) const
+{
+	return fLayout != NULL && SlotFor(device) != NULL;
+}
+
+status_t
+SampleArea::RegisterDevice(int32 device, const char* path)
+{
+	if(fLayout == NULL)
+		return B_NO_INIT;
+	if(SlotFor(device) != NULL)
+		return B_OK;
+
+	uint32 count = fLayout->deviceCount.load(std::memory_order_relaxed);
+	if(count == kSampleAreaDevices)
+		return B_NO_MEMORY;
+
+	// Filled in before it is counted, readers never see it half done
+	SharedDevice* slot = &fLayout->devices[count];
+	slot->id = device;
+	strncpy(slot->path, path ? path : "", kSampleAreaPathSize - 1);
+	slot->path[kSampleAreaPathSize - 1] = '\0';
+	fLayout->deviceCount.store(count + 1, std::memory_order_release);
+	return B_OK;
+}
+
+status_t
+SampleArea::Publish(int32 device, const ThermalSnapshot& snapshot)
+{
+	if(fLayout == NULL)
+		return B_NO_INIT;
+
+	SharedDevice* slot = SlotFor(device);
+	if(slot == NULL)
+		return B_ENTRY_NOT_FOUND;
+
+	SharedSample sample;
+	sample.when = snapshot.timestamp;
+	sample.reported = 0;
+	for(int32 i = 0; i < TEMPERATURE_COUNT; i++) {
+		DeviceTemperature which = static_cast<DeviceTemperature>(i);
+		sample.temperatures[i] = snapshot.Temperature(which);
+		if(snapshot.IsReported(which))
+			sample.reported |= 1 << i;
+	}
+
+	uint32 sequence = slot->sequence.load(std::memory_order_relaxed);
+	slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	slot->ring[slot->count & (kSampleAreaRingSize - 1)] = sample;
+	slot->count++;
+
+	slot->sequence.store(sequence + 2, std::memory_order_release);
+	return B_OK;
+}
+
+status_t
+SampleArea::GetLatest(int32 device, ThermalSnapshot* outSnapshot) const
+{
+	if(!outSnapshot)
+		return B_BAD_VALUE;
+	if(fLayout == NULL)
+		return B_NO_INIT;
+
+	const SharedDevice* slot = SlotFor(device);
+	if(slot == NULL)
+		return B_ENTRY_NOT_FOUND;
+
+	SharedSample sample;
+	int32 read = ReadSlot(*slot, &sample, 1);
+	if(read < 0)
+		return read;
+	if(read == 0)
+		return B_NO_INIT;
+
+	SampleAreaReader::ToSnapshot(sample, outSnapshot);
+	return B_OK;
+}
+
+SharedDevice*
+SampleArea::SlotFor(int32 device) const
+{
+	uint32 count = fLayout->deviceCount.load(std::memory_order_acquire);
+	for(uint32 i = 0; i < count; i++) {
+		if(fLayout->devices[i].id == device)
+			return &fLayout->devices[i];
+	}
+
+	return NULL;
+}
+
+// #pragma mark - SampleAreaReader
+
+SampleAreaReader::SampleAreaReader()
+: fLayout(NULL)
+#ifdef __HAIKU__
+  , fArea(-1)
+#endif
+{
+}
+
+SampleAreaReader::~SampleAreaReader()
+{
+	Unset();
+}
+
+status_t
+SampleAreaReader::Init()
+{
+	Unset();
+
+	void* address = NULL;
+#ifdef __HAIKU__
+	area_id source = find_area(kSampleAreaName);
+	if(source < 0)
+		return source;
+	fArea = clone_area("Temperature samples (reader)", &address, B_ANY_ADDRESS,
+		B_READ_AREA, source);
+	if(fArea < 0)
+		return fArea;
+#else
+	int fd = shm_open(kSampleAreaName, O_RDONLY, 0);
+	if(fd < 0)
+		return -errno;
+	address = mmap(NULL, MappedSize(), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(address == MAP_FAILED)
+		return B_NO_MEMORY;
+#endif
+
+	fLayout = static_cast<const SampleAreaLayout*>(address);
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if(!IsValidLayout(fLayout)) {
+		Unset();
+		return B_BAD_VALUE;
+	}
+	return B_OK;
+}
+
+void
+SampleAreaReader::Unset()
+{
+	if(fLayout == NULL)
+		return;
+
+#ifdef __HAIKU__
+	delete_area(fArea);
+	fArea = -1;
+#else
+	munmap(const_cast<SampleAreaLayout*>(fLayout), MappedSize());
+#endif
+	fLayout = NULL;
+}
+
+status_t
+SampleAreaReader::InitCheck() const
+{
+	return fLayout != NULL ? B_OK : B_NO_INIT;
+}
+
+int32
+SampleAreaReader::CountDevices() const
+{
+	if(fLayout == NULL)
+		return 0;
+
+	return fLayout->deviceCount.load(std::memory_order_acquire);
+}
+
+int32
+SampleAreaReader::FindDevice(const char* path) const
+{
+	if(!path)
+		return B_BAD_VALUE;
+
+	int32 count = CountDevices();
+	for(int32 i = 0; i < count; i++) {
+		if(strncmp(fLayout->devices[i].path, path, kSampleAreaPathSize) == 0)
+			return i;
+	}
+
+	return B_ENTRY_NOT_FOUND;
+}
+
+status_t
+SampleAreaReader::GetDevice(int32 index, int32* outId, const char** outPath) const
+{
+	if(index < 0 || index >= CountDevices())
+		return B_BAD_VALUE;
+
+	if(outId)
+		*outId = fLayout->devices[index].id;
+	if(outPath)
+		*outPath = fLayout->devices[index].path;
+	return B_OK;
+}
+
+status_t
+SampleAreaReader::ReadLatest(int32 index, SharedSample* outSample) const
+{
+	if(!outSample || index < 0 || index >= CountDevices())
+		return B_BAD_VALUE;
+
+	int32 read = ReadSlot(fLayout->devices[index], outSample, 1);
+	if(read < 0)
+		return read;
+	return read == 1 ? B_OK : B_NO_INIT;
+}
+
+int32
+SampleAreaReader::ReadRecent(int32 index, SharedSample* outSamples, int32 maxCount) const
+{
+	if(!outSamples || maxCount < 0 || index < 0 || index >= CountDevices())
+		return B_BAD_VALUE;
+
+	if(maxCount > kSampleAreaRingSize)
+		maxCount = kSampleAreaRingSize;
+	return ReadSlot(fLayout->devices[index], outSamples, maxCount);
+}
+
+/* static */
+void
+SampleAreaReader::ToSnapshot(const SharedSample& sample, ThermalSnapshot* outSnapshot)
+{
+	outSnapshot->MakeEmpty();
+	outSnapshot->timestamp = sample.when;
+	for(int32 i = 0; i < TEMPERATURE_COUNT; i++) {
+		outSnapshot->temperatures[i] = sample.temperatures[i];
+		outSnapshot->reported[i] = (sample.reported & (1 << i)) != 0;
+	}
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef __SAMPLE_AREA__
+#define __SAMPLE_AREA__
+
+#include <atomic>
+#include "PlatformDefs.h"
+#include "ThermalDevice.h"
+
+#ifdef __HAIKU__
+#define kSampleAreaName		"Temperature samples"	// an area
+#else
+#define kSampleAreaName		"/temperature-samples"	// a POSIX shared memory object
+#endif
+
+#define kSampleAreaMagic	0x544d5053	// 'TMPS'
+#define kSampleAreaVersion	2
+#define kSampleAreaDevices	16
+#define kSampleAreaRingSize	256			// samples kept per device
+#define kSampleAreaPathSize	128
+#define kSampleAreaRetries	64			// reads racing the writer before giving up
+
+static_assert((kSampleAreaRingSize & (kSampleAreaRingSize - 1)) == 0,
+	"ring size must be a power of two");
+static_assert(std::atomic<uint32>::is_always_lock_free,
+	"shared counters must not need a lock");
+
+struct SharedSample
+{
+	bigtime_t	when;			// system time of the read
+	float		temperatures[TEMPERATURE_COUNT];	// Celsius
+	uint32		reported;		// bit (1 << DeviceTemperature) when reported
+};
+
+/*
+ * Layout of the shared memory, the same in every process. Each device is
+ * guarded by its own sequence counter, odd while the writer is changing
+ * it: a reader copies what it needs and retries if the counter moved in
+ * between. Slots are handed out once and never reused, so the id and path
+ * of the first deviceCount slots can be read without the counter.
+ */
+struct SharedDevice
+{
+	std::atomic<uint32>	sequence;
+	int32		id;
+	char		path[kSampleAreaPathSize];
+	uint64		count;			// samples written, the newest is at count - 1
+	SharedSample ring[kSampleAreaRingSize];
+};
+
+struct SampleAreaLayout
+{
+	uint32		magic;
+	uint32		version;
+	uint32		size;			// of this structure
+	int32		writer;			// team or process that publishes it
+	std::atomic<uint32>	deviceCount;
+	SharedDevice devices[kSampleAreaDevices];
+};
+
+/*
+ * Publishes the samples of the sampler into shared memory so other
+ * programs on the machine can read them without messaging the
+ * application or touching the devices. RegisterDevice() and Publish()
+ * must always be called from the same thread; the others from any.
+ */
+class SampleArea
+{
+public:
+						SampleArea();
+						~SampleArea();
+
+			// B_BUSY while another writer publishes the area
+			status_t	Init();
+			void		Unset();
+			status_t	InitCheck() const;
+
+			bool		HasDevice(int32 device) const;
+			// B_NO_MEMORY once kSampleAreaDevices are registered
+			status_t	RegisterDevice(int32 device, const char* path);
+			status_t	Publish(int32 device, const ThermalSnapshot& snapshot);
+			status_t	GetLatest(int32 device, ThermalSnapshot* outSnapshot) const;
+private:
+			SharedDevice* SlotFor(int32 device) const;
+private:
+			SampleAreaLayout* fLayout;
+#ifdef __HAIKU__
+			area_id		fArea;
+#endif
+};
+
+/*
+ * Read-only view of the area published by a running sampler. Reading
+ * never blocks and never makes a system call.
+ */
+class SampleAreaReader
+{
+public:
+						SampleAreaReader();
+						~SampleAreaReader();
+
+			status_t	Init();
+			void		Unset();
+			status_t	InitCheck() const;
+
+			int32		CountDevices() const;
+			// Index of the slot, negative when not published
+			int32		FindDevice(const char* path) const;
+			status_t	GetDevice(int32 index, int32* outId, const char** outPath) const;
+
+			status_t	ReadLatest(int32 index, SharedSample* outSample) const;
+			// Oldest first, returns how many were written or an error
+			int32		ReadRecent(int32 index, SharedSample* outSamples,
+							int32 maxCount) const;
+
+	static	void		ToSnapshot(const SharedSample& sample,
+							ThermalSnapshot* outSnapshot);
+private:
+			const SampleAreaLayout* fLayout;
+#ifdef __HAIKU__
+			area_id		fArea;
+#endif
+};
+
+#endif /* __SAMPLE_AREA__ */
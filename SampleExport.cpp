@@ -0,0 +1,351 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include "SampleExport.h"
+
+// Longest line Add() writes: a path escaped twice over at most, and the numbers
+#define kSampleExportMaxLine (2 * kSampleLogDevicePathSize + 96)
+
+static const char* kFormatNames[EXPORT_FORMAT_COUNT] = { "csv", "influx", "binary" };
+
+// snprintf() is most of the time of a large export, the numbers are simple
+//	enough to write by hand.
+static char*
+PutUnsigned(char* out, uint64_t value, int minimumDigits = 1)
+{
+	char digits[24];
+	int count = 0;
+	do {
+		digits[count++] = '0' + value % 10;
+		value /= 10;
+	} while(value > 0 || count < minimumDigits);
+
+	while(count > 0)
+		*out++ = digits[--count];
+	return out;
+}
+
+static char*
+PutCentiDegrees(char* out, int32_t centiDegrees)
+{
+	if(centiDegrees < 0) {
+		*out++ = '-';
+		centiDegrees = -centiDegrees;
+	}
+	out = PutUnsigned(out, centiDegrees / 100);
+	*out++ = '.';
+	return PutUnsigned(out, centiDegrees % 100, 2);
+}
+
+static char*
+PutString(char* out, const char* value)
+{
+	while(*value != '\0')
+		*out++ = *value++;
+	return out;
+}
+
+// CSV fields holding a separator, quote or line break are quoted
+static char*
+PutField(char* out, const char* value)
+{
+	if(strpbrk(value, ",\"\n") == NULL)
+		return PutString(out, value);
+
+	*out++ = '"';
+	for(; *value != '\0'; value++) {
+		if(*value == '"')
+			*out++ = '"';
+		*out++ = *value;
+	}
+	*out++ = '"';
+	return out;
+}
+
+// Tag values of the line protocol escape commas, spaces and equal signs
+static char*
+PutTagValue(char* out, const char* value)
+{
+	for(; *value != '\0'; value++) {
+		if(*value == ',' || *value == ' ' || *value == '=')
+			*out++ = '\\';
+		*out++ = *value;
+	}
+	return out;
+}
+
+static int
+WriteFully(int fd, const void* data, size_t length)
+{
+	const char* cursor = static_cast<const char*>(data);
+	while(length > 0) {
+		ssize_t written = write(fd, cursor, length);
+		if(written < 0) {
+			if(errno == EINTR)
+				continue;
+			return errno;
+		}
+		cursor += written;
+		length -= written;
+	}
+
+	return 0;
+}
+
+// #pragma mark - SampleExporter
+
+SampleExporter::SampleExporter(int fd, SampleExportFormat format)
+:
+fFD(fd),
+fFormat(format),
+fStatus(0),
+fCount(0),
+fDeviceCount(0),
+fLength(0)
+{
+}
+
+int32_t
+SampleExporter::AddDevice(const char* path)
+{
+	int32_t index = FindDevice(path);
+	if(index >= 0)
+		return index;
+	if(fDeviceCount == kSampleLogMaxDevices || path == NULL)
+		return -1;
+
+	SampleLogDevice& device = fDevices[fDeviceCount];
+	device.id = fDeviceCount;
+	strncpy(device.path, path, kSampleLogDevicePathSize - 1);
+	device.path[kSampleLogDevicePathSize - 1] = '\0';
+	return fDeviceCount++;
+}
+
+int32_t
+SampleExporter::FindDevice(const char* path) const
+{
+	if(path == NULL)
+		return -1;
+
+	for(uint32_t i = 0; i < fDeviceCount; i++) {
+		if(strncmp(fDevices[i].path, path, kSampleLogDevicePathSize - 1) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+int
+SampleExporter::Begin()
+{
+	if(fFormat == EXPORT_CSV) {
+		static const char kHeader[] = "time,device,celsius\n";
+		memcpy(fBuffer + fLength, kHeader, sizeof(kHeader) - 1);
+		fLength += sizeof(kHeader) - 1;
+	}
+	else if(fFormat == EXPORT_BINARY) {
+		SampleExportHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, kSampleExportMagic, sizeof(kSampleExportMagic));
+		header.version = kSampleExportVersion;
+		header.recordSize = sizeof(SampleExportRecord);
+		header.deviceCount = fDeviceCount;
+		memcpy(header.devices, fDevices, sizeof(fDevices[0]) * fDeviceCount);
+		fStatus = WriteFully(fFD, &header, sizeof(header));
+	}
+
+	return fStatus;
+}
+
+int
+SampleExporter::Add(int32_t device, int64_t when, int32_t centiDegrees)
+{
+	if(device < 0 || device >= static_cast<int32_t>(fDeviceCount))
+		return EINVAL;
+	if(fStatus != 0)
+		return fStatus;
+	if(fLength + kSampleExportMaxLine > sizeof(fBuffer) && Flush() != 0)
+		return fStatus;
+
+	char* out = fBuffer + fLength;
+	uint64_t time = when > 0 ? when : 0;
+	switch(fFormat) {
+		case EXPORT_CSV:
+			out = PutUnsigned(out, time / 1000000);
+			*out++ = '.';
+			out = PutUnsigned(out, time % 1000000 / 1000, 3);
+			*out++ = ',';
+			out = PutField(out, fDevices[device].path);
+			*out++ = ',';
+			out = PutCentiDegrees(out, centiDegrees);
+			*out++ = '\n';
+			break;
+		case EXPORT_LINE_PROTOCOL:
+			out = PutString(out, "temperature,device=");
+			out = PutTagValue(out, fDevices[device].path);
+			out = PutString(out, " celsius=");
+			out = PutCentiDegrees(out, centiDegrees);
+			*out++ = ' ';
+			out = PutUnsigned(out, time * 1000);
+			*out++ = '\n';
+			break;
+		case EXPORT_BINARY:
+		default:
+		{
+			SampleExportRecord record = { when, device, centiDegrees };
+			memcpy(out, &record, sizeof(record));
+			out += sizeof(record);
+			break;
+		}
+	}
+
+	fLength = out - fBuffer;
+	fCount++;
+	return 0;
+}
+
+int
+SampleExporter::Finish()
+{
+	Flush();
+	return fStatus;
+}
+
+/* static */
+const char*
+SampleExporter::FormatName(SampleExportFormat format)
+{
+	if(format < 0 || format >= EXPORT_FORMAT_COUNT)
+		return NULL;
+
+	return kFormatNames[format];
+}
+
+/* static */
+int
+SampleExporter::ParseFormat(const char* name, SampleExportFormat* outFormat)
+{
+	if(name == NULL || outFormat == NULL)
+		return EINVAL;
+
+	for(int32_t i = 0; i < EXPORT_FORMAT_COUNT; i++) {
+		if(strcmp(name, kFormatNames[i]) == 0) {
+			*outFormat = static_cast<SampleExportFormat>(i);
+			return 0;
+		}
+	}
+
+	return EINVAL;
+}
+
+int
+SampleExporter::Flush()
+{
+	if(fStatus == 0 && fLength > 0)
+		fStatus = WriteFully(fFD, fBuffer, fLength);
+
+	fLength = 0;
+	return fStatus;
+}
+
+// #pragma mark - Public
+
+int
+ExportSampleLog(const char* directory, int fd, SampleExportFormat format,
+	int64_t since, int64_t until, const char* devicePath, uint64_t* outCount)
+{
+	if(directory == NULL || fd < 0 || format < 0 || format >= EXPORT_FORMAT_COUNT)
+		return EINVAL;
+
+	// Archives hold the segments compacted away, so they come first
+	const int32_t maxNames = kSampleLogMaxArchives + kSampleLogMaxSegments * 4;
+	char (*names)[64] = new char[maxNames][64];
+	int32_t archiveCount = SampleLog::ListSegments(directory, names,
+		kSampleLogMaxArchives, kSampleLogArchiveExtension);
+	int32_t count = archiveCount + SampleLog::ListSegments(directory,
+		names + archiveCount, maxNames - archiveCount);
+
+	SampleExporter* exporter = new SampleExporter(fd, format);
+	int16_t* lookup = new int16_t[0x10000];	// log device tag to exporter device
+	memset(lookup, 0xff, sizeof(int16_t) * 0x10000);
+
+	// Every device goes into the binary header, so they are all known
+	//	before the first sample. Only headers are touched here.
+	for(int32_t pass = 0; pass < 2; pass++) {
+		if(pass == 1 && exporter->Begin() != 0)
+			break;
+
+		for(int32_t i = 0; i < count; i++) {
+			char path[1024 + 64];
+			int length = snprintf(path, sizeof(path), "%s/%s", directory, names[i]);
+			if(length < 0 || length >= (int)sizeof(path))
+				continue;
+
+			SampleLogArchive archive;
+			SampleLogSegment segment;
+			const SampleLogHeader* header = NULL;
+			if(i < archiveCount && archive.Open(path) == 0)
+				header = archive.Header();
+			else if(i >= archiveCount && segment.Open(path) == 0)
+				header = segment.Header();
+			if(header == NULL || header->baseTime >= until)
+				continue;
+
+			for(uint32_t d = 0; d < header->deviceCount; d++) {
+				const SampleLogDevice& device = header->devices[d];
+				if(devicePath != NULL && strcmp(device.path, devicePath) != 0)
+					continue;
+				if(pass == 0)
+					exporter->AddDevice(device.path);
+				else
+					lookup[device.id + 1] = exporter->FindDevice(device.path);
+			}
+			if(pass == 0)
+				continue;
+
+			int64_t base = header->baseTime;
+			if(i < archiveCount) {
+				archive.ForEachChunk([&](int32_t device, uint32_t, SeriesDecoder& decoder) {
+					int32_t index = lookup[static_cast<uint16_t>(device + 1)];
+					int64_t delta;
+					int32_t value;
+					while(index >= 0 && decoder.Next(&delta, &value)) {
+						int64_t when = base + delta * 1000;
+						if(when >= since && when < until)
+							exporter->Add(index, when, value);
+					}
+				});
+			}
+			else {
+				// Records are in time order within a segment
+				const SampleLogRecord* records = segment.Records();
+				for(size_t r = 0; r < segment.Count(); r++) {
+					int64_t when = base + static_cast<int64_t>(records[r].delta) * 1000;
+					if(when >= until)
+						break;
+					int32_t index = lookup[records[r].device];
+					if(index >= 0 && when >= since)
+						exporter->Add(index, when, records[r].centiDegrees);
+				}
+			}
+
+			// Ids are only meaningful within their file
+			for(uint32_t d = 0; d < header->deviceCount; d++)
+				lookup[header->devices[d].id + 1] = -1;
+		}
+	}
+
+	int status = exporter->Finish();
+	if(outCount != NULL)
+		*outCount = exporter->Count();
+
+	delete[] lookup;
+	delete exporter;
+	delete[] names;
+	return status;
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef __SAMPLE_EXPORT__
+#define __SAMPLE_EXPORT__
+
+/*
+ * Streams the samples of a sample log directory, archives first and then
+ * the live segments, as CSV, InfluxDB line protocol or packed binary
+ * records. Output goes through one fixed buffer and the log is read in
+ * place, so memory use does not depend on how much is exported and the
+ * output may be a pipe. Like SampleLog, only the C++ standard library and
+ * POSIX are used, and functions returning int give 0 or an errno code.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include "SampleLog.h"
+
+#define kSampleExportMagic		"TMPEXP1"
+#define kSampleExportVersion	1
+#define kSampleExportBufferSize	(64 * 1024)
+
+enum SampleExportFormat {
+	EXPORT_CSV = 0,				// time,device,celsius with a header line
+	EXPORT_LINE_PROTOCOL,		// temperature,device=PATH celsius=VALUE NANOSECONDS
+	EXPORT_BINARY,				// SampleExportHeader, then SampleExportRecord
+
+	EXPORT_FORMAT_COUNT
+};
+
+/*
+ * Binary exports, in host byte order. The device of a record is its index
+ * in the header's device table, whatever id it had in the log.
+ */
+struct SampleExportHeader
+{
+	char			magic[8];
+	uint32_t		version;
+	uint32_t		recordSize;
+	uint32_t		deviceCount;
+	uint32_t		reserved;
+	SampleLogDevice	devices[kSampleLogMaxDevices];
+};
+
+struct SampleExportRecord
+{
+	int64_t		when;			// real time, in µs
+	int32_t		device;
+	int32_t		centiDegrees;	// degrees Celsius * 100, as logged
+};
+
+static_assert(sizeof(SampleExportRecord) == 16, "records must be 16 bytes wide");
+
+/*
+ * Formats samples into the fixed buffer and writes it out whenever it
+ * fills up. Devices are added before Begin() and referred to by the index
+ * AddDevice() returns.
+ */
+class SampleExporter
+{
+public:
+							SampleExporter(int fd, SampleExportFormat format);
+
+			// Index of the device, -1 once kSampleLogMaxDevices are added
+			int32_t			AddDevice(const char* path);
+			int32_t			FindDevice(const char* path) const;
+
+			int				Begin();
+			int				Add(int32_t device, int64_t when, int32_t centiDegrees);
+			int				Finish();
+
+			uint64_t		Count() const { return fCount; }
+
+	// "csv", "influx" or "binary"; NULL for an unknown format
+	static	const char*		FormatName(SampleExportFormat format);
+	static	int				ParseFormat(const char* name, SampleExportFormat* outFormat);
+private:
+			int				Flush();
+private:
+	int						fFD;
+	SampleExportFormat		fFormat;
+	int						fStatus;		// first write error, kept until Finish()
+	uint64_t				fCount;
+
+	SampleLogDevice			fDevices[kSampleLogMaxDevices];
+	uint32_t				fDeviceCount;
+
+	char					fBuffer[kSampleExportBufferSize];
+	size_t					fLength;
+};
+
+// Exports the samples taken in [since, until), real time in µs, of every
+//	device or only of the one at devicePath. outCount may be NULL.
+int		ExportSampleLog(const char* directory, int fd, SampleExportFormat format,
+			int64_t since, int64_t until, const char* devicePath, uint64_t* outCount);
+
+#endif /* __SAMPLE_EXPORT__ */
@@ -0,0 +1,432 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <Autolock.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "SampleFeed.h"
+#include "TemperatureDefs.h"
+
+enum {
+	M_FEED_POLL		= 'fpol',
+	M_FEED_CHECK	= 'fchk'
+};
+
+SampleFeed* SampleFeed::sDefault = NULL;
+static BLocker sDefaultLock("Sample feed creation");
+
+static void
+MakeBroadcast(BMessage* message, const char* path, const ThermalSnapshot& snapshot)
+{
+	message->what = M_SAMPLE_BROADCAST;
+	message->AddString("path", path);
+	message->AddFloat("temperature", snapshot.Temperature(TEMPERATURE_CURRENT));
+	message->AddInt64("when", snapshot.timestamp);
+}
+
+// Tells a feed that it will not be sent samples any more
+static void
+NotifyRevoked(const BMessenger& target, const char* path, status_t reason)
+{
+	BMessage message(M_SAMPLES_SUBSCRIBED);
+	message.AddString("path", path);
+	message.AddInt32("status", reason);
+	target.SendMessage(&message, (BHandler*)NULL, 0);
+}
+
+// #pragma mark - SampleBroadcast
+
+SampleBroadcast::SampleBroadcast()
+: fLock("Sample broadcast")
+{
+}
+
+void
+SampleBroadcast::Subscribe(int32 device, const char* path, BMessenger target,
+	uint32 what, bigtime_t interval, float delta)
+{
+	BAutolock lock(fLock);
+	Device& entry = fDevices[device];
+	entry.path.SetTo(path);
+	for(Subscriber& subscriber : entry.subscribers) {
+		if(subscriber.target == target) {
+			subscriber.what = what;
+			subscriber.interval = interval;
+			subscriber.delta = delta;
+			return;
+		}
+	}
+
+	Subscriber subscriber = { target, what, interval, delta, 0, 0, 0 };
+	entry.subscribers.push_back(subscriber);
+}
+
+void
+SampleBroadcast::Unsubscribe(int32 device, BMessenger target)
+{
+	BAutolock lock(fLock);
+	auto found = fDevices.find(device);
+	if(found == fDevices.end())
+		return;
+
+	std::vector<Subscriber>& subscribers = found->second.subscribers;
+	subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(),
+		[&target](const Subscriber& subscriber) { return subscriber.target == target; }),
+		subscribers.end());
+	if(subscribers.empty())
+		fDevices.erase(found);
+}
+
+bool
+SampleBroadcast::HasSubscribers(int32 device) const
+{
+	BAutolock lock(fLock);
+	return fDevices.find(device) != fDevices.end();
+}
+
+void
+SampleBroadcast::RevokeFeeds(int32 device, status_t reason)
+{
+	BAutolock lock(fLock);
+	auto found = fDevices.find(device);
+	if(found == fDevices.end())
+		return;
+
+	std::vector<Subscriber>& subscribers = found->second.subscribers;
+	for(auto subscriber = subscribers.begin(); subscriber != subscribers.end();) {
+		if(subscriber->what != M_SAMPLE_BROADCAST) {
+			subscriber++;
+			continue;
+		}
+
+		NotifyRevoked(subscriber->target, found->second.path, reason);
+		subscriber = subscribers.erase(subscriber);
+	}
+	if(subscribers.empty())
+		fDevices.erase(found);
+}
+
+void
+SampleBroadcast::Publish(const ThermalSample& sample)
+{
+	if(sample.status != B_OK || !sample.snapshot.IsReported(TEMPERATURE_CURRENT))
+		return;
+
+	BAutolock lock(fLock);
+	auto found = fDevices.find(sample.device);
+	if(found == fDevices.end())
+		return;
+
+	float value = sample.snapshot.Temperature(TEMPERATURE_CURRENT);
+	bigtime_t when = sample.snapshot.timestamp;
+	BMessage message;
+	MakeBroadcast(&message, found->second.path, sample.snapshot);
+	message.AddInt32("device", sample.device);
+
+	// Never wait on a busy subscriber, and forget the ones that are gone
+	std::vector<Subscriber>& subscribers = found->second.subscribers;
+	for(auto subscriber = subscribers.begin(); subscriber != subscribers.end();) {
+		bool due = subscriber->lastSent == 0
+			|| (subscriber->interval <= 0 && subscriber->delta <= 0)
+			|| (subscriber->interval > 0 && when - subscriber->lastSent >= subscriber->interval)
+			|| (subscriber->delta > 0 && fabsf(value - subscriber->lastValue) >= subscriber->delta);
+		if(!due) {
+			subscriber++;
+			continue;
+		}
+
+		message.what = subscriber->what;
+		status_t status = subscriber->target.SendMessage(&message, (BHandler*)NULL, 0);
+		if(status == B_OK) {
+			subscriber->lastSent = when;
+			subscriber->lastValue = value;
+			subscriber->failures = 0;
+		}
+		if(status == B_BAD_PORT_ID)
+			subscriber = subscribers.erase(subscriber);
+		else if(status != B_OK && ++subscriber->failures >= kBroadcastMaxFailures) {
+			// Likely lost too, the feed then notices the silence itself
+			if(subscriber->what == M_SAMPLE_BROADCAST)
+				NotifyRevoked(subscriber->target, found->second.path, B_WOULD_BLOCK);
+			subscriber = subscribers.erase(subscriber);
+		}
+		else
+			subscriber++;
+	}
+	if(subscribers.empty())
+		fDevices.erase(found);
+}
+
+// #pragma mark - SampleFeed
+
+/* static */
+status_t
+SampleFeed::Subscribe(const char* path, bigtime_t interval, BMessenger target)
+{
+	if(!path || strlen(path) == 0 || interval <= 0 || !target.IsValid())
+		return B_BAD_VALUE;
+
+	BAutolock lock(sDefaultLock);
+	if(sDefault == NULL) {
+		sDefault = new SampleFeed;
+		sDefault->Run();
+	}
+
+	BAutolock feedLock(sDefault);
+	sDefault->AddSubscriber(path, interval, target);
+	return B_OK;
+}
+
+/* static */
+void
+SampleFeed::Unsubscribe(const char* path, BMessenger target)
+{
+	BAutolock lock(sDefaultLock);
+	if(sDefault == NULL || !path)
+		return;
+
+	sDefault->Lock();
+	if(sDefault->RemoveSubscriber(path, target) && sDefault->fFeeds.empty()) {
+		// The code of a replicant may be unloaded once its views are gone
+		sDefault->Quit();
+		sDefault = NULL;
+		return;
+	}
+	sDefault->Unlock();
+}
+
+void
+SampleFeed::MessageReceived(BMessage* message)
+{
+	switch(message->what)
+	{
+		case M_FEED_POLL:
+			Poll(message->GetString("path", ""));
+			break;
+		case M_FEED_CHECK:
+			CheckHost();
+			break;
+		case M_SAMPLES_SUBSCRIBED:
+		{
+			auto found = fFeeds.find(BString(message->GetString("path", "")));
+			if(found == fFeeds.end())
+				break;
+
+			// Also sent when the application drops the feed later on. A
+			//	feed that fell behind asks again with the next check.
+			Feed& feed = found->second;
+			status_t status = message->GetInt32("status", B_ERROR);
+			feed.requested = false;
+			feed.hosted = status == B_OK;
+			feed.refused = status != B_OK && status != B_WOULD_BLOCK;
+			feed.lastBroadcast = system_time();
+			UpdatePolling(found->first, feed);
+			break;
+		}
+		case M_SAMPLE_BROADCAST:
+		{
+			BString path(message->GetString("path", ""));
+			auto found = fFeeds.find(path);
+			if(found != fFeeds.end() && found->second.hosted) {
+				found->second.lastBroadcast = system_time();
+				Distribute(path, message);
+			}
+			break;
+		}
+		default:
+			BLooper::MessageReceived(message);
+			break;
+	}
+}
+
+// #pragma mark - Private
+
+SampleFeed::SampleFeed()
+: BLooper("Sample feed", B_LOW_PRIORITY),
+  fChecker(NULL)
+{
+	BMessage check(M_FEED_CHECK);
+	fChecker = new BMessageRunner(BMessenger(this), &check, kSampleFeedCheckInterval);
+}
+
+SampleFeed::~SampleFeed()
+{
+	delete fChecker;
+	for(auto& feed : fFeeds) {
+		delete feed.second.poller;
+		delete feed.second.device;
+	}
+}
+
+void
+SampleFeed::AddSubscriber(const char* path, bigtime_t interval, BMessenger target)
+{
+	auto found = fFeeds.find(BString(path));
+	if(found == fFeeds.end()) {
+		Feed feed;
+		feed.device = NULL;
+		feed.poller = NULL;
+		feed.interval = 0;
+		feed.hosted = false;
+		feed.requested = false;
+		feed.refused = false;
+		feed.lastBroadcast = 0;
+		found = fFeeds.insert(std::make_pair(BString(path), feed)).first;
+	}
+
+	Feed& feed = found->second;
+	bool known = false;
+	for(Subscriber& subscriber : feed.subscribers) {
+		if(subscriber.target == target) {
+			subscriber.interval = interval;
+			known = true;
+		}
+	}
+	if(!known) {
+		Subscriber subscriber = { target, interval };
+		feed.subscribers.push_back(subscriber);
+	}
+
+	UpdatePolling(found->first, feed);
+	CheckHost();
+}
+
+bool
+SampleFeed::RemoveSubscriber(const char* path, BMessenger target)
+{
+	auto found = fFeeds.find(BString(path));
+	if(found == fFeeds.end())
+		return false;
+
+	Feed& feed = found->second;
+	feed.subscribers.erase(std::remove_if(feed.subscribers.begin(), feed.subscribers.end(),
+		[&target](const Subscriber& subscriber) { return subscriber.target == target; }),
+		feed.subscribers.end());
+	if(!feed.subscribers.empty()) {
+		UpdatePolling(found->first, feed);
+		return true;
+	}
+
+	if(feed.hosted || feed.requested) {
+		BMessage request(M_SAMPLES_UNSUBSCRIBE);
+		request.AddString("path", path);
+		request.AddMessenger("target", BMessenger(this));
+		fHost.SendMessage(&request, (BHandler*)NULL, 0);
+	}
+	delete feed.poller;
+	delete feed.device;
+	fFeeds.erase(found);
+	return true;
+}
+
+void
+SampleFeed::UpdatePolling(const BString& path, Feed& feed)
+{
+	if(feed.hosted || feed.subscribers.empty()) {
+		delete feed.poller;
+		feed.poller = NULL;
+		delete feed.device;
+		feed.device = NULL;
+		return;
+	}
+
+	// One read per period for every view that wants the device
+	bigtime_t interval = feed.subscribers[0].interval;
+	for(const Subscriber& subscriber : feed.subscribers)
+		interval = std::min(interval, subscriber.interval);
+	interval = std::max(interval, (bigtime_t)kMinimumRefreshInterval);
+
+	if(feed.device == NULL) {
+		feed.device = new ThermalDevice;
+		feed.device->SetTo(path);
+	}
+	if(feed.poller != NULL && feed.interval == interval)
+		return;
+
+	bool started = feed.poller == NULL;
+	delete feed.poller;
+	BMessage poll(M_FEED_POLL);
+	poll.AddString("path", path);
+	feed.poller = new BMessageRunner(BMessenger(this), &poll, interval);
+	feed.interval = interval;
+	if(started)
+		Poll(path);
+}
+
+void
+SampleFeed::CheckHost()
+{
+	BMessenger host(kTemperatureMime);
+	if(!host.IsValid() || host.Team() != fHost.Team()) {
+		// Gone or started again: poll until the new one answers
+		fHost = host;
+		for(auto& feed : fFeeds) {
+			feed.second.hosted = false;
+			feed.second.requested = false;
+			feed.second.refused = false;
+			UpdatePolling(feed.first, feed.second);
+		}
+	}
+	if(!fHost.IsValid())
+		return;
+
+	bigtime_t now = system_time();
+	for(auto& feed : fFeeds) {
+		// The application may have stopped sending without being able to
+		//	say so; poll meanwhile and ask again.
+		if(feed.second.hosted && now - feed.second.lastBroadcast > kSampleFeedSilenceTimeout) {
+			feed.second.hosted = false;
+			UpdatePolling(feed.first, feed.second);
+		}
+
+		if(feed.second.subscribers.empty() || feed.second.hosted
+			|| feed.second.requested || feed.second.refused)
+			continue;
+
+		BMessage request(M_SAMPLES_SUBSCRIBE);
+		request.AddString("path", feed.first);
+		request.AddMessenger("target", BMessenger(this));
+		if(fHost.SendMessage(&request, (BHandler*)NULL, 0) == B_OK)
+			feed.second.requested = true;
+	}
+}
+
+void
+SampleFeed::Distribute(BString path, BMessage* message)
+{
+	auto found = fFeeds.find(path);
+	if(found == fFeeds.end())
+		return;
+
+	// Views that went away without unsubscribing are dropped here
+	std::vector<Subscriber>& subscribers = found->second.subscribers;
+	for(auto subscriber = subscribers.begin(); subscriber != subscribers.end();) {
+		if(subscriber->target.SendMessage(message, (BHandler*)NULL, 0) == B_BAD_PORT_ID)
+			subscriber = subscribers.erase(subscriber);
+		else
+			subscriber++;
+	}
+	if(subscribers.empty() && found->second.poller != NULL) {
+		// Callers may be walking fFeeds, only stop reading the device
+		UpdatePolling(found->first, found->second);
+	}
+}
+
+void
+SampleFeed::Poll(const BString& path)
+{
+	auto found = fFeeds.find(path);
+	if(found == fFeeds.end() || found->second.device == NULL)
+		return;
+
+	ThermalSnapshot snapshot;
+	if(found->second.device->ReadSnapshot(&snapshot) != B_OK
+		|| !snapshot.IsReported(TEMPERATURE_CURRENT))
+		return;
+
+	BMessage message;
+	MakeBroadcast(&message, path, snapshot);
+	Distribute(path, &message);
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef __SAMPLE_FEED__
+#define __SAMPLE_FEED__
+
+#include <Locker.h>
+#include <Looper.h>
+#include <MessageRunner.h>
+#include <Messenger.h>
+#include <String.h>
+#include <SupportDefs.h>
+#include <map>
+#include <vector>
+#include "SamplerEngine.h"
+#include "TemperatureDefs.h"
+#include "ThermalDevice.h"
+
+#define kSampleFeedCheckInterval 2000000	// how often the host is looked for
+#define kSampleFeedSilenceTimeout 30000000	// hosted feeds quiet for longer are polled
+#define kBroadcastMaxFailures	16		// full queues in a row before a subscriber is dropped
+
+/*
+ * Application side: the messengers that asked for the samples of each
+ * device. Subscribers receive what (M_SAMPLE_BROADCAST for replicants)
+ * with "device" (int32), "path" (string), "temperature" (float, Celsius)
+ * and "when" (int64, system time). A subscriber may coalesce its updates:
+ * it is sent one once interval has passed since the last, or sooner when
+ * the temperature moved by delta or more; with neither it gets every
+ * sample. Publish() never waits on a subscriber and forgets the ones that
+ * are gone or have not taken a message for kBroadcastMaxFailures samples.
+ * Replicant feeds that are dropped get M_SAMPLES_SUBSCRIBED with the reason
+ * as "status", so that they read the device themselves.
+ */
+class SampleBroadcast
+{
+public:
+						SampleBroadcast();
+
+			// Subscribing again changes what, interval and delta
+			void		Subscribe(int32 device, const char* path, BMessenger target,
+							uint32 what = M_SAMPLE_BROADCAST, bigtime_t interval = 0,
+							float delta = 0);
+			void		Unsubscribe(int32 device, BMessenger target);
+			bool		HasSubscribers(int32 device) const;
+			// Drops the replicant feeds of a device that is gone; other
+			//	subscribers stay for when it comes back.
+			void		RevokeFeeds(int32 device, status_t reason);
+
+			void		Publish(const ThermalSample& sample);
+private:
+	struct Subscriber {
+		BMessenger		target;
+		uint32			what;
+		bigtime_t		interval;
+		float			delta;
+		bigtime_t		lastSent;	// of the last sample sent, 0 before the first
+		float			lastValue;
+		uint32			failures;
+	};
+
+	struct Device {
+		BString					path;
+		std::vector<Subscriber>	subscribers;
+	};
+
+	mutable BLocker		fLock;
+	std::map<int32, Device> fDevices;
+};
+
+/*
+ * Replicant side: process-wide source of samples for standalone graphs,
+ * keyed by device path. While the Temperature application runs, its
+ * sampler pushes samples here and no device is read in this process;
+ * otherwise each device is polled once, at the shortest interval asked
+ * for, however many views want it. The feed quits with its last
+ * subscriber, so nothing keeps running once the replicants are gone.
+ */
+class SampleFeed : public BLooper
+{
+public:
+	static	status_t	Subscribe(const char* path, bigtime_t interval,
+							BMessenger target);
+	static	void		Unsubscribe(const char* path, BMessenger target);
+
+			void		MessageReceived(BMessage* message) override;
+private:
+						SampleFeed();
+						~SampleFeed() override;
+
+	struct Subscriber {
+		BMessenger		target;
+		bigtime_t		interval;
+	};
+
+	struct Feed {
+		std::vector<Subscriber> subscribers;
+		ThermalDevice*	device;		// only while polling
+		BMessageRunner*	poller;
+		bigtime_t		interval;
+		bool			hosted;		// the application sends the samples
+		bool			requested;	// waiting for the application to answer
+		bool			refused;	// the application does not know the device
+		bigtime_t		lastBroadcast;	// while hosted
+	};
+
+			void		AddSubscriber(const char* path, bigtime_t interval,
+							BMessenger target);
+			bool		RemoveSubscriber(const char* path, BMessenger target);
+			void		UpdatePolling(const BString& path, Feed& feed);
+			void		CheckHost();
+			void		Distribute(BString path, BMessage* message);
+			void		Poll(const BString& path);
+private:
+	std::map<BString, Feed> fFeeds;
+	BMessenger			fHost;
+	BMessageRunner*		fChecker;
+
+	static	SampleFeed*	sDefault;
+};
+
+#endif /* __SAMPLE_FEED__ */
@@ -0,0 +1,766 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "SampleLog.h"
+
+#ifdef __HAIKU__
+#include <OS.h>
+#elif defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+static const char kSegmentPrefix[] = "samples-";
+
+static bool
+IsSegmentName(const char* name, const char* extension)
+{
+	size_t length = strlen(name);
+	size_t prefixLength = sizeof(kSegmentPrefix) - 1;
+	size_t extensionLength = strlen(extension);
+	return length > prefixLength + extensionLength && length < 64
+		&& strncmp(name, kSegmentPrefix, prefixLength) == 0
+		&& strcmp(name + length - extensionLength, extension) == 0;
+}
+
+// Directory plus entry name, false rather than a truncated path
+static bool
+JoinPath(char* buffer, size_t size, const char* directory, const char* name)
+{
+	int length = snprintf(buffer, size, "%s/%s", directory, name);
+	return length >= 0 && static_cast<size_t>(length) < size;
+}
+
+static bool
+IsValidHeader(const SampleLogHeader* header, size_t fileSize)
+{
+	return memcmp(header->magic, kSampleLogMagic, sizeof(kSampleLogMagic)) == 0
+		&& header->version == kSampleLogVersion
+		&& header->recordSize == sizeof(SampleLogRecord)
+		&& header->deviceCount <= kSampleLogMaxDevices
+		&& header->capacity <= (fileSize - kSampleLogHeaderSize) / sizeof(SampleLogRecord);
+}
+
+static int
+WriteFully(int fd, const void* data, size_t length)
+{
+	const char* cursor = static_cast<const char*>(data);
+	while(length > 0) {
+		ssize_t written = write(fd, cursor, length);
+		if(written < 0) {
+			if(errno == EINTR)
+				continue;
+			return errno;
+		}
+		cursor += written;
+		length -= written;
+	}
+
+	return 0;
+}
+
+static int
+WriteChunk(int fd, int32_t device, SeriesEncoder& encoder)
+{
+	SampleLogChunk chunk;
+	chunk.device = static_cast<uint16_t>(device + 1);
+	chunk.reserved = 0;
+	chunk.count = encoder.Count();
+	chunk.length = static_cast<uint32_t>(encoder.Finish());
+
+	int status = WriteFully(fd, &chunk, sizeof(chunk));
+	if(status != 0)
+		return status;
+
+	return WriteFully(fd, encoder.Data(), chunk.length);
+}
+
+// Compaction must not compete with the sampling threads
+static void
+LowerThreadPriority()
+{
+#ifdef __HAIKU__
+	set_thread_priority(find_thread(NULL), B_LOW_PRIORITY);
+#elif defined(__linux__)
+	// Linux applies nice values to single threads
+	setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+#endif
+}
+
+// #pragma mark - SampleLogSegment
+
+SampleLogSegment::SampleLogSegment()
+: fMapping(NULL),
+  fMappingSize(0),
+  fHeader(NULL),
+  fRecords(NULL),
+  fCount(0)
+{
+}
+
+SampleLogSegment::~SampleLogSegment()
+{
+	Close();
+}
+
+int
+SampleLogSegment::Open(const char* path)
+{
+	Close();
+
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+		return errno;
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size < kSampleLogHeaderSize) {
+		close(fd);
+		return EINVAL;
+	}
+
+	void* mapping = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(mapping == MAP_FAILED)
+		return errno;
+
+	const SampleLogHeader* header = static_cast<const SampleLogHeader*>(mapping);
+	if(!IsValidHeader(header, st.st_size)) {
+		munmap(mapping, st.st_size);
+		return EINVAL;
+	}
+
+	fMapping = mapping;
+	fMappingSize = st.st_size;
+	fHeader = header;
+	fRecords = reinterpret_cast<const SampleLogRecord*>(
+		static_cast<const char*>(mapping) + kSampleLogHeaderSize);
+	fCount = CountValid(fRecords, header->capacity);
+	return 0;
+}
+
+void
+SampleLogSegment::Close()
+{
+	if(fMapping != NULL)
+		munmap(fMapping, fMappingSize);
+
+	fMapping = NULL;
+	fMappingSize = 0;
+	fHeader = NULL;
+	fRecords = NULL;
+	fCount = 0;
+}
+
+int64_t
+SampleLogSegment::TimeAt(size_t index) const
+{
+	if(index >= fCount)
+		return -1;
+
+	return fHeader->baseTime + static_cast<int64_t>(fRecords[index].delta) * 1000;
+}
+
+/* static */
+size_t
+SampleLogSegment::CountValid(const SampleLogRecord* records, size_t capacity)
+{
+	uint32_t last = 0;
+	for(size_t i = 0; i < capacity; i++) {
+		if(records[i].device == 0 || records[i].delta < last)
+			return i;
+		last = records[i].delta;
+	}
+
+	return capacity;
+}
+
+// #pragma mark - SampleLogArchive
+
+SampleLogArchive::SampleLogArchive()
+: fMapping(NULL),
+  fMappingSize(0),
+  fHeader(NULL)
+{
+}
+
+SampleLogArchive::~SampleLogArchive()
+{
+	Close();
+}
+
+int
+SampleLogArchive::Open(const char* path)
+{
+	Close();
+
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if(fd < 0)
+		return errno;
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(SampleLogHeader)) {
+		close(fd);
+		return EINVAL;
+	}
+
+	void* mapping = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(mapping == MAP_FAILED)
+		return errno;
+
+	const SampleLogHeader* header = static_cast<const SampleLogHeader*>(mapping);
+	if(memcmp(header->magic, kSampleLogArchiveMagic, sizeof(kSampleLogArchiveMagic)) != 0
+		|| header->version != kSampleLogVersion
+		|| header->deviceCount > kSampleLogMaxDevices) {
+		munmap(mapping, st.st_size);
+		return EINVAL;
+	}
+
+	fMapping = mapping;
+	fMappingSize = st.st_size;
+	fHeader = header;
+	return 0;
+}
+
+void
+SampleLogArchive::Close()
+{
+	if(fMapping != NULL)
+		munmap(fMapping, fMappingSize);
+
+	fMapping = NULL;
+	fMappingSize = 0;
+	fHeader = NULL;
+}
+
+// #pragma mark - SampleLog
+
+SampleLog::SampleLog()
+: fLockFD(-1),
+  fFD(-1),
+  fMapping(NULL),
+  fMappingSize(0),
+  fHeader(NULL),
+  fRecords(NULL),
+  fCount(0),
+  fSegmentRecords(kSampleLogSegmentRecords),
+  fMaxSegments(kSampleLogMaxSegments),
+  fRotations(0),
+  fDeviceCount(0),
+  fRotatePending(false),
+  fCompactorRunning(false),
+  fPrunePending(false),
+  fCompactorQuit(false),
+  fFailedAttempts(0)
+{
+	fDirectory[0] = '\0';
+	fFailedSegment[0] = '\0';
+	pthread_mutex_init(&fCompactorLock, NULL);
+	pthread_cond_init(&fCompactorCondition, NULL);
+}
+
+SampleLog::~SampleLog()
+{
+	Close();
+	pthread_cond_destroy(&fCompactorCondition);
+	pthread_mutex_destroy(&fCompactorLock);
+}
+
+int
+SampleLog::Open(const char* directory, size_t segmentRecords, int32_t maxSegments)
+{
+	if(directory == NULL || strlen(directory) >= sizeof(fDirectory) || segmentRecords == 0)
+		return EINVAL;
+
+	Close();
+
+	if(mkdir(directory, 0755) != 0 && errno != EEXIST)
+		return errno;
+
+	// Only one writer per directory, e.g. the window and a daemon
+	char lockPath[sizeof(fDirectory) + 8];
+	snprintf(lockPath, sizeof(lockPath), "%s/.lock", directory);
+	fLockFD = open(lockPath, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if(fLockFD < 0)
+		return errno;
+	if(flock(fLockFD, LOCK_EX | LOCK_NB) != 0) {
+		int status = errno == EWOULDBLOCK ? EBUSY : errno;
+		close(fLockFD);
+		fLockFD = -1;
+		return status;
+	}
+
+	strcpy(fDirectory, directory);
+	fSegmentRecords = segmentRecords;
+	fMaxSegments = maxSegments > 0 ? maxSegments : 1;
+
+	int status = StartCompactor();
+	if(status != 0) {
+		Close();
+		return status;
+	}
+
+	// Continue the newest segment if it still has room, the new one is
+	//	otherwise created with the first record.
+	char names[kSampleLogMaxSegments * 4][64];
+	int32_t count = ListSegments(fDirectory, names, kSampleLogMaxSegments * 4);
+	if(count > 0) {
+		char path[sizeof(fDirectory) + 64];
+		if(JoinPath(path, sizeof(path), fDirectory, names[count - 1]))
+			ReopenSegment(path);
+	}
+
+	return 0;
+}
+
+void
+SampleLog::Close()
+{
+	// Lets a compaction in progress finish, it reads the directory
+	StopCompactor();
+	CloseSegment();
+	if(fLockFD >= 0)
+		close(fLockFD);
+
+	fLockFD = -1;
+	fDirectory[0] = '\0';
+	fDeviceCount = 0;
+}
+
+bool
+SampleLog::HasDevice(int32_t id) const
+{
+	for(uint32_t i = 0; i < fDeviceCount; i++) {
+		if(fDevices[i].id == id)
+			return true;
+	}
+
+	return false;
+}
+
+int
+SampleLog::RegisterDevice(int32_t id, const char* path)
+{
+	if(id < 0 || id >= 0xffff || path == NULL)
+		return EINVAL;
+
+	for(uint32_t i = 0; i < fDeviceCount; i++) {
+		if(fDevices[i].id != id)
+			continue;
+		if(strncmp(fDevices[i].path, path, kSampleLogDevicePathSize - 1) == 0)
+			return 0;
+
+		// The id now names another device: records already in this
+		//	segment must keep the old meaning.
+		strncpy(fDevices[i].path, path, kSampleLogDevicePathSize - 1);
+		fDevices[i].path[kSampleLogDevicePathSize - 1] = '\0';
+		fRotatePending = fCount > 0;
+		if(!fRotatePending)
+			WriteDeviceTable();
+		return 0;
+	}
+
+	if(fDeviceCount == kSampleLogMaxDevices)
+		return ENOSPC;
+
+	SampleLogDevice& device = fDevices[fDeviceCount++];
+	device.id = id;
+	strncpy(device.path, path, kSampleLogDevicePathSize - 1);
+	device.path[kSampleLogDevicePathSize - 1] = '\0';
+	WriteDeviceTable();
+	return 0;
+}
+
+int
+SampleLog::Append(int32_t device, int64_t when, float temperature)
+{
+	if(fDirectory[0] == '\0')
+		return ENOENT;
+	if(device < 0 || device >= 0xffff)
+		return EINVAL;
+
+	int64_t delta = fHeader != NULL ? (when - fHeader->baseTime) / 1000 : -1;
+	if(fHeader == NULL || fRotatePending || fCount >= fHeader->capacity
+		|| delta < 0 || delta > UINT32_MAX) {
+		int status = Rotate(when);
+		if(status != 0)
+			return status;
+		delta = 0;
+	}
+
+	// Records must not go back in time or the log would end there
+	if(fCount > 0 && static_cast<uint32_t>(delta) < fRecords[fCount - 1].delta)
+		delta = fRecords[fCount - 1].delta;
+
+	float centi = roundf(temperature * 100.0f);
+	centi = std::min(std::max(centi, static_cast<float>(INT16_MIN)), static_cast<float>(INT16_MAX));
+
+	SampleLogRecord record;
+	record.delta = static_cast<uint32_t>(delta);
+	record.device = static_cast<uint16_t>(device + 1);
+	record.centiDegrees = static_cast<int16_t>(centi);
+
+	uint64_t bits;
+	memcpy(&bits, &record, sizeof(bits));
+	__atomic_store_n(reinterpret_cast<uint64_t*>(&fRecords[fCount]), bits, __ATOMIC_RELEASE);
+	fCount++;
+	return 0;
+}
+
+int
+SampleLog::Sync()
+{
+	if(fMapping == NULL)
+		return 0;
+
+	return msync(fMapping, fMappingSize, MS_ASYNC) == 0 ? 0 : errno;
+}
+
+/* static */
+int32_t
+SampleLog::ListSegments(const char* directory, char (*outNames)[64], int32_t maxNames,
+	const char* extension)
+{
+	DIR* dir = opendir(directory);
+	if(dir == NULL)
+		return 0;
+
+	int32_t count = 0;
+	while(struct dirent* entry = readdir(dir)) {
+		if(count == maxNames)
+			break;
+		if(!IsSegmentName(entry->d_name, extension))
+			continue;
+
+		strcpy(outNames[count++], entry->d_name);
+	}
+	closedir(dir);
+
+	// Names carry the zero-padded hexadecimal base time
+	qsort(outNames, count, sizeof(outNames[0]),
+		[](const void* a, const void* b) {
+			return strcmp(static_cast<const char*>(a), static_cast<const char*>(b));
+		});
+
+	return count;
+}
+
+// #pragma mark - Private
+
+int
+SampleLog::OpenSegment(int64_t baseTime)
+{
+	char path[sizeof(fDirectory) + 64];
+	snprintf(path, sizeof(path), "%s/%s%016llx%s", fDirectory, kSegmentPrefix,
+		static_cast<unsigned long long>(baseTime), kSampleLogExtension);
+
+	int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if(fd < 0)
+		return errno;
+
+	size_t size = kSampleLogHeaderSize + fSegmentRecords * sizeof(SampleLogRecord);
+	if(ftruncate(fd, size) != 0) {
+		int status = errno;
+		close(fd);
+		unlink(path);
+		return status;
+	}
+
+	void* mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(mapping == MAP_FAILED) {
+		int status = errno;
+		close(fd);
+		unlink(path);
+		return status;
+	}
+
+	fFD = fd;
+	fMapping = mapping;
+	fMappingSize = size;
+	fHeader = static_cast<SampleLogHeader*>(mapping);
+	fRecords = reinterpret_cast<SampleLogRecord*>(static_cast<char*>(mapping)
+		+ kSampleLogHeaderSize);
+	fCount = 0;
+
+	memcpy(fHeader->magic, kSampleLogMagic, sizeof(kSampleLogMagic));
+	fHeader->version = kSampleLogVersion;
+	fHeader->recordSize = sizeof(SampleLogRecord);
+	fHeader->baseTime = baseTime;
+	fHeader->capacity = fSegmentRecords;
+	WriteDeviceTable();
+	return 0;
+}
+
+int
+SampleLog::ReopenSegment(const char* path)
+{
+	int fd = open(path, O_RDWR | O_CLOEXEC);
+	if(fd < 0)
+		return errno;
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size < kSampleLogHeaderSize) {
+		close(fd);
+		return EINVAL;
+	}
+
+	void* mapping = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(mapping == MAP_FAILED) {
+		int status = errno;
+		close(fd);
+		return status;
+	}
+
+	SampleLogHeader* header = static_cast<SampleLogHeader*>(mapping);
+	if(!IsValidHeader(header, st.st_size)) {
+		munmap(mapping, st.st_size);
+		close(fd);
+		return EINVAL;
+	}
+
+	fFD = fd;
+	fMapping = mapping;
+	fMappingSize = st.st_size;
+	fHeader = header;
+	fRecords = reinterpret_cast<SampleLogRecord*>(static_cast<char*>(mapping)
+		+ kSampleLogHeaderSize);
+	fCount = SampleLogSegment::CountValid(fRecords, header->capacity);
+	ClearTail();
+
+	fDeviceCount = header->deviceCount;
+	memcpy(fDevices, header->devices, sizeof(SampleLogDevice) * fDeviceCount);
+	return 0;
+}
+
+void
+SampleLog::CloseSegment()
+{
+	if(fMapping != NULL) {
+		msync(fMapping, fMappingSize, MS_ASYNC);
+		munmap(fMapping, fMappingSize);
+	}
+	if(fFD >= 0)
+		close(fFD);
+
+	fFD = -1;
+	fMapping = NULL;
+	fMappingSize = 0;
+	fHeader = NULL;
+	fRecords = NULL;
+	fCount = 0;
+}
+
+int
+SampleLog::Rotate(int64_t baseTime)
+{
+	CloseSegment();
+	fRotatePending = false;
+
+	int status = OpenSegment(baseTime);
+	if(status != 0)
+		return status;
+
+	fRotations++;
+
+	// Only the oldest segments are touched, never the one just opened
+	pthread_mutex_lock(&fCompactorLock);
+	fPrunePending = true;
+	pthread_cond_signal(&fCompactorCondition);
+	pthread_mutex_unlock(&fCompactorLock);
+	return 0;
+}
+
+int
+SampleLog::StartCompactor()
+{
+	fPrunePending = false;
+	fCompactorQuit = false;
+	int status = pthread_create(&fCompactor, NULL, &_CompactorThread, this);
+	if(status != 0)
+		return status;
+
+	fCompactorRunning = true;
+	return 0;
+}
+
+void
+SampleLog::StopCompactor()
+{
+	if(!fCompactorRunning)
+		return;
+
+	pthread_mutex_lock(&fCompactorLock);
+	fCompactorQuit = true;
+	pthread_cond_signal(&fCompactorCondition);
+	pthread_mutex_unlock(&fCompactorLock);
+
+	pthread_join(fCompactor, NULL);
+	fCompactorRunning = false;
+}
+
+/* static */
+void*
+SampleLog::_CompactorThread(void* data)
+{
+	LowerThreadPriority();
+	static_cast<SampleLog*>(data)->CompactorLoop();
+	return NULL;
+}
+
+void
+SampleLog::CompactorLoop()
+{
+	// A pending pass still runs when quitting, so no segment outlives the
+	//	limit for longer than it takes to compact it.
+	pthread_mutex_lock(&fCompactorLock);
+	while(true) {
+		while(!fPrunePending && !fCompactorQuit)
+			pthread_cond_wait(&fCompactorCondition, &fCompactorLock);
+		if(!fPrunePending)
+			break;
+
+		fPrunePending = false;
+		pthread_mutex_unlock(&fCompactorLock);
+		PruneSegments();
+		pthread_mutex_lock(&fCompactorLock);
+	}
+	pthread_mutex_unlock(&fCompactorLock);
+}
+
+void
+SampleLog::PruneSegments()
+{
+	char names[kSampleLogMaxSegments * 4][64];
+	int32_t count = ListSegments(fDirectory, names, kSampleLogMaxSegments * 4);
+	for(int32_t i = 0; i < count - fMaxSegments; i++) {
+		char path[sizeof(fDirectory) + 64];
+		if(!JoinPath(path, sizeof(path), fDirectory, names[i]))
+			continue;
+
+		// A segment that could not be archived is kept for the next pass,
+		//	unless it keeps failing and the segments would pile up
+		int status = CompactSegment(names[i]);
+		if(status != 0) {
+			if(strcmp(fFailedSegment, names[i]) != 0) {
+				strcpy(fFailedSegment, names[i]);
+				fFailedAttempts = 0;
+			}
+			if(++fFailedAttempts < kSampleLogCompactAttempts) {
+				fprintf(stderr, "Could not archive %s: %s\n", path, strerror(status));
+				break;
+			}
+			fprintf(stderr, "Could not archive %s after %d attempts, removing it: %s\n",
+				path, fFailedAttempts, strerror(status));
+		}
+
+		unlink(path);
+	}
+
+	char (*archives)[64] = new char[kSampleLogMaxArchives * 2][64];
+	count = ListSegments(fDirectory, archives, kSampleLogMaxArchives * 2,
+		kSampleLogArchiveExtension);
+	for(int32_t i = 0; i < count - kSampleLogMaxArchives; i++) {
+		char path[sizeof(fDirectory) + 64];
+		if(JoinPath(path, sizeof(path), fDirectory, archives[i]))
+			unlink(path);
+	}
+	delete[] archives;
+}
+
+int
+SampleLog::CompactSegment(const char* name)
+{
+	char path[sizeof(fDirectory) + 64];
+	if(!JoinPath(path, sizeof(path), fDirectory, name))
+		return ENAMETOOLONG;
+
+	SampleLogSegment segment;
+	int status = segment.Open(path);
+	if(status != 0)
+		return status;
+
+	// Same name, archive extension; written aside and renamed when complete
+	char archivePath[sizeof(fDirectory) + 64];
+	snprintf(archivePath, sizeof(archivePath), "%s/%.*s%s", fDirectory,
+		static_cast<int>(strlen(name) - strlen(kSampleLogExtension)), name,
+		kSampleLogArchiveExtension);
+	char temporaryPath[sizeof(archivePath) + 4];
+	snprintf(temporaryPath, sizeof(temporaryPath), "%s.tmp", archivePath);
+
+	int fd = open(temporaryPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if(fd < 0)
+		return errno;
+
+	SampleLogHeader header;
+	memcpy(&header, segment.Header(), sizeof(header));
+	memcpy(header.magic, kSampleLogArchiveMagic, sizeof(kSampleLogArchiveMagic));
+	header.recordSize = 0;
+	header.capacity = segment.Count();
+	status = WriteFully(fd, &header, sizeof(header));
+
+	// One pass per device keeps every chunk a single device stream
+	uint8_t* buffer = new uint8_t[kSampleLogChunkSize];
+	const SampleLogRecord* records = segment.Records();
+	for(uint32_t d = 0; d < header.deviceCount && status == 0; d++) {
+		uint16_t tag = header.devices[d].id + 1;
+		SeriesEncoder encoder(buffer, kSampleLogChunkSize);
+		for(size_t i = 0; i < segment.Count() && status == 0; i++) {
+			if(records[i].device != tag)
+				continue;
+
+			if(!encoder.Append(records[i].delta, records[i].centiDegrees)) {
+				status = WriteChunk(fd, header.devices[d].id, encoder);
+				encoder.SetTo(buffer, kSampleLogChunkSize);
+				encoder.Append(records[i].delta, records[i].centiDegrees);
+			}
+		}
+		if(status == 0 && encoder.Count() > 0)
+			status = WriteChunk(fd, header.devices[d].id, encoder);
+	}
+	delete[] buffer;
+
+	if(status == 0 && fsync(fd) != 0)
+		status = errno;
+	close(fd);
+
+	if(status == 0 && rename(temporaryPath, archivePath) != 0)
+		status = errno;
+	if(status != 0)
+		unlink(temporaryPath);
+
+	return status;
+}
+
+void
+SampleLog::ClearTail()
+{
+	// A crash may leave pages written after a lost one; wipe anything past
+	//	the recovered end so that it can never be mistaken for new records.
+	for(size_t i = fCount; i < fHeader->capacity; i++) {
+		if(fRecords[i].device != 0 || fRecords[i].delta != 0)
+			memset(&fRecords[i], 0, sizeof(SampleLogRecord));
+	}
+}
+
+void
+SampleLog::WriteDeviceTable()
+{
+	if(fHeader == NULL)
+		return;
+
+	memcpy(fHeader->devices, fDevices, sizeof(SampleLogDevice) * fDeviceCount);
+	fHeader->deviceCount = fDeviceCount;
+}
@@ -0,0 +1,262 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef __SAMPLE_LOG__
+#define __SAMPLE_LOG__
+
+/*
+ * Append-only on-disk sample log. Every segment file is a one page header
+ * followed by fixed-width records, preallocated and written through a
+ * shared mapping. Segments dropped past the segment limit are first
+ * compacted into an archive of SeriesCodec streams. Only the C++ standard
+ * library and POSIX are used, so it also builds on Linux. Functions
+ * returning int give 0 or an errno code.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <pthread.h>
+#include "SeriesCodec.h"
+
+#define kSampleLogMagic          "TMPLOG1"
+#define kSampleLogVersion        1
+#define kSampleLogHeaderSize     4096
+#define kSampleLogMaxDevices     48
+#define kSampleLogDevicePathSize 78
+#define kSampleLogSegmentRecords (1024 * 1024)	// 8 MiB per segment
+#define kSampleLogMaxSegments    16
+#define kSampleLogExtension      ".tlog"
+
+#define kSampleLogArchiveMagic     "TMPSER1"
+#define kSampleLogArchiveExtension ".tsz"
+#define kSampleLogMaxArchives      512
+#define kSampleLogChunkSize        (64 * 1024)
+#define kSampleLogCompactAttempts  8	// before a segment is dropped unarchived
+
+struct SampleLogDevice
+{
+	uint16_t	id;
+	char		path[kSampleLogDevicePathSize];
+};
+
+struct SampleLogHeader
+{
+	char			magic[8];
+	uint32_t		version;
+	uint32_t		recordSize;
+	int64_t			baseTime;		// real time of the segment start, in µs
+	uint32_t		capacity;		// records the segment can hold
+	uint32_t		deviceCount;
+	uint8_t			reserved[32];
+	SampleLogDevice	devices[kSampleLogMaxDevices];
+};
+
+static_assert(sizeof(SampleLogHeader) <= kSampleLogHeaderSize, "header overflows its page");
+
+/*
+ * Each record is stored with a single aligned 64-bit write, so after a crash
+ * it is either complete or still zero. The log ends at the first record with
+ * a zero device field or a timestamp going backwards.
+ */
+struct SampleLogRecord
+{
+	uint32_t	delta;			// milliseconds since the segment base time
+	uint16_t	device;			// device id + 1, 0 marks an unwritten record
+	int16_t		centiDegrees;	// degrees Celsius * 100
+
+	int16_t DeviceID() const { return static_cast<int16_t>(device - 1); }
+	float Temperature() const { return centiDegrees / 100.0f; }
+};
+
+static_assert(sizeof(SampleLogRecord) == 8, "records must be 8 bytes wide");
+
+/*
+ * Archives start with a SampleLogHeader (archive magic, no records, capacity
+ * holding the number of points) followed by chunks, each one an independent
+ * SeriesCodec stream of (milliseconds since the base time, centi-degrees).
+ */
+struct SampleLogChunk
+{
+	uint16_t	device;			// device id + 1, as in the records
+	uint16_t	reserved;
+	uint32_t	count;
+	uint32_t	length;			// bytes of encoded data following
+};
+
+/*
+ * Read-only, zero-copy view of one segment.
+ */
+class SampleLogSegment
+{
+public:
+							SampleLogSegment();
+							~SampleLogSegment();
+
+			int				Open(const char* path);
+			void			Close();
+
+			const SampleLogHeader* Header() const { return fHeader; }
+			const SampleLogRecord* Records() const { return fRecords; }
+			size_t			Count() const { return fCount; }
+			int64_t			TimeAt(size_t index) const;
+
+	// Number of valid records from the start of records, up to capacity
+	static	size_t			CountValid(const SampleLogRecord* records, size_t capacity);
+private:
+			void*			fMapping;
+			size_t			fMappingSize;
+			const SampleLogHeader* fHeader;
+			const SampleLogRecord* fRecords;
+			size_t			fCount;
+};
+
+/*
+ * Read-only view of one archive.
+ */
+class SampleLogArchive
+{
+public:
+							SampleLogArchive();
+							~SampleLogArchive();
+
+			int				Open(const char* path);
+			void			Close();
+
+			const SampleLogHeader* Header() const { return fHeader; }
+
+	// Calls visitor(int32_t device, uint32_t count, SeriesDecoder& decoder)
+	//	for every chunk, in file order. Returns the number of chunks visited.
+	template<typename Visitor>
+			int32_t			ForEachChunk(Visitor&& visitor) const;
+private:
+			void*			fMapping;
+			size_t			fMappingSize;
+			const SampleLogHeader* fHeader;
+};
+
+template<typename Visitor>
+int32_t
+SampleLogArchive::ForEachChunk(Visitor&& visitor) const
+{
+	if(fHeader == NULL)
+		return 0;
+
+	const uint8_t* cursor = static_cast<const uint8_t*>(fMapping) + sizeof(SampleLogHeader);
+	const uint8_t* end = static_cast<const uint8_t*>(fMapping) + fMappingSize;
+
+	int32_t visited = 0;
+	while(static_cast<size_t>(end - cursor) >= sizeof(SampleLogChunk)) {
+		SampleLogChunk chunk;
+		memcpy(&chunk, cursor, sizeof(chunk));
+		cursor += sizeof(chunk);
+		if(chunk.device == 0 || chunk.length > static_cast<size_t>(end - cursor))
+			break;
+
+		SeriesDecoder decoder(cursor, chunk.length);
+		visitor(static_cast<int32_t>(chunk.device) - 1, chunk.count, decoder);
+		cursor += chunk.length;
+		visited++;
+	}
+
+	return visited;
+}
+
+/*
+ * Writer. Append() does not allocate nor issue system calls except when a
+ * segment has to be rotated; segments past the limit are then compacted
+ * and removed by a low priority thread of the log, off the appending one.
+ */
+class SampleLog
+{
+public:
+							SampleLog();
+							~SampleLog();
+
+			int				Open(const char* directory,
+								size_t segmentRecords = kSampleLogSegmentRecords,
+								int32_t maxSegments = kSampleLogMaxSegments);
+			void			Close();
+			bool			IsOpen() const { return fDirectory[0] != '\0'; }
+
+			bool			HasDevice(int32_t id) const;
+			int				RegisterDevice(int32_t id, const char* path);
+			int				Append(int32_t device, int64_t when, float temperature);
+			int				Sync();
+
+			size_t			Count() const { return fCount; }
+			uint64_t		Rotations() const { return fRotations; }
+
+	// Calls visitor(const SampleLogSegment&) for the segments of a directory,
+	//	oldest first. Returns the number of segments visited.
+	template<typename Visitor>
+	static	int32_t			ForEachSegment(const char* directory, Visitor&& visitor);
+	static	int32_t			ListSegments(const char* directory, char (*outNames)[64],
+								int32_t maxNames,
+								const char* extension = kSampleLogExtension);
+private:
+			int				OpenSegment(int64_t baseTime);
+			int				ReopenSegment(const char* path);
+			void			CloseSegment();
+			int				Rotate(int64_t baseTime);
+			int				StartCompactor();
+			void			StopCompactor();
+	static	void*			_CompactorThread(void* data);
+			void			CompactorLoop();
+			void			PruneSegments();
+			int				CompactSegment(const char* name);
+			void			ClearTail();
+			void			WriteDeviceTable();
+private:
+	char					fDirectory[1024];
+	int						fLockFD;
+	int						fFD;
+	void*					fMapping;
+	size_t					fMappingSize;
+	SampleLogHeader*		fHeader;
+	SampleLogRecord*		fRecords;
+	size_t					fCount;
+	size_t					fSegmentRecords;
+	int32_t					fMaxSegments;
+	uint64_t				fRotations;
+
+	SampleLogDevice			fDevices[kSampleLogMaxDevices];
+	uint32_t				fDeviceCount;
+	bool					fRotatePending;
+
+	pthread_t				fCompactor;
+	pthread_mutex_t			fCompactorLock;
+	pthread_cond_t			fCompactorCondition;
+	bool					fCompactorRunning;
+	bool					fPrunePending;		// guarded by fCompactorLock
+	bool					fCompactorQuit;		// guarded by fCompactorLock
+	char					fFailedSegment[64];	// compactor thread only
+	int32_t					fFailedAttempts;
+};
+
+template<typename Visitor>
+int32_t
+SampleLog::ForEachSegment(const char* directory, Visitor&& visitor)
+{
+	char names[kSampleLogMaxSegments * 4][64];
+	int32_t count = ListSegments(directory, names, kSampleLogMaxSegments * 4);
+
+	int32_t visited = 0;
+	for(int32_t i = 0; i < count; i++) {
+		char path[1024 + 64];
+		int length = snprintf(path, sizeof(path), "%s/%s", directory, names[i]);
+
+		SampleLogSegment segment;
+		if(length < 0 || static_cast<size_t>(length) >= sizeof(path) || segment.Open(path) != 0)
+			continue;
+
+		visitor(static_cast<const SampleLogSegment&>(segment));
+		visited++;
+	}
+
+	return visited;
+}
+
+#endif /* __SAMPLE_LOG__ */
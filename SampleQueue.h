@@ -0,0 +1,79 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef __SAMPLE_QUEUE__
+#define __SAMPLE_QUEUE__
+
+#include <atomic>
+#include <cstddef>
+
+/*
+ * Lock-free, fixed-capacity queue for exactly one producer thread and one
+ * consumer thread. Push() never blocks: when the consumer falls behind the
+ * new item is refused and counted in Dropped().
+ */
+template<typename T, size_t N>
+class SampleQueue
+{
+	static_assert(N >= 2 && (N & (N - 1)) == 0, "capacity must be a power of two");
+public:
+	SampleQueue()
+	: fHead(0),
+	  fTail(0),
+	  fDropped(0)
+	{
+	}
+
+	// Producer side
+	bool Push(const T& item)
+	{
+		size_t tail = fTail.load(std::memory_order_relaxed);
+		if(tail - fHead.load(std::memory_order_acquire) == N) {
+			fDropped.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		fItems[tail & (N - 1)] = item;
+		fTail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side
+	bool Pop(T* outItem)
+	{
+		size_t head = fHead.load(std::memory_order_relaxed);
+		if(head == fTail.load(std::memory_order_acquire))
+			return false;
+
+		*outItem = fItems[head & (N - 1)];
+		fHead.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer side: the next item Pop() returns, in place, or NULL
+	const T* Peek() const
+	{
+		size_t head = fHead.load(std::memory_order_relaxed);
+		if(head == fTail.load(std::memory_order_acquire))
+			return NULL;
+
+		return &fItems[head & (N - 1)];
+	}
+
+	size_t Count() const
+	{
+		return fTail.load(std::memory_order_acquire) - fHead.load(std::memory_order_acquire);
+	}
+
+	bool IsEmpty() const { return Count() == 0; }
+	size_t Capacity() const { return N; }
+	size_t Dropped() const { return fDropped.load(std::memory_order_relaxed); }
+private:
+	T fItems[N];
+	alignas(64) std::atomic<size_t> fHead;
+	alignas(64) std::atomic<size_t> fTail;
+	std::atomic<size_t> fDropped;
+};
+
+#endif /* __SAMPLE_QUEUE__ */
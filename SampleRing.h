@@ -0,0 +1,115 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef __SAMPLE_RING__
+#define __SAMPLE_RING__
+
+#include <cstddef>
+
+/*
+ * Fixed-capacity history that overwrites its oldest item once full.
+ * Pushing is O(1) and never allocates; the contents can be walked as at
+ * most two contiguous spans, oldest first. It does no locking of its own:
+ * writer and readers must be serialized by the owner (e.g. a looper lock).
+ */
+template<typename T, size_t N>
+class SampleRing
+{
+	static_assert(N > 0, "capacity must not be zero");
+public:
+	struct Span {
+		const T*	items;
+		size_t		count;
+	};
+
+	SampleRing()
+	: fStart(0),
+	  fCount(0)
+	{
+	}
+
+	void Push(const T& item)
+	{
+		if(fCount < N) {
+			fItems[(fStart + fCount) % N] = item;
+			fCount++;
+		}
+		else {
+			fItems[fStart] = item;
+			fStart = (fStart + 1) % N;
+		}
+	}
+
+	void MakeEmpty()
+	{
+		fStart = 0;
+		fCount = 0;
+	}
+
+	size_t Count() const { return fCount; }
+	size_t Capacity() const { return N; }
+	bool IsEmpty() const { return fCount == 0; }
+
+	// Index 0 is the oldest item; out of range indices yield fallback.
+	T ItemAt(size_t index, const T& fallback = T()) const
+	{
+		if(index >= fCount)
+			return fallback;
+
+		return fItems[(fStart + index) % N];
+	}
+
+	T Last(const T& fallback = T()) const
+	{
+		if(fCount == 0)
+			return fallback;
+
+		return ItemAt(fCount - 1);
+	}
+
+	// Newest item, in place; the ring must not be empty
+	T& LastItem()
+	{
+		return fItems[(fStart + fCount - 1) % N];
+	}
+
+	// Splits the items into [oldest, end of storage) and [storage, newest]
+	void GetSpans(Span* outFirst, Span* outSecond) const
+	{
+		size_t firstCount = fCount;
+		if(fStart + fCount > N)
+			firstCount = N - fStart;
+
+		outFirst->items = fItems + fStart;
+		outFirst->count = firstCount;
+		outSecond->items = fItems;
+		outSecond->count = fCount - firstCount;
+	}
+
+	// Calls visitor(index, item) for the newest count items, oldest first.
+	template<typename Visitor>
+	void ForEachLast(size_t count, Visitor&& visitor) const
+	{
+		if(count > fCount)
+			count = fCount;
+
+		size_t skip = fCount - count;
+		Span spans[2];
+		GetSpans(&spans[0], &spans[1]);
+
+		size_t index = 0;
+		for(const Span& span : spans) {
+			size_t i = skip < span.count ? skip : span.count;
+			skip -= i;
+			for(; i < span.count; i++)
+				visitor(index++, span.items[i]);
+		}
+	}
+private:
+	T		fItems[N];
+	size_t	fStart;
+	size_t	fCount;
+};
+
+#endif /* __SAMPLE_RING__ */
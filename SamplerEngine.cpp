@@ -0,0 +1,561 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifdef __HAIKU__
+#include <Autolock.h>
+#include "DeviceRegistry.h"
+#endif
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "SamplerEngine.h"
+
+SamplerEngine::SamplerEngine()
+: fLock("Sampler lock"),
+  fAvailableSem(create_sem(0, "Samples available")),
+  fWakeSem(create_sem(0, "Sampler wake")),
+  fJobSem(-1),
+  fDispatcher(-1),
+  fQuitting(false)
+{
+	for(int32 i = 0; i < kSamplerWorkerCount; i++) {
+		fWorkers[i] = -1;
+		fWorkerInfo[i].engine = this;
+		fWorkerInfo[i].index = i;
+	}
+}
+
+SamplerEngine::~SamplerEngine()
+{
+	Stop();
+
+	// With no thread running every entry is either scheduled or queued
+	for(DeviceEntry* entry : fDeadlines)
+		delete entry;
+	while(!fJobs.empty()) {
+		delete fJobs.front();
+		fJobs.pop();
+	}
+	fDevices.clear();
+
+	delete_sem(fAvailableSem);
+	delete_sem(fWakeSem);
+}
+
+#ifdef __HAIKU__
+int32
+SamplerEngine::AddDevice(const char* path, bigtime_t interval)
+{
+	if(!path || interval <= 0)
+		return B_BAD_VALUE;
+
+	// Ids come from the registry so that the whole process agrees on them
+	int32 id = DeviceRegistry::Default()->Register(path);
+	if(id < 0)
+		return id;
+
+	return AddDevice(id, path, interval);
+}
+
+BString
+SamplerEngine::DevicePath(int32 device) const
+{
+	char path[kThermalDevicePathSize];
+	return GetDevicePath(device, path, sizeof(path)) == B_OK ? BString(path) : BString();
+}
+#endif
+
+int32
+SamplerEngine::AddDevice(int32 id, const char* path, bigtime_t interval)
+{
+	if(id < 0 || !path || interval <= 0)
+		return B_BAD_VALUE;
+	interval = std::max(interval, (bigtime_t)kMinimumRefreshInterval);
+
+	DeviceEntry* entry = new DeviceEntry;
+	entry->id = id;
+	entry->status = entry->device.SetTo(path);
+	entry->period = interval;
+	entry->interval = interval;
+	entry->deadline = system_time();
+	entry->removed = false;
+	entry->adaptive = false;
+	entry->slope = 0;
+	entry->baseValue = 0;
+	entry->baseTime = -1;
+	entry->metrics = SamplerMetrics();
+
+	fLock.Lock();
+	if(fDevices.find(id) != fDevices.end()) {
+		fLock.Unlock();
+		delete entry;
+		return id;
+	}
+	fDevices[id] = entry;
+	fDeadlines.push_back(entry);
+	std::push_heap(fDeadlines.begin(), fDeadlines.end(), LaterDeadline());
+	fLock.Unlock();
+
+	WakeDispatcher();
+	return id;
+}
+
+status_t
+SamplerEngine::RemoveDevice(int32 device)
+{
+	BAutolock lock(fLock);
+	auto found = fDevices.find(device);
+	if(found == fDevices.end())
+		return B_BAD_INDEX;
+
+	// Whoever holds the entry next, dispatcher or worker, deletes it
+	found->second->removed = true;
+	fDevices.erase(found);
+	return B_OK;
+}
+
+int32
+SamplerEngine::FindDevice(const char* path) const
+{
+	if(!path)
+		return B_BAD_VALUE;
+
+	BAutolock lock(fLock);
+	for(const auto& device : fDevices) {
+		if(strcmp(device.second->device.Location(), path) == 0)
+			return device.first;
+	}
+
+	return B_NAME_NOT_FOUND;
+}
+
+status_t
+SamplerEngine::GetDevicePath(int32 device, char* outPath, size_t size) const
+{
+	if(!outPath || size == 0)
+		return B_BAD_VALUE;
+
+	BAutolock lock(fLock);
+	auto found = fDevices.find(device);
+	if(found == fDevices.end())
+		return B_BAD_INDEX;
+
+	const char* path = found->second->device.Location();
+	if(strlen(path) >= size)
+		return B_NAME_TOO_LONG;
+
+	strcpy(outPath, path);
+	return B_OK;
+}
+
+bool
+SamplerEngine::HasDevice(int32 device) const
+{
+	BAutolock lock(fLock);
+	auto found = fDevices.find(device);
+	return found != fDevices.end() && found->second->status == B_OK;
+}
+
+int32
+SamplerEngine::CountDevices() const
+{
+	BAutolock lock(fLock);
+	return fDevices.size();
+}
+
+status_t
+SamplerEngine::SetInterval(int32 device, bigtime_t interval)
+{
+	if(interval <= 0)
+		return B_BAD_VALUE;
+	interval = std::max(interval, (bigtime_t)kMinimumRefreshInterval);
+
+	fLock.Lock();
+	auto found = fDevices.find(device);
+	if(found == fDevices.end()) {
+		fLock.Unlock();
+		return B_BAD_INDEX;
+	}
+
+	// Adaptive devices pick their own interval
+	DeviceEntry* entry = found->second;
+	entry->period = interval;
+	if(entry->adaptive) {
+		fLock.Unlock();
+		return B_OK;
+	}
+
+	// Do not make a shorter period wait for the old deadline
+	entry->interval = interval;
+	bigtime_t latest = system_time() + interval;
+	if(std::find(fDeadlines.begin(), fDeadlines.end(), entry) != fDeadlines.end()
+		&& entry->deadline > latest) {
+		entry->deadline = latest;
+		std::make_heap(fDeadlines.begin(), fDeadlines.end(), LaterDeadline());
+	}
+	fLock.Unlock();
+
+	WakeDispatcher();
+	return B_OK;
+}
+
+bigtime_t
+SamplerEngine::Interval(int32 device) const
+{
+	BAutolock lock(fLock);
+	auto found = fDevices.find(device);
+	return found != fDevices.end() ? found->second->interval : 0;
+}
+
+status_t
+SamplerEngine::SetAdaptive(int32 device, const AdaptivePolicy* policy)
+{
+	if(policy && (policy->fastest < kMinimumRefreshInterval
+			|| policy->slowest < policy->fastest))
+		return B_BAD_VALUE;
+
+	bigtime_t period;
+	{
+		BAutolock lock(fLock);
+		auto found = fDevices.find(device);
+		if(found == fDevices.end())
+			return B_BAD_INDEX;
+
+		DeviceEntry* entry = found->second;
+		if(!policy) {
+			if(!entry->adaptive)
+				return B_OK;
+			entry->adaptive = false;
+			period = entry->period;
+		}
+		else {
+			// Start from the fixed period, the next reads tell where to go
+			entry->policy = *policy;
+			entry->slope = 0;
+			entry->baseTime = -1;
+			if(!entry->adaptive)
+				entry->interval = std::max(policy->fastest,
+					std::min(entry->period, policy->slowest));
+			entry->adaptive = true;
+			return B_OK;
+		}
+	}
+
+	return SetInterval(device, period);
+}
+
+status_t
+SamplerEngine::GetMetrics(int32 device, SamplerMetrics* outMetrics) const
+{
+	if(!outMetrics)
+		return B_BAD_VALUE;
+
+	BAutolock lock(fLock);
+	auto found = fDevices.find(device);
+	if(found == fDevices.end())
+		return B_BAD_INDEX;
+
+	*outMetrics = found->second->metrics;
+	outMetrics->interval = found->second->interval;
+	return B_OK;
+}
+
+status_t
+SamplerEngine::Start()
+{
+	if(IsRunning())
+		return B_OK;
+	if(fAvailableSem < 0 || fWakeSem < 0)
+		return B_NO_INIT;
+
+	fJobSem = create_sem(fJobs.size(), "Sampler jobs");
+	if(fJobSem < 0)
+		return fJobSem;
+
+	fQuitting.store(false, std::memory_order_release);
+	for(int32 i = 0; i < kSamplerWorkerCount; i++) {
+		fWorkers[i] = spawn_thread(CallWork, "Temperature sampler worker",
+			B_NORMAL_PRIORITY, &fWorkerInfo[i]);
+		if(fWorkers[i] >= 0)
+			resume_thread(fWorkers[i]);
+	}
+
+	fDispatcher = spawn_thread(CallDispatch, "Temperature sampler",
+		B_NORMAL_PRIORITY, this);
+	if(fDispatcher < 0) {
+		status_t status = fDispatcher;
+		Stop();
+		return status;
+	}
+
+	return resume_thread(fDispatcher);
+}
+
+void
+SamplerEngine::Stop()
+{
+	if(fJobSem < 0)
+		return;
+
+	fQuitting.store(true, std::memory_order_release);
+	release_sem(fWakeSem);
+	release_sem_etc(fJobSem, kSamplerWorkerCount, 0);
+
+	status_t exitCode = B_OK;
+	if(fDispatcher >= 0)
+		wait_for_thread(fDispatcher, &exitCode);
+	fDispatcher = -1;
+	for(int32 i = 0; i < kSamplerWorkerCount; i++) {
+		if(fWorkers[i] >= 0)
+			wait_for_thread(fWorkers[i], &exitCode);
+		fWorkers[i] = -1;
+	}
+
+	delete_sem(fJobSem);
+	fJobSem = -1;
+}
+
+bool
+SamplerEngine::IsRunning() const
+{
+	return fDispatcher >= 0;
+}
+
+bool
+SamplerEngine::PopSample(ThermalSample* outSample)
+{
+	// A device read by one worker and then by the other has its first
+	//	sample pushed before the second. Once the second is seen, a new
+	//	scan sees the first too, so a head that is still the oldest on the
+	//	next scan has nothing of its device left before it.
+	Queue* oldest = OldestQueue();
+	while(oldest != NULL) {
+		Queue* again = OldestQueue();
+		if(again == oldest)
+			return oldest->Pop(outSample);
+		oldest = again;
+	}
+
+	return false;
+}
+
+status_t
+SamplerEngine::WaitForSamples(bigtime_t timeout)
+{
+	// Every push releases the semaphore, but a batch pops many samples at
+	//	once: counts left over from them must not pass for new samples.
+	bigtime_t until = system_time() + timeout;
+	while(!HasSamples()) {
+		status_t status = acquire_sem_etc(fAvailableSem, 1, B_ABSOLUTE_TIMEOUT, until);
+		if(status != B_OK)
+			return status;
+	}
+
+	return B_OK;
+}
+
+// #pragma mark - Sampler threads
+
+/* static */
+int32
+SamplerEngine::CallDispatch(void* data)
+{
+	SamplerEngine* engine = (SamplerEngine*)data;
+	if(!engine)
+		return B_ERROR;
+
+	engine->Dispatch();
+	return B_OK;
+}
+
+void
+SamplerEngine::Dispatch()
+{
+	while(!fQuitting.load(std::memory_order_acquire)) {
+		fLock.Lock();
+		int32 due = 0;
+		bigtime_t now = system_time();
+		while(DeviceEntry* entry = PopDue(now)) {
+			if(entry->removed) {
+				delete entry;
+				continue;
+			}
+			fJobs.push(entry);
+			due++;
+		}
+		bigtime_t next = fDeadlines.empty() ? B_INFINITE_TIMEOUT : fDeadlines.front()->deadline;
+		fLock.Unlock();
+
+		if(due > 0)
+			release_sem_etc(fJobSem, due, 0);
+
+		// Added devices, changed periods, finished reads and Stop() all
+		//	wake the dispatcher before the next deadline.
+		if(next == B_INFINITE_TIMEOUT)
+			acquire_sem(fWakeSem);
+		else
+			acquire_sem_etc(fWakeSem, 1, B_ABSOLUTE_TIMEOUT, next);
+	}
+}
+
+/* static */
+int32
+SamplerEngine::CallWork(void* data)
+{
+	WorkerInfo* info = (WorkerInfo*)data;
+	if(!info || !info->engine)
+		return B_ERROR;
+
+	info->engine->Work(info->index);
+	return B_OK;
+}
+
+void
+SamplerEngine::Work(int32 index)
+{
+	while(acquire_sem(fJobSem) == B_OK) {
+		if(fQuitting.load(std::memory_order_acquire))
+			break;
+
+		fLock.Lock();
+		DeviceEntry* entry = NULL;
+		if(!fJobs.empty()) {
+			entry = fJobs.front();
+			fJobs.pop();
+		}
+		if(entry && entry->removed) {
+			delete entry;
+			entry = NULL;
+		}
+		fLock.Unlock();
+
+		if(!entry)
+			continue;
+
+		// The deadline only changes once the entry is scheduled again
+		ThermalSample sample;
+		sample.device = entry->id;
+		sample.deadline = entry->deadline;
+		bigtime_t lateness = system_time() - sample.deadline;
+		sample.status = entry->device.ReadSnapshot(&sample.snapshot);
+		if(fSamples[index].Push(sample))
+			release_sem_etc(fAvailableSem, 1, B_DO_NOT_RESCHEDULE);
+
+		fLock.Lock();
+		if(entry->removed)
+			delete entry;
+		else {
+			SamplerMetrics& metrics = entry->metrics;
+			metrics.reads++;
+			metrics.lastLateness = lateness;
+			metrics.maxLateness = std::max(metrics.maxLateness, lateness);
+			if(entry->adaptive && sample.status == B_OK)
+				Adapt(entry, sample.snapshot);
+			Schedule(entry, system_time());
+		}
+		fLock.Unlock();
+
+		WakeDispatcher();
+	}
+}
+
+// #pragma mark - Scheduling
+
+void
+SamplerEngine::Adapt(DeviceEntry* entry, const ThermalSnapshot& snapshot)
+{
+	if(!snapshot.IsReported(TEMPERATURE_CURRENT))
+		return;
+
+	// Consecutive fast reads differ by little more than the sensor's
+	//	resolution, so the slope is only taken over a long enough span.
+	float value = snapshot.Temperature(TEMPERATURE_CURRENT);
+	if(entry->baseTime < 0) {
+		entry->baseValue = value;
+		entry->baseTime = snapshot.timestamp;
+	}
+	else if(snapshot.timestamp - entry->baseTime >= kAdaptiveBaseline) {
+		entry->slope = fabsf(value - entry->baseValue) * 1000000.0f
+			/ (snapshot.timestamp - entry->baseTime);
+		entry->baseValue = value;
+		entry->baseTime = snapshot.timestamp;
+	}
+
+	float distance = INFINITY;
+	if(snapshot.IsReported(TEMPERATURE_HOT))
+		distance = std::min(distance, snapshot.Temperature(TEMPERATURE_HOT) - value);
+	if(snapshot.IsReported(TEMPERATURE_CRITICAL))
+		distance = std::min(distance, snapshot.Temperature(TEMPERATURE_CRITICAL) - value);
+
+	// Jump straight to the fastest rate, but only back off once well clear
+	//	of both bounds so that the rate does not flap around them.
+	const AdaptivePolicy& policy = entry->policy;
+	if(entry->slope >= policy.slope || distance <= policy.margin)
+		entry->interval = policy.fastest;
+	else if(entry->slope < policy.slope / 2 && distance > policy.margin * 2)
+		entry->interval = std::min(entry->interval * 2, policy.slowest);
+}
+
+void
+SamplerEngine::Schedule(DeviceEntry* entry, bigtime_t now)
+{
+	// Stay on the grid of the previous deadline, skipping the periods that
+	//	were already missed rather than catching up on them.
+	entry->deadline += entry->interval;
+	if(entry->deadline <= now) {
+		bigtime_t missed = (now - entry->deadline) / entry->interval + 1;
+		entry->deadline += missed * entry->interval;
+		entry->metrics.missed += missed;
+	}
+
+	fDeadlines.push_back(entry);
+	std::push_heap(fDeadlines.begin(), fDeadlines.end(), LaterDeadline());
+}
+
+SamplerEngine::DeviceEntry*
+SamplerEngine::PopDue(bigtime_t now)
+{
+	if(fDeadlines.empty() || fDeadlines.front()->deadline > now)
+		return NULL;
+
+	std::pop_heap(fDeadlines.begin(), fDeadlines.end(), LaterDeadline());
+	DeviceEntry* entry = fDeadlines.back();
+	fDeadlines.pop_back();
+	return entry;
+}
+
+void
+SamplerEngine::WakeDispatcher()
+{
+	release_sem_etc(fWakeSem, 1, B_DO_NOT_RESCHEDULE);
+}
+
+// #pragma mark - Consumer
+
+SamplerEngine::Queue*
+SamplerEngine::OldestQueue()
+{
+	Queue* oldest = NULL;
+	bigtime_t oldestTime = 0;
+	for(int32 i = 0; i < kSamplerWorkerCount; i++) {
+		const ThermalSample* head = fSamples[i].Peek();
+		if(head != NULL && (oldest == NULL || head->snapshot.timestamp < oldestTime)) {
+			oldest = &fSamples[i];
+			oldestTime = head->snapshot.timestamp;
+		}
+	}
+
+	return oldest;
+}
+
+bool
+SamplerEngine::HasSamples() const
+{
+	for(int32 i = 0; i < kSamplerWorkerCount; i++) {
+		if(!fSamples[i].IsEmpty())
+			return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef __SAMPLER_ENGINE__
+#define __SAMPLER_ENGINE__
+
+#ifdef __HAIKU__
+#include <Locker.h>
+#include <String.h>
+#endif
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <queue>
+#include <vector>
+#include "PlatformDefs.h"
+#include "SampleQueue.h"
+#include "ThermalDevice.h"
+
+struct ThermalSample
+{
+	int32			device;
+	status_t		status;
+	ThermalSnapshot	snapshot;
+	bigtime_t		deadline;	// when the read was due, evenly spaced
+};
+
+struct SamplerMetrics
+{
+	uint64			reads;
+	uint64			missed;			// deadlines skipped after late reads
+	bigtime_t		interval;
+	bigtime_t		lastLateness;	// how long after its deadline a read began
+	bigtime_t		maxLateness;
+};
+
+#define kSamplerQueueCapacity 128
+#define kSamplerWorkerCount   2
+
+#define kDefaultRefreshInterval	1000000		// microseconds
+
+#define kDefaultAdaptiveFastest	250000		// microseconds
+#define kDefaultAdaptiveSlowest	10000000
+#define kDefaultAdaptiveSlope	0.2f		// degrees per second
+#define kDefaultAdaptiveMargin	5.0f		// degrees below hot or critical
+#define kAdaptiveBaseline		1000000		// shortest span a slope is measured on
+
+struct AdaptivePolicy
+{
+	bigtime_t	fastest;	// interval while the temperature moves or is close
+	bigtime_t	slowest;	// interval it backs off to while flat
+	float		slope;		// degrees per second that count as moving
+	float		margin;		// degrees below hot or critical that count as close
+};
+
+/*
+ * Polls any number of thermal devices, each one with its own period.
+ * Deadlines are kept in a min-heap served by a dispatcher thread, which
+ * hands due devices to a small fixed pool of worker threads; a device is
+ * never read by two workers at once. Deadlines stay on the grid set by the
+ * first one, so periods do not drift with the time reads take; a read that
+ * ends past later deadlines skips them and counts them as missed. Every
+ * worker publishes into its own lock-free queue, and a single consumer
+ * drains them all with PopSample(), oldest read first, so the samples of
+ * a device come out in order whichever workers read them.
+ * Devices may follow an AdaptivePolicy instead of a fixed period: they are
+ * read at the fastest interval while the temperature moves or is close to
+ * a trip point, and back off by doubling towards the slowest while flat.
+ * Only PlatformDefs.h is needed, so the headless modes run the very same
+ * engine off Haiku; there the caller hands out the device ids.
+ */
+class SamplerEngine
+{
+public:
+	typedef SampleQueue<ThermalSample, kSamplerQueueCapacity> Queue;
+
+						SamplerEngine();
+	virtual				~SamplerEngine();
+
+#ifdef __HAIKU__
+			// With the id DeviceRegistry has for path
+			int32		AddDevice(const char* path, bigtime_t interval);
+			BString		DevicePath(int32 device) const;
+#endif
+			// Returns the id, or an error
+			int32		AddDevice(int32 id, const char* path, bigtime_t interval);
+			status_t	RemoveDevice(int32 device);
+			int32		FindDevice(const char* path) const;
+			status_t	GetDevicePath(int32 device, char* outPath, size_t size) const;
+			bool		HasDevice(int32 device) const;
+			int32		CountDevices() const;
+
+			status_t	SetInterval(int32 device, bigtime_t interval);
+			bigtime_t	Interval(int32 device) const;
+
+			// NULL goes back to the fixed period
+			status_t	SetAdaptive(int32 device, const AdaptivePolicy* policy);
+
+			status_t	GetMetrics(int32 device, SamplerMetrics* outMetrics) const;
+
+			status_t	Start();
+			void		Stop();
+			bool		IsRunning() const;
+
+			// Consumer side: only one thread may pop samples.
+			bool		PopSample(ThermalSample* outSample);
+			// B_OK once a sample can be popped, B_TIMED_OUT otherwise
+			status_t	WaitForSamples(bigtime_t timeout);
+private:
+	struct DeviceEntry {
+		int32			id;
+		ThermalDevice	device;			// keeps the path even when it fails
+		status_t		status;
+		bigtime_t		period;			// set with SetInterval()
+		bigtime_t		interval;		// in use, follows period unless adaptive
+		bigtime_t		deadline;
+		bool			removed;
+		SamplerMetrics	metrics;
+
+		bool			adaptive;
+		AdaptivePolicy	policy;
+		float			slope;
+		float			baseValue;		// where the slope is measured from
+		bigtime_t		baseTime;
+	};
+
+	struct LaterDeadline {
+		bool operator()(const DeviceEntry* a, const DeviceEntry* b) const
+			{ return a->deadline > b->deadline; }
+	};
+
+	struct WorkerInfo {
+		SamplerEngine*	engine;
+		int32			index;
+	};
+
+	static	int32		CallDispatch(void* data);
+			void		Dispatch();
+	static	int32		CallWork(void* data);
+			void		Work(int32 index);
+
+			void		Adapt(DeviceEntry* entry, const ThermalSnapshot& snapshot);
+			void		Schedule(DeviceEntry* entry, bigtime_t now);
+			DeviceEntry* PopDue(bigtime_t now);
+			void		WakeDispatcher();
+			Queue*		OldestQueue();
+			bool		HasSamples() const;
+private:
+	mutable BLocker				fLock;
+	std::map<int32, DeviceEntry*> fDevices;
+	std::vector<DeviceEntry*>	fDeadlines;		// min-heap on deadline
+	std::queue<DeviceEntry*>	fJobs;
+
+	Queue						fSamples[kSamplerWorkerCount];
+	sem_id						fAvailableSem;
+	sem_id						fWakeSem;
+	sem_id						fJobSem;
+
+	thread_id					fDispatcher;
+	thread_id					fWorkers[kSamplerWorkerCount];
+	WorkerInfo					fWorkerInfo[kSamplerWorkerCount];
+	std::atomic<bool>			fQuitting;
+};
+
+#endif /* __SAMPLER_ENGINE__ */
@@ -0,0 +1,282 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef __SERIES_CODEC__
+#define __SERIES_CODEC__
+
+/*
+ * Compact encoding of (time, value) series with integer units, e.g.
+ * milliseconds and centi-degrees. Timestamps are stored as delta-of-delta
+ * and values as deltas, both zig-zag varint encoded and folded into one
+ * token per point:
+ *
+ *	tag 0: run of n points with the same period and value	(n << 2)
+ *	tag 1: same period, value delta follows in the token	(zz(dv) << 2 | 1)
+ *	tag 2: period changed, same value						(zz(dod) << 2 | 2)
+ *	tag 3: both changed, value delta in a second varint		(zz(dod) << 2 | 3)
+ *
+ * The first point of a stream is written as two absolute varints. A steady
+ * series costs one byte per run of up to 2^26 points, a slowly drifting one
+ * about one byte per point. Only the standard library is used so it also
+ * builds on Linux; encoder and decoder never allocate.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+#define kSeriesMaxPointBytes (10 + 10)	// token plus a separate value delta
+#define kSeriesMaxRun        (1 << 26)
+
+namespace SeriesCodecPrivate {
+
+inline uint64_t
+ZigZag(int64_t value)
+{
+	return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t
+UnZigZag(uint64_t value)
+{
+	return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// Wrapping addition, corrupt input must not be undefined behaviour
+inline int64_t
+Add(int64_t a, int64_t b)
+{
+	return static_cast<int64_t>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+}
+
+inline size_t
+PutVarint(uint8_t* out, uint64_t value)
+{
+	size_t length = 0;
+	while(value >= 0x80) {
+		out[length++] = static_cast<uint8_t>(value) | 0x80;
+		value >>= 7;
+	}
+	out[length++] = static_cast<uint8_t>(value);
+	return length;
+}
+
+// Reads a varint from [*cursor, end); false if it is truncated or too long.
+inline bool
+GetVarint(const uint8_t** cursor, const uint8_t* end, uint64_t* outValue)
+{
+	const uint8_t* p = *cursor;
+	if(p < end && *p < 0x80) {
+		*outValue = *p;
+		*cursor = p + 1;
+		return true;
+	}
+
+	uint64_t value = 0;
+	for(int shift = 0; shift < 64 && p < end; shift += 7) {
+		uint8_t byte = *p++;
+		value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+		if(byte < 0x80) {
+			*outValue = value;
+			*cursor = p;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+}	// namespace SeriesCodecPrivate
+
+/*
+ * Streaming encoder into a caller supplied buffer. Append() refuses points
+ * once the buffer might not hold them; Finish() must be called before the
+ * bytes are used, as runs are only written when they end.
+ */
+class SeriesEncoder
+{
+public:
+	SeriesEncoder(uint8_t* buffer, size_t capacity)
+	{
+		SetTo(buffer, capacity);
+	}
+
+	void SetTo(uint8_t* buffer, size_t capacity)
+	{
+		fBuffer = buffer;
+		fCapacity = capacity;
+		fSize = 0;
+		fCount = 0;
+		fTime = 0;
+		fDelta = 0;
+		fValue = 0;
+		fRun = 0;
+	}
+
+	bool Append(int64_t time, int32_t value)
+	{
+		using namespace SeriesCodecPrivate;
+
+		// Room for this point plus a run flushed in front of it
+		if(fSize + kSeriesMaxPointBytes + 10 > fCapacity)
+			return false;
+
+		if(fCount == 0) {
+			fSize += PutVarint(fBuffer + fSize, ZigZag(time));
+			fSize += PutVarint(fBuffer + fSize, ZigZag(value));
+			fTime = time;
+			fValue = value;
+			fCount++;
+			return true;
+		}
+
+		int64_t delta = time - fTime;
+		uint64_t dod = ZigZag(delta - fDelta);
+		uint64_t dv = ZigZag(static_cast<int64_t>(value) - fValue);
+		if(dod >= (1ULL << 62))
+			return false;
+
+		if(dod == 0 && dv == 0 && fRun < kSeriesMaxRun)
+			fRun++;
+		else {
+			FlushRun();
+			if(dod == 0 && dv < (1ULL << 62))
+				fSize += PutVarint(fBuffer + fSize, dv << 2 | 1);
+			else if(dv == 0)
+				fSize += PutVarint(fBuffer + fSize, dod << 2 | 2);
+			else {
+				fSize += PutVarint(fBuffer + fSize, dod << 2 | 3);
+				fSize += PutVarint(fBuffer + fSize, dv);
+			}
+		}
+
+		fTime = time;
+		fDelta = delta;
+		fValue = value;
+		fCount++;
+		return true;
+	}
+
+	// Returns the number of bytes written
+	size_t Finish()
+	{
+		FlushRun();
+		return fSize;
+	}
+
+	const uint8_t* Data() const { return fBuffer; }
+	size_t Size() const { return fSize; }
+	uint32_t Count() const { return fCount; }
+private:
+	void FlushRun()
+	{
+		if(fRun > 0)
+			fSize += SeriesCodecPrivate::PutVarint(fBuffer + fSize, static_cast<uint64_t>(fRun) << 2);
+		fRun = 0;
+	}
+private:
+	uint8_t*	fBuffer;
+	size_t		fCapacity;
+	size_t		fSize;
+	uint32_t	fCount;
+	int64_t		fTime;
+	int64_t		fDelta;
+	int64_t		fValue;
+	uint32_t	fRun;
+};
+
+/*
+ * Streaming decoder over a (data, length) span; it never reads past the
+ * end and stops at the first malformed token.
+ */
+class SeriesDecoder
+{
+public:
+	SeriesDecoder(const uint8_t* data, size_t length)
+	:
+	fCursor(data),
+	fEnd(data + length),
+	fStarted(false),
+	fTime(0),
+	fDelta(0),
+	fValue(0),
+	fRun(0)
+	{
+	}
+
+	bool Next(int64_t* outTime, int32_t* outValue)
+	{
+		using namespace SeriesCodecPrivate;
+
+		if(fRun == 0) {
+			uint64_t token;
+			if(!GetVarint(&fCursor, fEnd, &token))
+				return false;
+
+			if(!fStarted) {
+				uint64_t value;
+				if(!GetVarint(&fCursor, fEnd, &value))
+					return false;
+				fTime = UnZigZag(token);
+				fValue = UnZigZag(value);
+				fStarted = true;
+				*outTime = fTime;
+				*outValue = static_cast<int32_t>(fValue);
+				return true;
+			}
+
+			switch(token & 3) {
+				case 0:
+					fRun = token >> 2;
+					if(fRun == 0)
+						return false;
+					break;
+				case 1:
+					fValue = Add(fValue, UnZigZag(token >> 2));
+					break;
+				case 2:
+					fDelta = Add(fDelta, UnZigZag(token >> 2));
+					break;
+				case 3:
+				{
+					uint64_t value;
+					if(!GetVarint(&fCursor, fEnd, &value))
+						return false;
+					fDelta = Add(fDelta, UnZigZag(token >> 2));
+					fValue = Add(fValue, UnZigZag(value));
+					break;
+				}
+			}
+		}
+
+		if(fRun > 0)
+			fRun--;
+
+		fTime = SeriesCodecPrivate::Add(fTime, fDelta);
+		*outTime = fTime;
+		*outValue = static_cast<int32_t>(fValue);
+		return true;
+	}
+
+	// Decodes up to maxPoints points, returns how many were decoded
+	size_t Decode(int64_t* outTimes, int32_t* outValues, size_t maxPoints)
+	{
+		size_t count = 0;
+		while(count < maxPoints && Next(&outTimes[count], &outValues[count]))
+			count++;
+
+		return count;
+	}
+
+	bool IsAtEnd() const { return fCursor == fEnd && fRun == 0; }
+private:
+	const uint8_t*	fCursor;
+	const uint8_t*	fEnd;
+	bool			fStarted;
+	int64_t			fTime;
+	int64_t			fDelta;
+	int64_t			fValue;
+	uint64_t		fRun;
+};
+
+#endif /* __SERIES_CODEC__ */
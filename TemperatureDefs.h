@@ -7,12 +7,21 @@ enum {
 	M_STARTED_RUNNING			= 'strt',
 	M_STOPPED_RUNNING			= 'stop',
 	M_REFRESH_RATE				= 'rate',
+	M_STATISTICS_WINDOW			= 'swnd',
 	M_TEMPERATURE_REQUESTED		= 'temp',
 	M_TEMPERATURE_REPLY,
 	M_GRAPHVIEW_PAUSE			= 'paus',
 	M_GRAPHVIEW_WATERMARK		= 'wter',
 	M_GRAPHVIEW_COLOR_CHANGED	= 'PSTE',
-	M_RESTORE_DEFAULTS			= 'rstr'
+	M_GRAPHVIEW_RESOLUTION		= 'gres',
+	M_RESTORE_DEFAULTS			= 'rstr',
+	M_DEVICES_CHANGED			= 'dvls',
+	M_ADAPTIVE_SAMPLING			= 'adpt',
+	M_SAMPLES_SUBSCRIBE			= 'ssub',
+	M_SAMPLES_UNSUBSCRIBE		= 'suns',
+	M_SAMPLES_SUBSCRIBED		= 'sack',
+	M_SAMPLE_BROADCAST			= 'smpl',
+	M_EXPORT_HISTORY			= 'expt'
 };
 
 /* Application identity */
@@ -20,16 +29,37 @@ enum {
 #define kTemperatureSuiteMime "suite/vnd.Loa-Temperature"
 #define kTemperatureConfigFile kAppName ".settings"
 #define kTemperatureMime "application/x-vnd.Loa-Temperature"
+#define kHistoryLogDirectory kAppName "/history"	// in the user data directory
 
 /* Configuration names */
 #define kConfigDevicePath   "device"
+#define kConfigDevicePulses "device:pulses"		// seconds, read from older settings
+#define kConfigDeviceIntervals "device:intervals"
 #define kConfigTempScale    "scale"
 #define kConfigBaseWnd      "window:"
 #define kConfigBaseGraph    "graph:"
+#define kConfigBaseHistory  "history:"
+#define kConfigBaseStats    "statistics:"
+#define kConfigBaseAlerts   "alerts:"
+#define kConfigBaseSampling "sampling:"
 #define kConfigWndFrame     kConfigBaseWnd   "frame"
-#define kConfigWndPulse     kConfigBaseWnd   "pulse"
+#define kConfigWndPulse     kConfigBaseWnd   "pulse"		// seconds, kept for older versions
+#define kConfigWndInterval  kConfigBaseWnd   "interval"
 #define kConfigGraphRun     kConfigBaseGraph "running"
 #define kConfigGraphWMark   kConfigBaseGraph "watermark"
 #define kConfigGraphLColor  kConfigBaseGraph "line_color"
+#define kConfigGraphTier    kConfigBaseGraph "resolution"
+#define kConfigHistoryRaw   kConfigBaseHistory "raw"
+#define kConfigHistoryMin   kConfigBaseHistory "minutes"
+#define kConfigHistoryHour  kConfigBaseHistory "hours"
+#define kConfigHistoryLog   kConfigBaseHistory "log"
+#define kConfigStatsWindow  kConfigBaseStats "window"
+#define kConfigAlertRules   kConfigBaseAlerts "rules"
+#define kConfigAlertHook    kConfigBaseAlerts "hook"
+#define kConfigSampAdaptive kConfigBaseSampling "adaptive"
+#define kConfigSampFastest  kConfigBaseSampling "fastest"
+#define kConfigSampSlowest  kConfigBaseSampling "slowest"
+#define kConfigSampSlope    kConfigBaseSampling "slope"
+#define kConfigSampMargin   kConfigBaseSampling "margin"
 
 #endif /* __TEMPERATURE_DEFS__ */
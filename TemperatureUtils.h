@@ -5,8 +5,12 @@
 #ifndef __TEMPERATURE_UTILS__
 #define __TEMPERATURE_UTILS__
 
+#include <cstddef>
+#include "PlatformDefs.h"
+
+#ifdef __HAIKU__
 #include <String.h>
-#include <SupportDefs.h>
+#endif
 
 enum {
 	SCALE_CELSIUS = 'c',
@@ -27,6 +31,7 @@ inline bool IsValidScale(char opcode) {
 	}
 }
 
+#ifdef __HAIKU__
 inline BString SymbolForScale(char opcode, int32 addSpacing = 0) {
 	static auto symbol = [](char opcode) {
 		switch(opcode) {
@@ -44,46 +49,61 @@ inline BString SymbolForScale(char opcode, int32 addSpacing = 0) {
 
 	return output;
 }
+#endif
+
+/*
+ * A conversion between two scales as (value + shift) * factor + offset,
+ * which performs the same operations as the textbook formulas, so batch
+ * and single conversions agree to the bit. Unknown scales yield 0.
+ */
+struct ScaleConversion {
+	float shift;
+	float factor;
+	float offset;
+
+	float Apply(float value) const { return (value + shift) * factor + offset; }
+};
+
+inline ScaleConversion ConversionForScales(char initialScale, char finalScale) {
+	ScaleConversion identity = { 0.0f, 1.0f, 0.0f };
+	ScaleConversion none = { 0.0f, 0.0f, 0.0f };
+	if(!IsValidScale(initialScale) || !IsValidScale(finalScale))
+		return none;
+	if(initialScale == finalScale)
+		return identity;
 
-inline float ConvertToScale(float initial, char initialScale, char finalScale) {
-	float converted = 0.0f;
 	switch(initialScale) {
-		case SCALE_CELSIUS: {
-			switch(finalScale) {
-				case SCALE_CELSIUS:
-					converted = initial; break;
-				case SCALE_FAHRENHEIT:
-					converted = initial * (9.0f / 5.0f) + 32.0f; break;
-				case SCALE_KELVIN:
-					converted = initial + 273.15f; break;
-			}
-			break;
-		}
-		case SCALE_FAHRENHEIT: {
-			switch(finalScale) {
-				case SCALE_CELSIUS:
-					converted = (initial - 32.0f) * (5.0f / 9.0f); break;
-				case SCALE_FAHRENHEIT:
-					converted = initial; break;
-				case SCALE_KELVIN:
-					converted = (initial + 459.67f) * (5.0f / 9.0f); break;
-			}
-			break;
-		}
-		case SCALE_KELVIN: {
-			switch(finalScale) {
-				case SCALE_CELSIUS:
-					converted = initial - 273.15f; break;
-				case SCALE_FAHRENHEIT:
-					converted = initial * (9.0f / 5.0f) - 459.67f; break;
-				case SCALE_KELVIN:
-					converted = initial; break;
-			}
-			break;
-		}
+		case SCALE_CELSIUS:
+			if(finalScale == SCALE_FAHRENHEIT)
+				return { 0.0f, 9.0f / 5.0f, 32.0f };
+			return { 273.15f, 1.0f, 0.0f };
+		case SCALE_FAHRENHEIT:
+			if(finalScale == SCALE_CELSIUS)
+				return { -32.0f, 5.0f / 9.0f, 0.0f };
+			return { 459.67f, 5.0f / 9.0f, 0.0f };
+		case SCALE_KELVIN:
+		default:
+			if(finalScale == SCALE_CELSIUS)
+				return { -273.15f, 1.0f, 0.0f };
+			return { 0.0f, 9.0f / 5.0f, -459.67f };
 	}
+}
+
+inline float ConvertToScale(float initial, char initialScale, char finalScale) {
+	return ConversionForScales(initialScale, finalScale).Apply(initial);
+}
 
-	return converted;
+// Converts count values at once; in and out may be the same array. The
+//	conversion is resolved once and the loop is left plain so that the
+//	compiler vectorises it for whatever the target offers.
+inline void ConvertSpan(const float* in, float* out, size_t count,
+	char initialScale, char finalScale) {
+	const ScaleConversion conversion = ConversionForScales(initialScale, finalScale);
+	const float shift = conversion.shift;
+	const float factor = conversion.factor;
+	const float offset = conversion.offset;
+	for(size_t i = 0; i < count; i++)
+		out[i] = (in[i] + shift) * factor + offset;
 }
 
 #endif /* __TEMPERATURE_UTILS__ */
@@ -2,20 +2,50 @@
  * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
  * Distributed under the terms of the MIT License.
  */
-#include <DataIO.h>
-#include <File.h>
-#include <String.h>
-#include <StringList.h>
-#include <cassert>
 #include <cstdio>
 #include <cstring>
+#include <cerrno>
+#include <dirent.h>
 #include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "ThermalDevice.h"
+#include "ThermalParser.h"
+
+void
+ThermalSnapshot::MakeEmpty()
+{
+	for(int i = 0; i < TEMPERATURE_COUNT; i++) {
+		temperatures[i] = 0.0f;
+		reported[i] = false;
+	}
+	timestamp = 0;
+}
+
+bool
+ThermalSnapshot::IsReported(DeviceTemperature which) const
+{
+	if(which < 0 || which >= TEMPERATURE_COUNT)
+		return false;
+
+	return reported[which];
+}
+
+float
+ThermalSnapshot::Temperature(DeviceTemperature which) const
+{
+	if(which < 0 || which >= TEMPERATURE_COUNT)
+		return 0.0f;
+
+	return temperatures[which];
+}
 
 ThermalDevice::ThermalDevice(const char* path)
-: fPath(""),
-  fFD(-1)
+: fFD(-1),
+  fBufferLength(0),
+  fReopenCount(0)
 {
+	fPath[0] = '\0';
 	if(path)
 		SetTo(path);
 }
@@ -37,11 +67,18 @@ ThermalDevice::SetTo(const char* path)
 	if(!path)
 		return B_BAD_VALUE;
 
-	fPath.SetTo(path);
+	if(strlen(path) >= sizeof(fPath))
+		return B_NAME_TOO_LONG;
+
+	// path may be our own Location()
+	char newPath[kThermalDevicePathSize];
+	strcpy(newPath, path);
+	Unset();
+	strcpy(fPath, newPath);
+	// The path is kept when it cannot be opened, reads try it again
 	fFD = open(fPath, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
 	if(fFD < 0) {
-		fprintf(stderr, "Error: device file \'%s\' could not be POSIX-opened.\n", fPath.String());
-		Unset();
+		fprintf(stderr, "Error: device file \'%s\' could not be POSIX-opened.\n", fPath);
 		return B_ERROR;
 	}
 
@@ -56,67 +93,49 @@ ThermalDevice::Unset()
 		fFD = -1;
 	}
 
-	fPath.SetTo("");
+	fPath[0] = '\0';
 }
 
 const char*
 ThermalDevice::Location() const
 {
-	return fPath.String();
+	return fPath;
+}
+
+status_t
+ThermalDevice::ReadSnapshot(ThermalSnapshot* outSnapshot)
+{
+	if(!outSnapshot)
+		return B_BAD_VALUE;
+
+	outSnapshot->MakeEmpty();
+	if(fPath[0] == '\0')
+		return B_NO_INIT;
+
+	status_t status = ReadDevice();
+	outSnapshot->timestamp = system_time();
+	if(status != B_OK)
+		return status;
+
+	return ParseData(fBuffer, fBufferLength, outSnapshot);
 }
 
 float
 ThermalDevice::ReadTemperature(DeviceTemperature which)
 {
-	float temperature = 0.0f;
-	BObjectList<float> temperatures;
-	for(auto i = 0; i < TEMPERATURE_COUNT; i++)
-		temperatures.AddItem(&temperature);
-
-	switch(which)
-	{
-		case TEMPERATURE_CURRENT:
-		case TEMPERATURE_CRITICAL:
-		case TEMPERATURE_HOT:
-		{
-			BMallocIO alloc;
-			ReadDevice(&alloc);
-			BMemoryIO memory((const void*)alloc.Buffer(), alloc.BufferLength());
-			ParseData(&memory, &temperatures);
-			temperature = *temperatures.ItemAt(which);
-			break;
-		}
-		default:
-			break;
-	}
-	return temperature;
+	ThermalSnapshot snapshot;
+	ReadSnapshot(&snapshot);
+	return snapshot.Temperature(which);
 }
 
 bool
 ThermalDevice::IsTemperatureReported(DeviceTemperature which)
 {
-	if(InitCheck() != B_OK)
+	ThermalSnapshot snapshot;
+	if(ReadSnapshot(&snapshot) != B_OK)
 		return false;
 
-	BMallocIO alloc;
-	ReadDevice(&alloc);
-	bool result = false;
-	switch(which)
-	{
-		case TEMPERATURE_CURRENT:
-			result = strstr(reinterpret_cast<const char*>(alloc.Buffer()), "Current") != NULL;
-			break;
-		case TEMPERATURE_CRITICAL:
-			result = strstr(reinterpret_cast<const char*>(alloc.Buffer()), "Critical") != NULL;
-			break;
-		case TEMPERATURE_HOT:
-			result = strstr(reinterpret_cast<const char*>(alloc.Buffer()), "Hot") != NULL;
-			break;
-		default:
-			break;
-	}
-
-	return result;
+	return snapshot.IsReported(which);
 }
 
 void
@@ -124,98 +143,159 @@ ThermalDevice::PrintToStream()
 {
 	printf("Thermal device: %s\n", InitCheck() != B_OK ? "not initialized" : Location());
 	if(InitCheck() == B_OK) {
+		ThermalSnapshot snapshot;
+		ReadSnapshot(&snapshot);
+
 		printf(
 				"Reports temperatures:\n"
 				"\t[%s]  Current temperature\n"
 				"\t[%s]  Critical temperature\n"
 				"\t[%s]  Hot temperature\n",
-				IsTemperatureReported(TEMPERATURE_CURRENT)  ? "X" : " ",
-				IsTemperatureReported(TEMPERATURE_CRITICAL) ? "X" : " ",
-				IsTemperatureReported(TEMPERATURE_HOT)      ? "X" : " ");
+				snapshot.IsReported(TEMPERATURE_CURRENT)  ? "X" : " ",
+				snapshot.IsReported(TEMPERATURE_CRITICAL) ? "X" : " ",
+				snapshot.IsReported(TEMPERATURE_HOT)      ? "X" : " ");
 		printf("Values at the time of report:\n");
 		printf("\tCurrent: ");
-		if(IsTemperatureReported(TEMPERATURE_CURRENT))
-			printf("%.2f\n", ReadTemperature(TEMPERATURE_CURRENT));
+		if(snapshot.IsReported(TEMPERATURE_CURRENT))
+			printf("%.2f\n", snapshot.Temperature(TEMPERATURE_CURRENT));
 		else
 			printf("not reported\n");
 		printf("\tCritical: ");
-		if(IsTemperatureReported(TEMPERATURE_CRITICAL))
-			printf("%.2f\n", ReadTemperature(TEMPERATURE_CRITICAL));
+		if(snapshot.IsReported(TEMPERATURE_CRITICAL))
+			printf("%.2f\n", snapshot.Temperature(TEMPERATURE_CRITICAL));
 		else
 			printf("not reported\n");
 		printf("\tHot: ");
-		if(IsTemperatureReported(TEMPERATURE_HOT))
-			printf("%.2f\n", ReadTemperature(TEMPERATURE_HOT));
+		if(snapshot.IsReported(TEMPERATURE_HOT))
+			printf("%.2f\n", snapshot.Temperature(TEMPERATURE_HOT));
 		else
 			printf("not reported\n");
 	}
 }
 
+uint32
+ThermalDevice::ReopenCount() const
+{
+	return fReopenCount;
+}
+
+/* static */
+int32
+ThermalDevice::FindDevices(const char* root, void (*visitor)(const char* path, void* cookie),
+	void* cookie)
+{
+	DIR* rootDirectory = opendir(root);
+	if(rootDirectory == NULL)
+		return B_IO_ERROR;
+
+	// Thermal drivers publish either a node or a directory of nodes
+	int32 count = 0;
+	char path[kThermalDevicePathSize];
+	while(struct dirent* entry = readdir(rootDirectory)) {
+		if(strstr(entry->d_name, "thermal") == NULL)
+			continue;
+
+		// A device path that does not fit could not be opened anyway
+		struct stat st;
+		int length = snprintf(path, sizeof(path), "%s/%s", root, entry->d_name);
+		if(length < 0 || length >= (int)sizeof(path) || stat(path, &st) != 0)
+			continue;
+
+		if(!S_ISDIR(st.st_mode)) {
+			visitor(path, cookie);
+			count++;
+			continue;
+		}
+
+		DIR* directory = opendir(path);
+		if(directory == NULL)
+			continue;
+
+		char subPath[kThermalDevicePathSize];
+		while(struct dirent* subEntry = readdir(directory)) {
+			length = snprintf(subPath, sizeof(subPath), "%s/%s", path, subEntry->d_name);
+			if(length < 0 || length >= (int)sizeof(subPath)
+				|| stat(subPath, &st) != 0 || S_ISDIR(st.st_mode))
+				continue;
+
+			visitor(subPath, cookie);
+			count++;
+		}
+		closedir(directory);
+	}
+	closedir(rootDirectory);
+
+	return count;
+}
+
 // #pragma mark - Internal
 
 status_t
-ThermalDevice::ReadDevice(BPositionIO* outData)
+ThermalDevice::Reopen()
 {
-	if(InitCheck() != B_OK || !outData)
-		return B_ERROR;
+	if(fFD >= 0) {
+		close(fFD);
+		fFD = -1;
+	}
 
-	BFile deviceFile(Location(), B_READ_ONLY);
-	if(deviceFile.InitCheck() != B_OK)
-		return B_ERROR;
+	fFD = open(fPath, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	if(fFD < 0)
+		return B_IO_ERROR;
 
-	char* buffer = new char[1024];
-	if(!buffer)
-		return B_NO_MEMORY;
+	fReopenCount++;
+	return B_OK;
+}
 
-	ssize_t readBytes = deviceFile.Read((void*)buffer, 1024);
-	if(readBytes < 0) {
-		delete[] buffer;
+status_t
+ThermalDevice::ReadDevice()
+{
+	fBufferLength = 0;
+	if(fPath[0] == '\0')
+		return B_NO_INIT;
+
+	// A node that was missing, e.g. while its driver reloads, is tried
+	//	again on every read until it comes back
+	if(fFD < 0 && Reopen() != B_OK)
 		return B_IO_ERROR;
+
+	// The thermal drivers hand out the whole report on every read at
+	//	offset 0, so the descriptor opened by SetTo() can be reused.
+	ssize_t readBytes = pread(fFD, fBuffer, sizeof(fBuffer) - 1, 0);
+	if(readBytes < 0 && (errno == ENODEV || errno == EBADF)) {
+		if(Reopen() != B_OK)
+			return B_IO_ERROR;
+		readBytes = pread(fFD, fBuffer, sizeof(fBuffer) - 1, 0);
 	}
-	ssize_t writtenBytes = outData->Write((const void*)buffer, readBytes);
-	delete[] buffer;
-	return writtenBytes < 0 ? B_IO_ERROR : B_OK;
+	if(readBytes < 0)
+		return errno == EAGAIN ? B_WOULD_BLOCK : B_IO_ERROR;
+
+	fBufferLength = readBytes;
+	fBuffer[fBufferLength] = '\0';
+	return B_OK;
 }
 
 status_t
-ThermalDevice::ParseData(BPositionIO* inData, BObjectList<float>* outList)
+ThermalDevice::ParseData(const char* data, size_t length, ThermalSnapshot* outSnapshot)
 {
-	if(!inData || !outList) {
+	if(!data || !outSnapshot) {
 		fprintf(stderr, "Error: invalid parameter values.\n");
 		return B_BAD_VALUE;
 	}
 
-	off_t size = 0;
-	inData->GetSize(&size);
-	char* buffer = new char[size + 1];
-	buffer[size] = '\0';
-	ssize_t readBytes = inData->Read((void*)buffer, size);
-	if(readBytes < 0) {
-		fprintf(stderr, "Error: I/O error while reading.\n");
-		return B_IO_ERROR;
-	}
-
-	BStringList reportedList;
-	BString(buffer).Split("\n", true, reportedList);
+	ParseThermalReport(data, length, [outSnapshot](const ThermalReportEntry& entry) {
+		DeviceTemperature which = TEMPERATURE_INVALID;
+		if(ThermalReportKeyIs(entry, "Current"))
+			which = TEMPERATURE_CURRENT;
+		else if(ThermalReportKeyIs(entry, "Critical"))
+			which = TEMPERATURE_CRITICAL;
+		else if(ThermalReportKeyIs(entry, "Hot"))
+			which = TEMPERATURE_HOT;
+		else
+			return;
 
-	float temperature = 0.0f;
-	for(int i = 0; i < reportedList.CountStrings(); i++) {
-		BString item = reportedList.StringAt(i);
-		assert(item != NULL);
-		if(strstr(item.String(), "Current") != NULL) {
-			item.ScanWithFormat("  Current Temperature: %f C\n", &temperature);
-			*outList->ItemAt(TEMPERATURE_CURRENT) = temperature;
-		}
-		else if(strstr(item.String(), "Critical") != NULL) {
-			item.ScanWithFormat("  Critical Temperature: %f C\n", &temperature);
-			*outList->ItemAt(TEMPERATURE_CRITICAL) = temperature;
-		}
-		else if(strstr(item.String(), "Hot") != NULL) {
-			item.ScanWithFormat("  Hot Temperature: %f C\n", &temperature);
-			*outList->ItemAt(TEMPERATURE_HOT) = temperature;
-		}
-	}
+		outSnapshot->temperatures[which] = entry.value;
+		outSnapshot->reported[which] = true;
+	});
 
-	delete[] buffer;
 	return B_OK;
 }
@@ -5,10 +5,7 @@
 #ifndef __THERMAL_DEVICE__
 #define __THERMAL_DEVICE__
 
-#include <DataIO.h>
-#include <ObjectList.h>
-#include <String.h>
-#include <SupportDefs.h>
+#include "PlatformDefs.h"
 
 enum DeviceTemperature {
 	TEMPERATURE_CURRENT  = 0,
@@ -19,6 +16,26 @@ enum DeviceTemperature {
 	TEMPERATURE_INVALID  = -1
 };
 
+#define kThermalDeviceBufferSize 1024
+#define kThermalDevicePathSize   1024
+#define kThermalDeviceRoot       "/dev/power"
+
+// Shortest interval any device is read at, in microseconds
+#define kMinimumRefreshInterval  100000
+
+struct ThermalSnapshot
+{
+	float		temperatures[TEMPERATURE_COUNT];
+	bool		reported[TEMPERATURE_COUNT];
+	bigtime_t	timestamp;
+
+				ThermalSnapshot() { MakeEmpty(); }
+
+	void		MakeEmpty();
+	bool		IsReported(DeviceTemperature which) const;
+	float		Temperature(DeviceTemperature which) const;
+};
+
 class ThermalDevice
 {
 public:
@@ -29,15 +46,31 @@ public:
 			status_t 	SetTo(const char* path);
 			void 		Unset();
 			const char* Location() const;
+			// Reopens the node when it is not open, B_NO_INIT only without a path
+			status_t	ReadSnapshot(ThermalSnapshot* outSnapshot);
 			float 		ReadTemperature(DeviceTemperature = TEMPERATURE_CURRENT);
 			bool		IsTemperatureReported(DeviceTemperature);
 	virtual void 		PrintToStream();
+
+			uint32		ReopenCount() const;
+
+	// Calls visitor for every thermal device node below root and returns
+	//	how many were found, or an error if root cannot be read.
+	static	int32		FindDevices(const char* root,
+							void (*visitor)(const char* path, void* cookie),
+							void* cookie);
 private:
-			status_t 	ReadDevice(BPositionIO* outData);
-			status_t	ParseData(BPositionIO* inData, BObjectList<float>* outList);
+			status_t	Reopen();
+			status_t 	ReadDevice();
+			status_t	ParseData(const char* data, size_t length,
+							ThermalSnapshot* outSnapshot);
 private:
-	BString fPath;
+	char fPath[kThermalDevicePathSize];
 	int fFD;
+
+	char fBuffer[kThermalDeviceBufferSize];
+	size_t fBufferLength;
+	uint32 fReopenCount;
 };
 
 #endif /* __THERMAL_DEVICE__ */
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef __THERMAL_PARSER__
+#define __THERMAL_PARSER__
+
+/*
+ * Parser for the text reports of the thermal drivers, e.g.:
+ *
+ *	  Critical Temperature: 105.0 C
+ *	  Current Temperature: 47.5 C
+ *
+ * It works in a single pass over a (data, length) span, does not need the
+ * span to be NUL-terminated, never reads past data + length and does not
+ * allocate. Only the standard library is used so it also builds on Linux.
+ */
+
+#include <cstddef>
+#include <cstring>
+
+struct ThermalReportEntry {
+	const char*	key;		// "Current", "Critical", "Hot", ...
+	size_t		keyLength;
+	float		value;		// as reported, in degrees Celsius
+};
+
+inline bool
+ThermalReportKeyIs(const ThermalReportEntry& entry, const char* key)
+{
+	size_t length = strlen(key);
+	return entry.keyLength == length && memcmp(entry.key, key, length) == 0;
+}
+
+namespace ThermalParserPrivate {
+
+static const char kTemperatureWord[] = "Temperature";
+static const size_t kTemperatureWordLength = sizeof(kTemperatureWord) - 1;
+
+inline bool
+IsBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline bool
+IsDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+// Parses "[-]digits[.digits]" in [*cursor, end) and advances *cursor.
+inline bool
+ParseNumber(const char** cursor, const char* end, float* outValue)
+{
+	const char* p = *cursor;
+	bool negative = false;
+	if(p < end && (*p == '-' || *p == '+')) {
+		negative = *p == '-';
+		p++;
+	}
+
+	bool hasDigits = false;
+	double value = 0.0;
+	while(p < end && IsDigit(*p)) {
+		value = value * 10.0 + (*p - '0');
+		hasDigits = true;
+		p++;
+	}
+	if(p < end && *p == '.') {
+		p++;
+		double scale = 0.1;
+		while(p < end && IsDigit(*p)) {
+			value += (*p - '0') * scale;
+			scale *= 0.1;
+			hasDigits = true;
+			p++;
+		}
+	}
+	if(!hasDigits)
+		return false;
+
+	*outValue = static_cast<float>(negative ? -value : value);
+	*cursor = p;
+	return true;
+}
+
+// Parses one "<key> Temperature[ suffix]: <number> C" line in [begin, end).
+inline bool
+ParseLine(const char* begin, const char* end, ThermalReportEntry* outEntry)
+{
+	while(begin < end && IsBlank(*begin))
+		begin++;
+
+	const char* keyEnd = NULL;
+	for(const char* p = begin; p + kTemperatureWordLength <= end; p++) {
+		if(memcmp(p, kTemperatureWord, kTemperatureWordLength) == 0) {
+			keyEnd = p;
+			break;
+		}
+	}
+	if(keyEnd == NULL)
+		return false;
+
+	const char* cursor = keyEnd + kTemperatureWordLength;
+	while(keyEnd > begin && IsBlank(keyEnd[-1]))
+		keyEnd--;
+	if(keyEnd == begin)
+		return false;
+
+	while(cursor < end && *cursor != ':')
+		cursor++;
+	if(cursor == end)
+		return false;
+	cursor++;
+	while(cursor < end && IsBlank(*cursor))
+		cursor++;
+
+	float value = 0.0f;
+	if(!ParseNumber(&cursor, end, &value))
+		return false;
+
+	while(cursor < end && IsBlank(*cursor))
+		cursor++;
+	if(cursor == end || *cursor != 'C')
+		return false;
+
+	outEntry->key = begin;
+	outEntry->keyLength = keyEnd - begin;
+	outEntry->value = value;
+	return true;
+}
+
+} // namespace ThermalParserPrivate
+
+/*
+ * Calls visitor(const ThermalReportEntry&) for every temperature line in
+ * the report and returns the number of lines recognised.
+ */
+template<typename Visitor>
+inline size_t
+ParseThermalReport(const char* data, size_t length, Visitor&& visitor)
+{
+	if(data == NULL)
+		return 0;
+
+	size_t found = 0;
+	const char* end = data + length;
+	const char* line = data;
+	while(line < end) {
+		const char* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+		if(lineEnd == NULL)
+			lineEnd = end;
+
+		ThermalReportEntry entry;
+		if(ThermalParserPrivate::ParseLine(line, lineEnd, &entry)) {
+			visitor(static_cast<const ThermalReportEntry&>(entry));
+			found++;
+		}
+
+		if(lineEnd == end)
+			break;
+		line = lineEnd + 1;
+	}
+
+	return found;
+}
+
+#endif /* __THERMAL_PARSER__ */
@@ -0,0 +1,40 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+/*
+ * Runs a fuzz target once over each file given, and over every prefix of
+ * it, where libFuzzer is not available.
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+int
+main(int argc, char** argv)
+{
+	for(int i = 1; i < argc; i++) {
+		FILE* file = fopen(argv[i], "rb");
+		if(file == NULL) {
+			perror(argv[i]);
+			return 1;
+		}
+
+		std::vector<uint8_t> input;
+		int c;
+		while((c = fgetc(file)) != EOF)
+			input.push_back(c);
+		fclose(file);
+
+		// Each prefix in its own allocation, so overreads hit the redzone
+		for(size_t length = 0; length <= input.size(); length++) {
+			std::vector<uint8_t> prefix(input.begin(), input.begin() + length);
+			LLVMFuzzerTestOneInput(prefix.data(), prefix.size());
+		}
+	}
+
+	printf("%d inputs replayed\n", argc - 1);
+	return 0;
+}
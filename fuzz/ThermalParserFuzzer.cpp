@@ -0,0 +1,32 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include "ThermalParser.h"
+
+/*
+ * libFuzzer entry point. The input is parsed as is, without a terminator,
+ * so any read past its end is reported by the address sanitizer.
+ */
+extern "C" int
+LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	const char* text = reinterpret_cast<const char*>(data);
+	size_t lines = 0;
+	for(size_t i = 0; i < size; i++)
+		lines += text[i] == '\n';
+
+	size_t found = ParseThermalReport(text, size, [text, size](const ThermalReportEntry& entry) {
+		// Keys point into the report and are never empty
+		if(entry.key < text || entry.keyLength == 0
+			|| entry.key + entry.keyLength > text + size)
+			abort();
+	});
+	if(found > lines + 1)
+		abort();
+
+	return 0;
+}
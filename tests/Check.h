@@ -0,0 +1,54 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef __CHECK__
+#define __CHECK__
+
+/*
+ * The little the tests need: CHECK() reports a failed condition and goes
+ * on, CheckResult() gives the exit code. Benchmarks time with Now().
+ */
+
+#include <chrono>
+#include <cstdio>
+
+static int sCheckFailures = 0;
+
+#define CHECK(condition) \
+	do { \
+		if(!(condition)) { \
+			fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			sCheckFailures++; \
+		} \
+	} while(0)
+
+inline int
+CheckResult(const char* name)
+{
+	if(sCheckFailures > 0) {
+		fprintf(stderr, "%s: %d checks failed\n", name, sCheckFailures);
+		return 1;
+	}
+
+	printf("%s: passed\n", name);
+	return 0;
+}
+
+// Seconds on a monotonic clock
+inline double
+Now()
+{
+	return std::chrono::duration<double>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Keeps the optimizer from dropping a computation whose result is unused
+template<typename T>
+inline void
+KeepValue(const T& value)
+{
+	asm volatile("" : : "g"(&value) : "memory");
+}
+
+#endif /* __CHECK__ */
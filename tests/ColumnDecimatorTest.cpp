@@ -0,0 +1,124 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "Check.h"
+#include "ColumnDecimator.h"
+
+/*
+ * Pushes random series with single-sample spikes into a decimator and
+ * folds the same points by brute force, bucket by bucket, changing the
+ * bucket size and emptying both along the way. The column holding a
+ * spike has to reach it.
+ */
+template<size_t N>
+static void
+CheckAgainstModel(unsigned seed, int operations)
+{
+	typedef typename ColumnDecimator<N>::Column Column;
+
+	ColumnDecimator<N> decimator;
+	std::vector<Column> points;		// pushed since the last reset
+	std::vector<size_t> spikes;		// indices into points
+	size_t bucketSize = 1;
+	std::mt19937 random(seed);
+	float value = 50.0f;
+
+	for(int operation = 0; operation < operations; operation++) {
+		unsigned choice = random() % 256;
+		if(choice == 0) {
+			bucketSize = 1 + random() % 40;
+			decimator.SetBucketSize(bucketSize);
+			points.clear();
+			spikes.clear();
+		}
+		else if(choice == 1) {
+			decimator.MakeEmpty();
+			points.clear();
+			spikes.clear();
+		}
+		else {
+			value += (static_cast<int>(random() % 101) - 50) / 100.0f;
+			Column point = { value, value, value, value };
+			if(choice < 12) {
+				// A throttling spike, one sample only
+				float spike = value + (choice % 2 == 0 ? 40.0f : -40.0f) + operation % 7;
+				point = { spike, spike, spike, spike };
+				spikes.push_back(points.size());
+			}
+			else if(choice < 40) {
+				// An already folded range, as from a history bucket
+				float low = value - (random() % 300) / 100.0f;
+				float high = value + (random() % 300) / 100.0f;
+				point = { value, low + (high - low) / 2, low, high };
+			}
+
+			bool started = points.size() % bucketSize == 0;
+			bool pushed = choice < 40 && choice >= 12
+				? decimator.Push(point) : decimator.Push(point.first);
+			CHECK(pushed == started);
+			points.push_back(point);
+		}
+
+		// Brute force fold of every bucket, keeping the newest N
+		std::vector<Column> model;
+		for(size_t start = 0; start < points.size(); start += bucketSize) {
+			size_t end = std::min(start + bucketSize, points.size());
+			Column column = points[start];
+			for(size_t i = start + 1; i < end; i++) {
+				column.last = points[i].last;
+				column.min = std::min(column.min, points[i].min);
+				column.max = std::max(column.max, points[i].max);
+			}
+			model.push_back(column);
+		}
+		if(model.size() > N)
+			model.erase(model.begin(), model.end() - N);
+
+		CHECK(decimator.BucketSize() == bucketSize);
+		CHECK(decimator.Count() == model.size());
+		for(size_t i = 0; i < model.size() && i < decimator.Count(); i++) {
+			Column column = decimator.ColumnAt(i);
+			CHECK(column.first == model[i].first);
+			CHECK(column.last == model[i].last);
+			CHECK(column.min == model[i].min);
+			CHECK(column.max == model[i].max);
+		}
+
+		size_t last = random() % (N + 3);
+		size_t expected = std::min(last, model.size());
+		size_t visited = 0;
+		decimator.ForEachLast(last, [&](size_t index, const Column& column) {
+			CHECK(index == visited);
+			CHECK(column.min == model[model.size() - expected + index].min);
+			CHECK(column.max == model[model.size() - expected + index].max);
+			visited++;
+		});
+		CHECK(visited == expected);
+	}
+
+	// The bar of every column still shown reaches its spikes
+	size_t buckets = (points.size() + bucketSize - 1) / bucketSize;
+	size_t oldest = buckets - decimator.Count();
+	for(size_t spike : spikes) {
+		if(spike / bucketSize < oldest)
+			continue;
+
+		Column column = decimator.ColumnAt(spike / bucketSize - oldest);
+		CHECK(column.min <= points[spike].first);
+		CHECK(column.max >= points[spike].first);
+	}
+}
+
+int
+main()
+{
+	CheckAgainstModel<1>(1, 500);
+	CheckAgainstModel<4>(2, 2000);
+	CheckAgainstModel<64>(3, 5000);
+	CheckAgainstModel<640>(4, 20000);
+	return CheckResult("ColumnDecimatorTest");
+}
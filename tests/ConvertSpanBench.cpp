@@ -0,0 +1,59 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "Check.h"
+#include "TemperatureUtils.h"
+
+#define kRounds 2000
+
+// The sizes the graph converts: its own history and a store tier
+static const size_t kCounts[] = { 1024, 1440 * 3 };
+
+// One ConvertToScale() per value, resolving the conversion every time
+static void
+ConvertEach(const float* in, float* out, size_t count, char from, char to)
+{
+	for(size_t i = 0; i < count; i++)
+		out[i] = ConvertToScale(in[i], from, to);
+}
+
+template<typename Converter>
+static double
+Measure(const std::vector<float>& values, char to, Converter converter)
+{
+	std::vector<float> out(values.size());
+	double start = Now();
+	for(int round = 0; round < kRounds; round++) {
+		converter(values.data(), out.data(), values.size(), SCALE_CELSIUS, to);
+		KeepValue(out[round % out.size()]);
+	}
+
+	return (Now() - start) * 1e9 / kRounds / values.size();
+}
+
+int
+main()
+{
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> readings(20.0f, 100.0f);
+
+	printf("%-8s %-12s %12s %12s %8s\n", "values", "scale", "each ns", "span ns", "speedup");
+	for(size_t count : kCounts) {
+		std::vector<float> values(count);
+		for(float& value : values)
+			value = readings(random);
+
+		for(char to : { SCALE_FAHRENHEIT, SCALE_KELVIN }) {
+			double each = Measure(values, to, ConvertEach);
+			double span = Measure(values, to, ConvertSpan);
+			printf("%-8zu %-12s %12.3f %12.3f %7.1fx\n", count,
+				to == SCALE_FAHRENHEIT ? "fahrenheit" : "kelvin", each, span, each / span);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+#include "Check.h"
+#include "TemperatureUtils.h"
+
+static const char kScales[] = {
+	SCALE_CELSIUS, SCALE_FAHRENHEIT, SCALE_KELVIN, 'x'
+};
+
+static bool
+SameBits(float a, float b)
+{
+	return memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+/*
+ * Converts the values with ConvertSpan, both into another array and in
+ * place, and compares every result bit for bit with ConvertToScale.
+ */
+static void
+CheckSpan(const std::vector<float>& values, size_t offset, char from, char to)
+{
+	size_t count = values.size() - offset;
+	std::vector<float> out(values.size(), -1.0f);
+	ConvertSpan(values.data() + offset, out.data() + offset, count, from, to);
+
+	std::vector<float> inPlace(values);
+	ConvertSpan(inPlace.data() + offset, inPlace.data() + offset, count, from, to);
+
+	for(size_t i = 0; i < offset; i++)
+		CHECK(out[i] == -1.0f && SameBits(inPlace[i], values[i]));
+	for(size_t i = offset; i < values.size(); i++) {
+		float expected = ConvertToScale(values[i], from, to);
+		CHECK(SameBits(out[i], expected));
+		CHECK(SameBits(inPlace[i], expected));
+	}
+}
+
+int
+main()
+{
+	// Sensor readings, the extremes and the special values
+	std::vector<float> values = {
+		0.0f, -0.0f, 1.0f, -1.0f, 25.5f, 100.0f, -273.15f, -459.67f, 273.15f,
+		std::numeric_limits<float>::min(), std::numeric_limits<float>::denorm_min(),
+		std::numeric_limits<float>::max(), std::numeric_limits<float>::lowest(),
+		std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+		std::numeric_limits<float>::quiet_NaN()
+	};
+	std::mt19937 random(1);
+	std::uniform_real_distribution<float> readings(-50.0f, 150.0f);
+	std::uniform_int_distribution<uint32_t> bits;
+	for(int i = 0; i < 1000; i++)
+		values.push_back(readings(random));
+	for(int i = 0; i < 1000; i++) {
+		uint32_t word = bits(random);
+		float value;
+		memcpy(&value, &word, sizeof(value));
+		values.push_back(value);
+	}
+
+	for(char from : kScales) {
+		for(char to : kScales) {
+			// Unaligned starts and lengths that leave a tail for every width
+			for(size_t offset = 0; offset < 9; offset++)
+				CheckSpan(values, offset, from, to);
+			for(size_t length = 0; length < 40; length++)
+				CheckSpan(std::vector<float>(values.begin(), values.begin() + length), 0, from, to);
+		}
+	}
+
+	// Unknown scales yield 0, identity keeps the value
+	float value = 37.0f;
+	ConvertSpan(&value, &value, 1, 'x', SCALE_CELSIUS);
+	CHECK(value == 0.0f);
+	value = 37.0f;
+	ConvertSpan(&value, &value, 1, SCALE_KELVIN, SCALE_KELVIN);
+	CHECK(value == 37.0f);
+
+	// Round trips stay within the float precision
+	for(char from : kScales) {
+		for(char to : kScales) {
+			if(!IsValidScale(from) || !IsValidScale(to))
+				continue;
+			for(int i = 0; i < 1000; i++) {
+				float celsius = readings(random);
+				float there = ConvertToScale(ConvertToScale(celsius, SCALE_CELSIUS, from), from, to);
+				float back = ConvertToScale(there, to, SCALE_CELSIUS);
+				CHECK(std::fabs(back - celsius) < 1e-3f);
+			}
+		}
+	}
+
+	return CheckResult("ConvertSpanTest");
+}
@@ -0,0 +1,322 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "Check.h"
+#include "SampleLog.h"
+
+/*
+ * Writes logs into scratch directories and reads them back the way the
+ * exporter does: the end of the log after a crash, segments rotated at
+ * capacity, and segments compacted into archives past the limit.
+ */
+
+struct Point {
+	int32_t		device;
+	int64_t		when;			// µs, as appended
+	int16_t		centiDegrees;
+};
+
+static const int64_t kStart = 1700000000LL * 1000000;
+
+static std::string
+MakeDirectory()
+{
+	char path[] = "/tmp/SampleLogTest.XXXXXX";
+	CHECK(mkdtemp(path) != NULL);
+	return path;
+}
+
+static void
+RemoveDirectory(const std::string& directory)
+{
+	DIR* dir = opendir(directory.c_str());
+	if(dir == NULL)
+		return;
+
+	while(struct dirent* entry = readdir(dir)) {
+		if(strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+			unlink((directory + "/" + entry->d_name).c_str());
+	}
+	closedir(dir);
+	rmdir(directory.c_str());
+}
+
+static std::string
+NewestSegment(const std::string& directory)
+{
+	char names[kSampleLogMaxSegments * 4][64];
+	int32_t count = SampleLog::ListSegments(directory.c_str(), names,
+		kSampleLogMaxSegments * 4);
+	CHECK(count > 0);
+	return count > 0 ? directory + "/" + names[count - 1] : std::string();
+}
+
+static void
+WriteRecord(const std::string& path, size_t index, uint32_t delta, uint16_t device)
+{
+	SampleLogRecord record;
+	record.delta = delta;
+	record.device = device;
+	record.centiDegrees = 4242;
+
+	int fd = open(path.c_str(), O_RDWR);
+	CHECK(fd >= 0);
+	CHECK(pwrite(fd, &record, sizeof(record),
+		kSampleLogHeaderSize + index * sizeof(record)) == sizeof(record));
+	close(fd);
+}
+
+static void
+CheckCountValid()
+{
+	SampleLogRecord records[8];
+	memset(records, 0, sizeof(records));
+	CHECK(SampleLogSegment::CountValid(records, 8) == 0);
+
+	for(int i = 0; i < 8; i++) {
+		records[i].delta = i * 10;
+		records[i].device = 1;
+	}
+	CHECK(SampleLogSegment::CountValid(records, 8) == 8);
+
+	// Equal times are fine, going back or an unwritten record ends it
+	records[3].delta = records[2].delta;
+	CHECK(SampleLogSegment::CountValid(records, 8) == 8);
+	records[5].delta = records[4].delta - 1;
+	CHECK(SampleLogSegment::CountValid(records, 8) == 5);
+	records[2].device = 0;
+	CHECK(SampleLogSegment::CountValid(records, 8) == 2);
+}
+
+static void
+CheckTornTail()
+{
+	std::string directory = MakeDirectory();
+	{
+		SampleLog log;
+		CHECK(log.Open(directory.c_str(), 64) == 0);
+		CHECK(log.RegisterDevice(0, "/dev/power/acpi_thermal/0") == 0);
+		for(int i = 0; i < 10; i++)
+			CHECK(log.Append(0, kStart + i * 1000000LL, 40.0f + i) == 0);
+	}
+
+	// A crash lost the page of record 10 but wrote a later one
+	std::string path = NewestSegment(directory);
+	WriteRecord(path, 12, 12000, 1);
+	{
+		SampleLogSegment segment;
+		CHECK(segment.Open(path.c_str()) == 0);
+		CHECK(segment.Count() == 10);
+	}
+
+	// Reopening continues after the last good record and wipes the rest
+	{
+		SampleLog log;
+		CHECK(log.Open(directory.c_str(), 64) == 0);
+		CHECK(log.Count() == 10);
+		CHECK(log.Append(0, kStart + 10 * 1000000LL, 50.0f) == 0);
+		CHECK(log.Count() == 11);
+	}
+	{
+		SampleLogSegment segment;
+		CHECK(segment.Open(path.c_str()) == 0);
+		CHECK(segment.Count() == 11);
+		CHECK(segment.TimeAt(10) == kStart + 10 * 1000000LL);
+		CHECK(segment.Records()[10].Temperature() == 50.0f);
+		CHECK(segment.Records()[12].device == 0);
+		CHECK(segment.Header()->deviceCount == 1);
+	}
+
+	// A record going back in time also ends the log
+	WriteRecord(path, 11, 5000, 1);
+	{
+		SampleLog log;
+		CHECK(log.Open(directory.c_str(), 64) == 0);
+		CHECK(log.Count() == 11);
+	}
+
+	RemoveDirectory(directory);
+}
+
+static void
+CheckBackwardsTime()
+{
+	std::string directory = MakeDirectory();
+	{
+		SampleLog log;
+		CHECK(log.Open(directory.c_str(), 64) == 0);
+		CHECK(log.Append(0, kStart, 40.0f) == 0);
+		CHECK(log.Append(0, kStart + 5000000, 41.0f) == 0);
+		// The clock stepped back, but not past the segment start
+		CHECK(log.Append(0, kStart + 3000000, 42.0f) == 0);
+		CHECK(log.Append(0, kStart + 6000000, 43.0f) == 0);
+		CHECK(log.Count() == 4);
+		CHECK(log.Rotations() == 1);
+
+		// Before the segment start, a new segment begins there
+		CHECK(log.Append(0, kStart - 1000000, 44.0f) == 0);
+		CHECK(log.Count() == 1);
+		CHECK(log.Rotations() == 2);
+	}
+
+	int32_t segments = 0;
+	size_t records = 0;
+	SampleLog::ForEachSegment(directory.c_str(), [&](const SampleLogSegment& segment) {
+		segments++;
+		records += segment.Count();
+		if(segment.Count() == 4)
+			CHECK(segment.TimeAt(2) == kStart + 5000000);
+		for(size_t i = 1; i < segment.Count(); i++)
+			CHECK(segment.TimeAt(i) >= segment.TimeAt(i - 1));
+	});
+	CHECK(segments == 2);
+	CHECK(records == 5);
+
+	RemoveDirectory(directory);
+}
+
+static void
+CheckRotation()
+{
+	std::string directory = MakeDirectory();
+	std::vector<Point> points;
+	{
+		SampleLog log;
+		CHECK(log.Open(directory.c_str(), 16, kSampleLogMaxSegments) == 0);
+		for(int i = 0; i < 40; i++) {
+			Point point = { i % 3, kStart + i * 250000LL, static_cast<int16_t>(3000 + i) };
+			CHECK(log.Append(point.device, point.when, point.centiDegrees / 100.0f) == 0);
+			points.push_back(point);
+		}
+		CHECK(log.Rotations() == 3);
+		CHECK(log.Count() == 8);
+	}
+
+	// Full segments and the one in progress, oldest first, nothing lost
+	std::vector<Point> read;
+	std::vector<size_t> counts;
+	SampleLog::ForEachSegment(directory.c_str(), [&](const SampleLogSegment& segment) {
+		CHECK(segment.Header()->capacity == 16);
+		counts.push_back(segment.Count());
+		for(size_t i = 0; i < segment.Count(); i++) {
+			const SampleLogRecord& record = segment.Records()[i];
+			read.push_back({ record.DeviceID(), segment.TimeAt(i), record.centiDegrees });
+		}
+	});
+	CHECK(counts == std::vector<size_t>({ 16, 16, 8 }));
+	CHECK(read.size() == points.size());
+	for(size_t i = 0; i < read.size() && i < points.size(); i++) {
+		CHECK(read[i].device == points[i].device);
+		CHECK(read[i].when == points[i].when);
+		CHECK(read[i].centiDegrees == points[i].centiDegrees);
+	}
+
+	RemoveDirectory(directory);
+}
+
+static void
+CheckArchive()
+{
+	const int32_t kDevices = 3;
+	const int32_t kMaxSegments = 2;
+	std::string directory = MakeDirectory();
+	std::vector<Point> points;
+	{
+		SampleLog log;
+		CHECK(log.Open(directory.c_str(), 32, kMaxSegments) == 0);
+		for(int32_t d = 0; d < kDevices; d++)
+			CHECK(log.RegisterDevice(d, ("/dev/power/thermal/" + std::to_string(d)).c_str()) == 0);
+
+		unsigned seed = 1;
+		int16_t centi[kDevices] = { 3500, 5000, -400 };
+		for(int i = 0; i < 500; i++) {
+			seed = seed * 1103515245 + 12345;
+			int32_t device = (seed >> 16) % kDevices;
+			centi[device] += static_cast<int16_t>((seed >> 8) % 41) - 20;
+			Point point = { device, kStart + i * 100000LL, centi[device] };
+			CHECK(log.Append(point.device, point.when, point.centiDegrees / 100.0f) == 0);
+			points.push_back(point);
+		}
+		// Closing lets the compactor finish its last pass
+	}
+
+	char names[kSampleLogMaxArchives][64];
+	int32_t archives = SampleLog::ListSegments(directory.c_str(), names, kSampleLogMaxArchives,
+		kSampleLogArchiveExtension);
+	char segmentNames[kSampleLogMaxSegments * 4][64];
+	int32_t segments = SampleLog::ListSegments(directory.c_str(), segmentNames,
+		kSampleLogMaxSegments * 4);
+	CHECK(segments == kMaxSegments);
+	CHECK(archives == (500 + 31) / 32 - kMaxSegments);
+
+	// Archives first, then the segments kept, give back every point per device
+	std::vector<Point> read[kDevices];
+	for(int32_t i = 0; i < archives; i++) {
+		SampleLogArchive archive;
+		CHECK(archive.Open((directory + "/" + names[i]).c_str()) == 0);
+		if(archive.Header() == NULL)
+			continue;
+
+		int64_t baseTime = archive.Header()->baseTime;
+		uint32_t total = 0;
+		archive.ForEachChunk([&](int32_t device, uint32_t count, SeriesDecoder& decoder) {
+			CHECK(device >= 0 && device < kDevices);
+			if(device < 0 || device >= kDevices)
+				return;
+
+			int64_t time;
+			int32_t value;
+			uint32_t decoded = 0;
+			while(decoder.Next(&time, &value)) {
+				read[device].push_back({ device, baseTime + time * 1000,
+					static_cast<int16_t>(value) });
+				decoded++;
+			}
+			CHECK(decoded == count);
+			total += decoded;
+		});
+		CHECK(total == archive.Header()->capacity);
+	}
+	SampleLog::ForEachSegment(directory.c_str(), [&](const SampleLogSegment& segment) {
+		for(size_t i = 0; i < segment.Count(); i++) {
+			const SampleLogRecord& record = segment.Records()[i];
+			read[record.DeviceID()].push_back({ record.DeviceID(), segment.TimeAt(i),
+				record.centiDegrees });
+		}
+	});
+
+	for(int32_t d = 0; d < kDevices; d++) {
+		std::vector<Point> expected;
+		for(const Point& point : points) {
+			if(point.device == d)
+				expected.push_back(point);
+		}
+
+		CHECK(read[d].size() == expected.size());
+		for(size_t i = 0; i < read[d].size() && i < expected.size(); i++) {
+			CHECK(read[d][i].when == expected[i].when);
+			CHECK(read[d][i].centiDegrees == expected[i].centiDegrees);
+		}
+	}
+
+	RemoveDirectory(directory);
+}
+
+int
+main()
+{
+	CheckCountValid();
+	CheckTornTail();
+	CheckBackwardsTime();
+	CheckRotation();
+	CheckArchive();
+	return CheckResult("SampleLogTest");
+}
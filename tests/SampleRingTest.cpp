@@ -0,0 +1,80 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <algorithm>
+#include <deque>
+#include <random>
+#include <vector>
+#include "Check.h"
+#include "SampleRing.h"
+
+/*
+ * Drives a ring and a std::deque trimmed to the same capacity with the
+ * same random operations, and compares every way of reading the ring.
+ */
+template<size_t N>
+static void
+CheckAgainstModel(unsigned seed, int operations)
+{
+	SampleRing<int, N> ring;
+	std::deque<int> model;
+	std::mt19937 random(seed);
+
+	for(int operation = 0; operation < operations; operation++) {
+		unsigned choice = random() % 64;
+		if(choice == 0) {
+			ring.MakeEmpty();
+			model.clear();
+		}
+		else if(choice == 1 && !model.empty()) {
+			ring.LastItem() = -operation;
+			model.back() = -operation;
+		}
+		else {
+			ring.Push(operation);
+			model.push_back(operation);
+			if(model.size() > N)
+				model.pop_front();
+		}
+
+		CHECK(ring.Count() == model.size());
+		CHECK(ring.IsEmpty() == model.empty());
+		CHECK(ring.Capacity() == N);
+		CHECK(ring.Last(-1) == (model.empty() ? -1 : model.back()));
+		for(size_t i = 0; i < model.size(); i++)
+			CHECK(ring.ItemAt(i) == model[i]);
+		CHECK(ring.ItemAt(model.size(), 12345) == 12345);
+		CHECK(ring.ItemAt((size_t)-1, 12345) == 12345);
+
+		// The spans cover the items in order, within the storage
+		typename SampleRing<int, N>::Span first, second;
+		ring.GetSpans(&first, &second);
+		CHECK(first.count + second.count == model.size());
+		CHECK(first.count <= N && second.count <= N);
+		std::vector<int> walked(first.items, first.items + first.count);
+		walked.insert(walked.end(), second.items, second.items + second.count);
+		CHECK(std::equal(walked.begin(), walked.end(), model.begin(), model.end()));
+
+		size_t last = random() % (N + 3);
+		size_t expected = last < model.size() ? last : model.size();
+		size_t visited = 0;
+		ring.ForEachLast(last, [&](size_t index, const int& item) {
+			CHECK(index == visited);
+			CHECK(item == model[model.size() - expected + index]);
+			visited++;
+		});
+		CHECK(visited == expected);
+	}
+}
+
+int
+main()
+{
+	CheckAgainstModel<1>(1, 200);
+	CheckAgainstModel<2>(2, 500);
+	CheckAgainstModel<7>(3, 2000);
+	CheckAgainstModel<64>(4, 5000);
+	CheckAgainstModel<1000>(5, 5000);
+	return CheckResult("SampleRingTest");
+}
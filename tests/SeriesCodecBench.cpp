@@ -0,0 +1,93 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "Check.h"
+#include "SeriesCodec.h"
+
+#define kPoints 1000000
+#define kRounds 20
+
+/*
+ * Series shaped like the sample log's: milliseconds and centi-degrees,
+ * one sample a second with the given read jitter and value noise.
+ */
+static void
+MakeSeries(int jitter, int noise, std::vector<int64_t>* outTimes,
+	std::vector<int32_t>* outValues)
+{
+	std::mt19937 random(1);
+	outTimes->resize(kPoints);
+	outValues->resize(kPoints);
+
+	int64_t time = 1700000000000LL;
+	int32_t value = 4500;
+	for(size_t i = 0; i < kPoints; i++) {
+		time += 1000 + (jitter > 0 ? static_cast<int>(random() % (2 * jitter + 1)) - jitter : 0);
+		if(noise > 0 && random() % 4 == 0)
+			value += static_cast<int>(random() % (2 * noise + 1)) - noise;
+		(*outTimes)[i] = time;
+		(*outValues)[i] = value;
+	}
+}
+
+int
+main()
+{
+	struct {
+		const char*	name;
+		int			jitter;
+		int			noise;
+	} shapes[] = {
+		{ "steady", 0, 0 },
+		{ "drifting", 0, 10 },
+		{ "jittery", 3, 10 },
+		{ "noisy", 50, 200 }
+	};
+
+	std::vector<uint8_t> buffer(kPoints * kSeriesMaxPointBytes + 64);
+	std::vector<int64_t> decodedTimes(kPoints);
+	std::vector<int32_t> decodedValues(kPoints);
+
+	printf("%-10s %12s %16s %16s\n", "series", "bytes/point", "encode Mpoints/s",
+		"decode Mpoints/s");
+	for(const auto& shape : shapes) {
+		std::vector<int64_t> times;
+		std::vector<int32_t> values;
+		MakeSeries(shape.jitter, shape.noise, &times, &values);
+
+		size_t size = 0;
+		double start = Now();
+		for(int round = 0; round < kRounds; round++) {
+			SeriesEncoder encoder(buffer.data(), buffer.size());
+			for(size_t i = 0; i < kPoints; i++)
+				encoder.Append(times[i], values[i]);
+			size = encoder.Finish();
+			KeepValue(buffer[size / 2]);
+		}
+		double encode = (Now() - start) / kRounds;
+
+		size_t count = 0;
+		start = Now();
+		for(int round = 0; round < kRounds; round++) {
+			SeriesDecoder decoder(buffer.data(), size);
+			count = decoder.Decode(decodedTimes.data(), decodedValues.data(), kPoints);
+			KeepValue(decodedValues[count / 2]);
+		}
+		double decode = (Now() - start) / kRounds;
+
+		if(count != kPoints || decodedTimes != times || decodedValues != values) {
+			fprintf(stderr, "%s: the series did not round trip\n", shape.name);
+			return 1;
+		}
+
+		printf("%-10s %12.3f %16.1f %16.1f\n", shape.name, double(size) / kPoints,
+			kPoints / encode / 1e6, kPoints / decode / 1e6);
+	}
+
+	return 0;
+}
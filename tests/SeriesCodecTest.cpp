@@ -0,0 +1,179 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+#include "Check.h"
+#include "SeriesCodec.h"
+
+struct Point {
+	int64_t	time;
+	int32_t	value;
+};
+
+typedef std::vector<Point> Series;
+
+static std::vector<uint8_t>
+Encode(const Series& series)
+{
+	std::vector<uint8_t> buffer(series.size() * kSeriesMaxPointBytes + 64);
+	SeriesEncoder encoder(buffer.data(), buffer.size());
+	for(const Point& point : series)
+		CHECK(encoder.Append(point.time, point.value));
+	CHECK(encoder.Count() == series.size());
+
+	buffer.resize(encoder.Finish());
+	return buffer;
+}
+
+// Decodes the bytes and checks that they give back the series exactly
+static void
+CheckRoundTrip(const Series& series)
+{
+	std::vector<uint8_t> bytes = Encode(series);
+	SeriesDecoder decoder(bytes.data(), bytes.size());
+
+	Point point;
+	size_t count = 0;
+	while(decoder.Next(&point.time, &point.value)) {
+		CHECK(count < series.size());
+		if(count >= series.size())
+			return;
+		CHECK(point.time == series[count].time);
+		CHECK(point.value == series[count].value);
+		count++;
+	}
+	CHECK(count == series.size());
+	CHECK(decoder.IsAtEnd());
+
+	// Any prefix of the bytes decodes to a prefix of the series
+	for(size_t length = 0; length < bytes.size(); length += 1 + length / 8) {
+		SeriesDecoder truncated(bytes.data(), length);
+		size_t decoded = 0;
+		while(truncated.Next(&point.time, &point.value) && decoded < series.size()) {
+			CHECK(point.time == series[decoded].time);
+			CHECK(point.value == series[decoded].value);
+			decoded++;
+		}
+		CHECK(decoded <= count);
+	}
+}
+
+/*
+ * Random series mixing the shapes the sample log sees: steady stretches
+ * that become runs, drift, a jittery period and sudden jumps.
+ */
+static Series
+RandomSeries(std::mt19937& random, size_t count)
+{
+	Series series;
+	int64_t time = static_cast<int64_t>(random()) - (1LL << 31);
+	int64_t period = 1 + random() % 2000;
+	int32_t value = static_cast<int32_t>(random() % 20000) - 5000;
+	while(series.size() < count) {
+		unsigned shape = random() % 4;
+		size_t length = 1 + random() % 200;
+		for(size_t i = 0; i < length && series.size() < count; i++) {
+			if(shape == 1)
+				value += static_cast<int32_t>(random() % 5) - 2;
+			else if(shape == 2)
+				time += static_cast<int64_t>(random() % 21) - 10;
+			else if(shape == 3) {
+				period = static_cast<int64_t>(random() % 100000) - 1000;
+				value = static_cast<int32_t>(random());
+			}
+			time += period;
+			series.push_back({ time, value });
+		}
+	}
+
+	return series;
+}
+
+int
+main()
+{
+	using namespace SeriesCodecPrivate;
+
+	// Zig-zag maps small magnitudes to small codes and round trips all
+	const int64_t extremes[] = {
+		0, 1, -1, 2, -2, 63, -64, std::numeric_limits<int32_t>::max(),
+		std::numeric_limits<int32_t>::min(), std::numeric_limits<int64_t>::max(),
+		std::numeric_limits<int64_t>::min()
+	};
+	for(int64_t value : extremes) {
+		CHECK(UnZigZag(ZigZag(value)) == value);
+		uint8_t buffer[10];
+		size_t length = PutVarint(buffer, ZigZag(value));
+		const uint8_t* cursor = buffer;
+		uint64_t decoded = 0;
+		CHECK(GetVarint(&cursor, buffer + length, &decoded) && cursor == buffer + length);
+		CHECK(UnZigZag(decoded) == value);
+	}
+	CHECK(ZigZag(-1) == 1 && ZigZag(1) == 2);
+	CHECK(ZigZag(std::numeric_limits<int64_t>::min()) == std::numeric_limits<uint64_t>::max());
+
+	// The empty series is no bytes, and no bytes are no points
+	std::vector<uint8_t> empty = Encode(Series());
+	CHECK(empty.empty());
+	SeriesDecoder emptyDecoder(NULL, 0);
+	Point point;
+	CHECK(!emptyDecoder.Next(&point.time, &point.value));
+	CHECK(emptyDecoder.IsAtEnd());
+
+	CheckRoundTrip({ { 12345, -7 } });
+
+	// A steady series is one run token after the first point
+	Series steady;
+	for(int64_t i = 0; i < 100000; i++)
+		steady.push_back({ 1000 + i * 1000, 4250 });
+	CheckRoundTrip(steady);
+	std::vector<uint8_t> steadyBytes = Encode(steady);
+	CHECK(steadyBytes.size() <= 10 + 10 + 5);
+
+	// Runs broken by changes of either kind, and of both
+	Series broken;
+	int64_t time = 0;
+	for(int i = 0; i < 1000; i++) {
+		time += i % 100 == 50 ? 1500 : 1000;
+		broken.push_back({ time, i % 70 == 0 ? i : 42 });
+	}
+	CheckRoundTrip(broken);
+
+	// Values swinging between the int32 extremes, times jumping far
+	Series swinging;
+	time = std::numeric_limits<int64_t>::min() / 4;
+	for(int i = 0; i < 200; i++) {
+		time += (i % 3 == 0) ? (1LL << 40) : 1;
+		swinging.push_back({ time, (i & 1) ? std::numeric_limits<int32_t>::max()
+			: std::numeric_limits<int32_t>::min() });
+	}
+	CheckRoundTrip(swinging);
+
+	std::mt19937 random(1);
+	for(int round = 0; round < 200; round++)
+		CheckRoundTrip(RandomSeries(random, 1 + random() % 3000));
+
+	// A full buffer refuses points, what was accepted still decodes
+	uint8_t small[64];
+	SeriesEncoder encoder(small, sizeof(small));
+	Series accepted;
+	for(const Point& point : RandomSeries(random, 100)) {
+		if(!encoder.Append(point.time, point.value))
+			break;
+		accepted.push_back(point);
+	}
+	CHECK(accepted.size() < 100);
+	SeriesDecoder decoder(small, encoder.Finish());
+	size_t count = 0;
+	while(decoder.Next(&point.time, &point.value) && count < accepted.size()) {
+		CHECK(point.time == accepted[count].time && point.value == accepted[count].value);
+		count++;
+	}
+	CHECK(count == accepted.size() && decoder.IsAtEnd());
+
+	return CheckResult("SeriesCodecTest");
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Check.h"
+#include "ThermalParser.h"
+#include "ThermalReports.h"
+
+#define kRounds 200000
+
+/*
+ * What ThermalDevice::ParseData did before the parser: copy the report
+ * into a heap buffer, split it into a list of strings and scan each of
+ * them with a format. BString::Split() and ScanWithFormat() are a string
+ * list and vsscanf() underneath, std::string and sscanf() stand in for
+ * them so this also runs off Haiku.
+ */
+static void
+ParseWithScan(const char* data, size_t length, float* outTemperatures)
+{
+	char* buffer = new char[length + 1];
+	memcpy(buffer, data, length);
+	buffer[length] = '\0';
+
+	std::vector<std::string> lines;
+	std::string report(buffer);
+	for(size_t start = 0; start < report.size();) {
+		size_t end = report.find('\n', start);
+		if(end == std::string::npos)
+			end = report.size();
+		if(end > start)
+			lines.push_back(report.substr(start, end - start));
+		start = end + 1;
+	}
+
+	float temperature = 0.0f;
+	for(const std::string& line : lines) {
+		if(strstr(line.c_str(), "Current") != NULL) {
+			sscanf(line.c_str(), "  Current Temperature: %f C\n", &temperature);
+			outTemperatures[0] = temperature;
+		}
+		else if(strstr(line.c_str(), "Critical") != NULL) {
+			sscanf(line.c_str(), "  Critical Temperature: %f C\n", &temperature);
+			outTemperatures[1] = temperature;
+		}
+		else if(strstr(line.c_str(), "Hot") != NULL) {
+			sscanf(line.c_str(), "  Hot Temperature: %f C\n", &temperature);
+			outTemperatures[2] = temperature;
+		}
+	}
+
+	delete[] buffer;
+}
+
+static void
+ParseInPlace(const char* data, size_t length, float* outTemperatures)
+{
+	ParseThermalReport(data, length, [outTemperatures](const ThermalReportEntry& entry) {
+		if(ThermalReportKeyIs(entry, "Current"))
+			outTemperatures[0] = entry.value;
+		else if(ThermalReportKeyIs(entry, "Critical"))
+			outTemperatures[1] = entry.value;
+		else if(ThermalReportKeyIs(entry, "Hot"))
+			outTemperatures[2] = entry.value;
+	});
+}
+
+template<typename Parser>
+static double
+Measure(const ThermalReport& report, Parser parser)
+{
+	size_t length = strlen(report.text);
+	float temperatures[3] = {};
+	double start = Now();
+	for(int round = 0; round < kRounds; round++) {
+		parser(report.text, length, temperatures);
+		KeepValue(temperatures);
+	}
+
+	return (Now() - start) * 1e9 / kRounds;
+}
+
+int
+main()
+{
+	printf("%-32s %12s %12s %8s\n", "report", "scan ns", "parser ns", "speedup");
+	for(int i = 0; i < kThermalReportCount; i++) {
+		const ThermalReport& report = kThermalReports[i];
+		double scan = Measure(report, ParseWithScan);
+		double inPlace = Measure(report, ParseInPlace);
+		printf("%-32s %12.1f %12.1f %7.1fx\n", report.name, scan, inPlace, scan / inPlace);
+	}
+
+	return 0;
+}
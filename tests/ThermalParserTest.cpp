@@ -0,0 +1,68 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#include <cmath>
+#include <cstring>
+#include "Check.h"
+#include "ThermalParser.h"
+#include "ThermalReports.h"
+
+// Parses a heap copy of exactly length bytes, so that reading past the
+//	span is caught by the sanitizers.
+static size_t
+Parse(const char* text, size_t length, float* outCurrent)
+{
+	char* copy = new char[length > 0 ? length : 1];
+	memcpy(copy, text, length);
+	*outCurrent = 0.0f;
+	size_t found = ParseThermalReport(copy, length, [outCurrent](const ThermalReportEntry& entry) {
+		if(ThermalReportKeyIs(entry, "Current"))
+			*outCurrent = entry.value;
+	});
+	delete[] copy;
+	return found;
+}
+
+int
+main()
+{
+	for(int i = 0; i < kThermalReportCount; i++) {
+		const ThermalReport& report = kThermalReports[i];
+		float current;
+		CHECK(Parse(report.text, strlen(report.text), &current) == (size_t)report.entries);
+		CHECK(current == report.current);
+
+		// Every truncation must be safe, and never find more lines
+		for(size_t length = 0; length < strlen(report.text); length++)
+			CHECK(Parse(report.text, length, &current) <= (size_t)report.entries);
+	}
+
+	// Keys are whatever precedes "Temperature", blanks trimmed
+	const char* report = "\tCPU Package  Temperature : +51.25 C";
+	ThermalReportEntry found = {};
+	CHECK(ParseThermalReport(report, strlen(report), [&found](const ThermalReportEntry& entry) {
+		found = entry;
+	}) == 1);
+	CHECK(found.keyLength == strlen("CPU Package"));
+	CHECK(ThermalReportKeyIs(found, "CPU Package"));
+	CHECK(!ThermalReportKeyIs(found, "CPU"));
+	CHECK(fabsf(found.value - 51.25f) < 1e-5f);
+
+	// Lines the driver never writes are skipped
+	const char* malformed[] = {
+		"Temperature: 40.0 C",			// no key
+		"  Current Temperature 40.0 C",	// no colon
+		"  Current Temperature: 40.0",	// no unit
+		"  Current Temperature: . C",	// no digits
+		"  Current Temperature: 40.0 K",
+		""
+	};
+	for(const char* line : malformed) {
+		float current;
+		CHECK(Parse(line, strlen(line), &current) == 0);
+	}
+
+	CHECK(ParseThermalReport(NULL, 10, [](const ThermalReportEntry&) {}) == 0);
+	return CheckResult("ThermalParserTest");
+}
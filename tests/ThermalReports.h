@@ -0,0 +1,49 @@
+/*
+ * Copyright 2025, cafeina, <cafeina@world>. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef __THERMAL_REPORTS__
+#define __THERMAL_REPORTS__
+
+/*
+ * Reports as the thermal drivers write them, shared by the parser test,
+ * its benchmark and the seed corpus of the fuzzer.
+ */
+
+struct ThermalReport {
+	const char*	name;
+	const char*	text;
+	int			entries;	// temperature lines in text
+	float		current;	// reported current temperature, or 0
+};
+
+static const ThermalReport kThermalReports[] = {
+	{ "acpi_thermal",
+		"ACPI Thermal Device 0\n"
+		"  Critical Temperature: 105.0 C\n"
+		"  Current Temperature: 47.5 C\n",
+		2, 47.5f },
+	{ "acpi_thermal with trip points",
+		"ACPI Thermal Device 1\n"
+		"  Critical Temperature: 98.0 C\n"
+		"  Current Temperature: 61.8 C\n"
+		"  Hot Temperature: 93.0 C\n"
+		"  Passive Temperature: 85.0 C\n"
+		"  Active Cooling: 2 levels\n",
+		4, 61.8f },
+	{ "pch_thermal",
+		"  Current Temperature: 39.0 C\n",
+		1, 39.0f },
+	{ "below zero",
+		"  Critical Temperature: 85.00 C\r\n"
+		"  Current Temperature: -4.25 C\r\n",
+		2, -4.25f },
+	{ "no temperature",
+		"ACPI Thermal Device 2\n"
+		"  Current Temperature: unknown\n",
+		0, 0.0f }
+};
+
+static const int kThermalReportCount = sizeof(kThermalReports) / sizeof(kThermalReports[0]);
+
+#endif /* __THERMAL_REPORTS__ */